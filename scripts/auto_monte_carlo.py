@@ -0,0 +1,127 @@
+import argparse
+import concurrent.futures
+import json
+import math
+import os
+import subprocess
+
+parser = argparse.ArgumentParser("Auto Monte-Carlo", description="Run autos many times in the headless simulator with randomised robots and report how robust they are")
+parser.add_argument("--sim", default="build/install/headlessSim/linuxx86-64/release/headlessSim", help="Path to the headlessSim executable")
+parser.add_argument("--auto", action="append", dest="autos", help="Auto to evaluate, may be repeated. Default: every auto")
+parser.add_argument("--runs", type=int, default=200, help="Randomised runs per auto. Default: 200")
+parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="Simulations run at once. Default: all cores")
+parser.add_argument("--timeout", type=float, default=15, help="Sim time before a run counts as failed. Default: 15")
+parser.add_argument("--tolerance", type=float, default=0.1, help="Final position error (m) from the ideal run before a run counts as failed. Default: 0.1")
+parser.add_argument("--out", help="Write every run and the report as JSON to this path")
+
+# Variation, passed straight through to headlessSim
+VARIATION = {
+  "start-position-error": 0.05,
+  "start-heading-error": 2.0,
+  "motor-error": 0.05,
+  "mass-error": 0.1,
+  "wheel-slip": 0.03,
+  "battery-resistance-error": 0.3,
+  "encoder-noise": 0.002,
+  "gyro-noise": 0.2,
+  "gyro-rate-noise": 0.5,
+  "gyro-bias": 0.05,
+  "gyro-drift": 0.01,
+}
+for name, default in VARIATION.items():
+  parser.add_argument("--" + name, type=float, default=default, help="Default: {}".format(default))
+
+
+def run(sim, auto, seed, timeout, variation):
+  """
+  Run one simulation, with no variation if seed is None. Each simulation is its own
+  process, as there is one HAL per process.
+  """
+  cmd = [sim, "--auto", auto, "--timeout", str(timeout), "--json"]
+  if seed is not None:
+    cmd += ["--seed", str(seed)]
+    for name, value in variation.items():
+      cmd += ["--" + name, str(value)]
+
+  proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+  # The robot code logs to stdout too, the summary is the last JSON line
+  for line in reversed(proc.stdout.splitlines()):
+    if line.startswith("{"):
+      return json.loads(line)
+  raise RuntimeError("{} (seed {}) produced no summary, exit code {}".format(auto, seed, proc.returncode))
+
+
+def percentile(values, p):
+  if not values:
+    return float("nan")
+  values = sorted(values)
+  k = (len(values) - 1) * p / 100
+  lo, hi = math.floor(k), math.ceil(k)
+  return values[lo] + (values[hi] - values[lo]) * (k - lo)
+
+
+def pose_error(a, b):
+  return math.hypot(a[0] - b[0], a[1] - b[1]), abs(math.remainder(a[2] - b[2], 360))
+
+
+def report(auto, ideal, runs, tolerance):
+  times, errors, heading_errors, estimate_errors, currents = [], [], [], [], []
+  failures = 0
+  for r in runs:
+    error, heading_error = pose_error(r["finalPose"], ideal["finalPose"])
+    estimate_error, _ = pose_error(r["finalPose"], r["finalEstimatedPose"])
+    if r["result"] != "done" or error > tolerance:
+      failures += 1
+    if r["result"] == "done":
+      times.append(r["simTime"])
+    errors.append(error)
+    heading_errors.append(heading_error)
+    estimate_errors.append(estimate_error)
+    currents.append(r["peakCurrent"])
+
+  def stats(values):
+    return { "p50": percentile(values, 50), "p90": percentile(values, 90), "p99": percentile(values, 99), "max": max(values) if values else float("nan") }
+
+  return {
+    "auto": auto,
+    "runs": len(runs),
+    "failureRate": failures / len(runs) if runs else float("nan"),
+    "idealTime": ideal["simTime"],
+    "completionTime": stats(times),
+    "finalPositionError": stats(errors),
+    "finalHeadingError": stats(heading_errors),
+    "estimateError": stats(estimate_errors),
+    "peakCurrent": stats(currents),
+  }
+
+
+def print_report(r):
+  print("{}: {} runs, {:.1%} failed, ideal {:.2f}s".format(r["auto"], r["runs"], r["failureRate"], r["idealTime"]))
+  for key, unit in [("completionTime", "s"), ("finalPositionError", "m"), ("finalHeadingError", "deg"), ("estimateError", "m"), ("peakCurrent", "A")]:
+    s = r[key]
+    print("  {:<20} p50 {:8.3f}  p90 {:8.3f}  p99 {:8.3f}  max {:8.3f} {}".format(key, s["p50"], s["p90"], s["p99"], s["max"], unit))
+
+
+if __name__ == "__main__":
+  args = parser.parse_args()
+  variation = { name: getattr(args, name.replace("-", "_")) for name in VARIATION }
+
+  autos = args.autos
+  if not autos:
+    autos = subprocess.run([args.sim, "--list"], stdout=subprocess.PIPE, text=True, check=True).stdout.split()
+
+  with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+    ideal = { auto: pool.submit(run, args.sim, auto, None, args.timeout, variation) for auto in autos }
+    futures = { auto: [pool.submit(run, args.sim, auto, seed, args.timeout, variation) for seed in range(1, args.runs + 1)] for auto in autos }
+
+    reports, results = [], {}
+    for auto in autos:
+      runs = [f.result() for f in futures[auto]]
+      results[auto] = runs
+      r = report(auto, ideal[auto].result(), runs, args.tolerance)
+      reports.append(r)
+      print_report(r)
+
+  if args.out:
+    with open(args.out, "w") as f:
+      json.dump({ "variation": variation, "reports": reports, "runs": results }, f, indent=2)
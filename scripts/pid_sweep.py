@@ -0,0 +1,140 @@
+import argparse
+import concurrent.futures
+import itertools
+import json
+import math
+import os
+import random
+import subprocess
+
+parser = argparse.ArgumentParser("PID Sweep", description="Rank PID gains by their simulated step response in the headless simulator")
+parser.add_argument("--sim", default="build/install/headlessSim/linuxx86-64/release/headlessSim", help="Path to the headlessSim executable")
+parser.add_argument("--step", nargs=3, type=float, default=[0, 0, 90], metavar=("X", "Y", "HEADING"), help="Pose step in metres and degrees. Default: 0 0 90 (heading)")
+parser.add_argument("--balance", type=float, metavar="OFFSET", help="Instead of a step, start OFFSET metres from the charge station's hinge and rank by time to balance, e.g. for balancePID")
+parser.add_argument("--gain", action="append", default=[], metavar="TOPIC=V1,V2,...|TOPIC=MIN:MAX",
+  help="Gain to sweep by NT topic, e.g. /drivetrain/pid/pose/angle/config/kP=2,4,6. A MIN:MAX range is sampled by --random. May be repeated.")
+parser.add_argument("--random", type=int, default=0, help="Sample this many random gain sets instead of the full grid")
+parser.add_argument("--seed", type=int, default=0, help="Seed for --random. Default: 0")
+parser.add_argument("--duration", type=float, default=5, help="Sim time of each step response. Default: 5")
+parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="Simulations run at once. Default: all cores")
+parser.add_argument("--overshoot-weight", type=float, default=2, help="Seconds of settling time one whole step of overshoot is worth. Default: 2")
+parser.add_argument("--oscillation-weight", type=float, default=0.5, help="Seconds of time to balance one oscillation of the charge station is worth. Default: 0.5")
+parser.add_argument("--current-weight", type=float, default=0.005, help="Seconds of settling time one amp of peak current is worth. Default: 0.005")
+parser.add_argument("--top", type=int, default=10, help="Number of gain sets to print. Default: 10")
+parser.add_argument("--out", help="Write every result as JSON to this path")
+
+# PID loops on the robot, for reference. Gains are kP, kI, kD under each.
+KNOWN = {
+  "poseAnglePID": "/drivetrain/pid/pose/angle/config",
+  "posePositionPID": "/drivetrain/pid/pose/position/config",
+  "balancePID": "/swerve/balancePID",
+}
+
+
+def parse_gains(specs):
+  """
+  Returns { topic: [values] } for grid gains and { topic: (min, max) } for ranges.
+  """
+  grid, ranges = {}, {}
+  for spec in specs:
+    topic, values = spec.split("=", 1)
+    for name, path in KNOWN.items():
+      if topic.startswith(name + "/"):
+        topic = path + topic[len(name):]
+    if ":" in values:
+      lo, hi = values.split(":")
+      ranges[topic] = (float(lo), float(hi))
+    else:
+      grid[topic] = [float(v) for v in values.split(",")]
+  return grid, ranges
+
+
+def label(topic):
+  for name, path in KNOWN.items():
+    if topic.startswith(path + "/"):
+      return name + topic[len(path):]
+  return topic
+
+
+def candidates(grid, ranges, count, seed):
+  if count > 0:
+    rng = random.Random(seed)
+    for _ in range(count):
+      gains = { topic: rng.choice(values) for topic, values in grid.items() }
+      # Gains vary over orders of magnitude, so sample ranges log-uniformly when we can
+      for topic, (lo, hi) in ranges.items():
+        gains[topic] = math.exp(rng.uniform(math.log(lo), math.log(hi))) if lo > 0 else rng.uniform(lo, hi)
+      yield gains
+  else:
+    if ranges:
+      raise ValueError("MIN:MAX ranges need --random")
+    topics = list(grid.keys())
+    for values in itertools.product(*[grid[t] for t in topics]):
+      yield dict(zip(topics, values))
+
+
+def run(sim, step, balance, duration, gains):
+  if balance is not None:
+    cmd = [sim, "--balance", str(balance)]
+  else:
+    cmd = [sim, "--step"] + [str(v) for v in step]
+  cmd += ["--timeout", str(duration), "--json"]
+  for topic, value in gains.items():
+    cmd += ["--set", "{}={}".format(topic, value)]
+
+  proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+  for line in reversed(proc.stdout.splitlines()):
+    if line.startswith("{"):
+      return json.loads(line)
+  raise RuntimeError("{} produced no summary, exit code {}: {}".format(gains, proc.returncode, proc.stderr.strip()))
+
+
+def settling_time(result):
+  return result["timeToBalance"] if "timeToBalance" in result else result["settlingTime"]
+
+
+def score(result, duration, args):
+  # Never settling is as bad as settling at the very end
+  settling = settling_time(result)
+  if settling is None:
+    settling = 2 * duration
+  if "timeToBalance" in result:
+    penalty = args.oscillation_weight * result["oscillations"]
+  else:
+    penalty = args.overshoot_weight * result["overshoot"]
+  return settling + penalty + args.current_weight * result["peakCurrent"]
+
+
+if __name__ == "__main__":
+  args = parser.parse_args()
+  grid, ranges = parse_gains(args.gain)
+  if not grid and not ranges:
+    parser.error("at least one --gain is required, e.g. --gain poseAnglePID/kP=2,4,6")
+
+  gain_sets = list(candidates(grid, ranges, args.random, args.seed))
+  print("Running {} {} on {} workers".format(len(gain_sets), "balances" if args.balance is not None else "step responses", args.jobs))
+
+  with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+    results = list(pool.map(lambda g: run(args.sim, args.step, args.balance, args.duration, g), gain_sets))
+
+  ranked = sorted(
+    [
+      { "gains": g, "score": score(r, args.duration, args),
+        "settlingTime": settling_time(r), "overshoot": r.get("overshoot"), "oscillations": r.get("oscillations"), "peakCurrent": r["peakCurrent"] }
+      for g, r in zip(gain_sets, results)
+    ],
+    key=lambda r: r["score"]
+  )
+
+  for r in ranked[:args.top]:
+    settling = "{:.2f}s".format(r["settlingTime"]) if r["settlingTime"] is not None else "never"
+    gains = "  ".join("{}={:.4g}".format(label(t), v) for t, v in r["gains"].items())
+    if r["oscillations"] is not None:
+      penalty = "oscillations {:3d}".format(r["oscillations"])
+    else:
+      penalty = "overshoot {:5.1%}".format(r["overshoot"])
+    print("score {:7.3f}  settle {:>7}  {}  peak {:6.1f}A  {}".format(r["score"], settling, penalty, r["peakCurrent"], gains))
+
+  if args.out:
+    with open(args.out, "w") as f:
+      json.dump({ "step": args.step, "balance": args.balance, "duration": args.duration, "results": ranked }, f, indent=2)
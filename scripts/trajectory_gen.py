@@ -0,0 +1,176 @@
+import argparse
+import bisect
+import json
+import math
+import os
+import struct
+
+parser = argparse.ArgumentParser("Trajectory Generator", description="Generate holonomic trajectories for wom::HolonomicTrajectory")
+parser.add_argument("--spec", default="scripts/trajectories.json", help="Trajectory specification. Default: scripts/trajectories.json")
+parser.add_argument("--out", default="src/main/deploy/trajectories", help="Output directory. Default: src/main/deploy/trajectories")
+
+# Must match wom::HolonomicTrajectory
+MAGIC = b"WTRJ"
+VERSION = 1
+HEADER = struct.Struct("<4sIIf")
+SAMPLE = struct.Struct("<9f")
+
+POINTS_PER_SEGMENT = 200
+
+
+def hermite(p0, p1, m0, m1, t):
+  t2, t3 = t * t, t * t * t
+  h00 = 2 * t3 - 3 * t2 + 1
+  h10 = t3 - 2 * t2 + t
+  h01 = -2 * t3 + 3 * t2
+  h11 = t3 - t2
+  return [h00 * p0[i] + h10 * m0[i] + h01 * p1[i] + h11 * m1[i] for i in range(2)]
+
+
+def unwrap(angles):
+  out = [angles[0]]
+  for a in angles[1:]:
+    d = math.remainder(a - out[-1], 2 * math.pi)
+    out.append(out[-1] + d)
+  return out
+
+
+def build_path(waypoints):
+  """
+  Densely sample a Catmull-Rom spline through the waypoints, which has zero
+  tangent at the ends. Returns (x, y, heading, s) lists, heading interpolated along
+  the arc length between waypoints.
+  """
+  pts = [(w[0], w[1]) for w in waypoints]
+  headings = unwrap([math.radians(w[2]) for w in waypoints])
+
+  tangents = []
+  for i in range(len(pts)):
+    if i == 0 or i == len(pts) - 1:
+      tangents.append((0.0, 0.0))
+    else:
+      tangents.append(((pts[i + 1][0] - pts[i - 1][0]) / 2, (pts[i + 1][1] - pts[i - 1][1]) / 2))
+
+  xs, ys, seg_idx, seg_t = [], [], [], []
+  for i in range(len(pts) - 1):
+    for k in range(POINTS_PER_SEGMENT):
+      t = k / POINTS_PER_SEGMENT
+      p = hermite(pts[i], pts[i + 1], tangents[i], tangents[i + 1], t)
+      xs.append(p[0]); ys.append(p[1]); seg_idx.append(i); seg_t.append(t)
+  xs.append(pts[-1][0]); ys.append(pts[-1][1]); seg_idx.append(len(pts) - 2); seg_t.append(1.0)
+
+  s = [0.0]
+  for i in range(1, len(xs)):
+    s.append(s[-1] + math.hypot(xs[i] - xs[i - 1], ys[i] - ys[i - 1]))
+
+  # Heading varies linearly with distance along each segment
+  seg_start = {}
+  seg_end = {}
+  for i in range(len(xs)):
+    seg_start.setdefault(seg_idx[i], s[i])
+    seg_end[seg_idx[i]] = s[i]
+  hs = []
+  for i in range(len(xs)):
+    j = seg_idx[i]
+    length = seg_end[j] - seg_start[j]
+    f = (s[i] - seg_start[j]) / length if length > 1e-9 else seg_t[i]
+    hs.append(headings[j] + (headings[j + 1] - headings[j]) * f)
+
+  return xs, ys, hs, s
+
+
+def profile(xs, ys, hs, s, cfg):
+  """
+  Velocity along the path, limited by max velocity, centripetal acceleration,
+  heading rate and max acceleration (forward / backward passes).
+  """
+  n = len(s)
+  vmax = [cfg["maxVelocity"]] * n
+  for i in range(1, n - 1):
+    # Curvature from the circle through neighbouring points
+    ax, ay = xs[i] - xs[i - 1], ys[i] - ys[i - 1]
+    bx, by = xs[i + 1] - xs[i], ys[i + 1] - ys[i]
+    cross = ax * by - ay * bx
+    la, lb, lc = math.hypot(ax, ay), math.hypot(bx, by), math.hypot(ax + bx, ay + by)
+    if la * lb * lc > 1e-12:
+      k = abs(2 * cross / (la * lb * lc))
+      if k > 1e-6:
+        vmax[i] = min(vmax[i], math.sqrt(cfg["maxCentripetalAcceleration"] / k))
+    ds = s[i + 1] - s[i - 1]
+    dh = abs(hs[i + 1] - hs[i - 1])
+    if dh > 1e-9 and ds > 1e-9:
+      vmax[i] = min(vmax[i], cfg["maxAngularVelocity"] * ds / dh)
+
+  v = vmax[:]
+  v[0] = 0.0
+  v[-1] = 0.0
+  a = cfg["maxAcceleration"]
+  for i in range(1, n):
+    v[i] = min(v[i], math.sqrt(v[i - 1] ** 2 + 2 * a * (s[i] - s[i - 1])))
+  for i in range(n - 2, -1, -1):
+    v[i] = min(v[i], math.sqrt(v[i + 1] ** 2 + 2 * a * (s[i + 1] - s[i])))
+
+  t = [0.0]
+  for i in range(1, n):
+    ds = s[i] - s[i - 1]
+    vavg = (v[i] + v[i - 1]) / 2
+    t.append(t[-1] + (ds / vavg if vavg > 1e-9 else 0.0))
+  return t
+
+
+def resample(xs, ys, hs, t, dt):
+  count = int(math.ceil(t[-1] / dt)) + 1
+  out = []
+  for k in range(count):
+    tk = min(k * dt, t[-1])
+    i = min(max(bisect.bisect_right(t, tk) - 1, 0), len(t) - 2)
+    span = t[i + 1] - t[i]
+    f = (tk - t[i]) / span if span > 1e-12 else 0.0
+    out.append([
+      xs[i] + (xs[i + 1] - xs[i]) * f,
+      ys[i] + (ys[i + 1] - ys[i]) * f,
+      hs[i] + (hs[i + 1] - hs[i]) * f,
+    ])
+  return out
+
+
+def differentiate(values, dt):
+  n = len(values)
+  out = []
+  for k in range(n):
+    if k == 0 or k == n - 1:
+      out.append([0.0] * len(values[k]))
+    else:
+      out.append([(values[k + 1][j] - values[k - 1][j]) / (2 * dt) for j in range(len(values[k]))])
+  return out
+
+
+def generate(waypoints, cfg):
+  xs, ys, hs, s = build_path(waypoints)
+  t = profile(xs, ys, hs, s, cfg)
+  poses = resample(xs, ys, hs, t, cfg["dt"])
+  vels = differentiate(poses, cfg["dt"])
+  accs = differentiate(vels, cfg["dt"])
+  return [p + v + a for p, v, a in zip(poses, vels, accs)]
+
+
+def write(path, samples, dt):
+  with open(path, "wb") as f:
+    f.write(HEADER.pack(MAGIC, VERSION, len(samples), dt))
+    for sample in samples:
+      f.write(SAMPLE.pack(*sample))
+
+
+if __name__ == "__main__":
+  args = parser.parse_args()
+  with open(args.spec) as f:
+    spec = json.load(f)
+
+  os.makedirs(args.out, exist_ok=True)
+  for name, traj in spec["trajectories"].items():
+    cfg = dict(spec["constraints"])
+    cfg.update(traj.get("constraints", {}))
+    samples = generate(traj["waypoints"], cfg)
+    path = os.path.join(args.out, name + ".traj")
+    write(path, samples, cfg["dt"])
+    print("{}: {} samples, {:.2f}s".format(path, len(samples), (len(samples) - 1) * cfg["dt"]))
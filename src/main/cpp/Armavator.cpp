@@ -5,6 +5,15 @@ Armavator::Armavator(wom::Gearbox &armGearbox, wom::Gearbox &elevatorGearbox, Ar
 : _armGearbox(armGearbox), _elevatorGearbox(elevatorGearbox), _config(config) {
   arm = new wom::Arm(config.arm);
   elevator = new wom::Elevator(config.elevator);
+
+  //plans with the same costs as ArmavatorGoToPositionBehaviour
+  _presetPaths = std::make_unique<wom::GridPathCache<units::radian, units::meter, units::second>>(
+    1 / (arm->MaxSpeed() * 0.8),
+    1 / (elevator->MaxSpeed() * 0.8)
+  );
+  for (ArmavatorPosition preset : config.presets)
+    _presetPaths->AddPreset(config.grid.Discretise({preset.angle, preset.height}));
+  _presetPaths->Update(config.grid);
 }
 
 Armavator::~Armavator() {
@@ -31,6 +40,9 @@ void Armavator::OnUpdate(units::second_t dt) {
 
   arm->OnUpdate(dt);
   elevator->OnUpdate(dt);
+
+  //rebuilds the preset paths if the grid has changed
+  _presetPaths->Update(_config.grid);
 }
 
 //Sets the states names
@@ -53,6 +65,16 @@ void Armavator::SetManual(units::volt_t arm, units::volt_t elevator) {
 }
 
 
+ArmavatorConfig &Armavator::GetConfig() {
+  return _config;
+}
+
+std::optional<std::deque<ArmavatorConfig::grid_t::GridPathNode<units::second>>> Armavator::GetPresetPath(ArmavatorPosition from, ArmavatorPosition to) {
+  int fromPreset = _presetPaths->FindPreset(_config.grid.Discretise({from.angle, from.height}));
+  int toPreset = _presetPaths->FindPreset(_config.grid.Discretise({to.angle, to.height}));
+  return _presetPaths->Get(fromPreset, toPreset);
+}
+
 //returns the current position
 ArmavatorPosition Armavator::GetCurrentPosition() const {
   return ArmavatorPosition {
@@ -4,9 +4,32 @@
 #include "behaviour/SwerveBaseBehaviour.h"
 #include "behaviour/ArmavatorBehaviour.h"
 
+#include <frc/Filesystem.h>
+
+#include <map>
+
 
 using namespace behaviour;
 
+static std::map<std::string, std::shared_ptr<wom::HolonomicTrajectory>> trajectories;
+
+void LoadAutoTrajectories() {
+  std::string dir = frc::filesystem::GetDeployDirectory() + "/trajectories/";
+  for (std::string name : { "blue_top_triple_1", "blue_top_triple_2", "blue_top_triple_3", "blue_top_triple_4" }) {
+    auto trajectory = wom::HolonomicTrajectory::Load(dir + name + ".traj");
+    if (trajectory != nullptr)
+      trajectories[name] = trajectory;
+  }
+}
+
+static bool HasTrajectories(std::initializer_list<std::string> names) {
+  for (auto &name : names) {
+    if (trajectories.find(name) == trajectories.end())
+      return false;
+  }
+  return true;
+}
+
 // std::shared_ptr<behaviour::Behaviour> BlueSinglePiece() {
 //   return (
 //         make<DrivebasePoseBehaviour>(drivetrain, Poses::innerGrid1)
@@ -22,7 +45,7 @@ using namespace behaviour;
 // }
 
 
-std::shared_ptr<behaviour::Behaviour> CircularPathing(wom::SwerveDrive *swerve) {
+std::shared_ptr<behaviour::Behaviour> CircularPathing(wom::SwerveDrive<4> *swerve) {
     return 
         make<DrivebasePoseBehaviour>(swerve, frc::Pose2d{1_m, 0_m, 0_deg})
         << make<DrivebasePoseBehaviour>(swerve, frc::Pose2d{2_m, 1_m, 90_deg});
@@ -38,7 +61,7 @@ std::shared_ptr<behaviour::Behaviour> CircularPathing(wom::SwerveDrive *swerve)
 }
 
 
-std::shared_ptr<behaviour::Behaviour> Drive(wom::SwerveDrive *swerve, wom::NavX *gyro){
+std::shared_ptr<behaviour::Behaviour> Drive(wom::SwerveDrive<4> *swerve, wom::NavX *gyro){
     auto wait_until2 = make<DrivebasePoseBehaviour>(swerve, frc::Pose2d{0_in, 1.5_m, 0_deg}) | make<WaitTime>(2_s); 
     return
     make<WaitTime>(1_s)
@@ -53,23 +76,23 @@ std::shared_ptr<behaviour::Behaviour> Drive(wom::SwerveDrive *swerve, wom::NavX
 
 
 
-// std::shared_ptr<behaviour::Behaviour> Dock(wom::SwerveDrive *swerve, bool blueAlliance, enum startPos, enum endPos){
+// std::shared_ptr<behaviour::Behaviour> Dock(wom::SwerveDrive<4> *swerve, bool blueAlliance, enum startPos, enum endPos){
 
 // }
 
-// std::shared_ptr<behaviour::Behaviour> Single(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
+// std::shared_ptr<behaviour::Behaviour> Single(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
 
 // }
 
-// std::shared_ptr<behaviour::Behaviour> Double(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
+// std::shared_ptr<behaviour::Behaviour> Double(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
 
 // }
 
-// std::shared_ptr<behaviour::Behaviour> Triple(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
+// std::shared_ptr<behaviour::Behaviour> Triple(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
 
 // }
 
-// std::shared_ptr<behaviour::Behaviour> Quad(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
+// std::shared_ptr<behaviour::Behaviour> Quad(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos){
 
 // }
 
@@ -87,7 +110,7 @@ std::shared_ptr<behaviour::Behaviour> Drive(wom::SwerveDrive *swerve, wom::NavX
 // BLUE
 
 // Docking Only
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Dock(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Dock(wom::SwerveDrive<4> *swerve){
     // assumes Top is in placement position for outergrid_1
     return
     /*
@@ -97,7 +120,7 @@ std::shared_ptr<behaviour::Behaviour> BLUE_Top_Dock(wom::SwerveDrive *swerve){
     */
     make<WaitTime>(1_s);
 }
-std::shared_ptr<behaviour::Behaviour> BLUE_Middle_Dock(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Middle_Dock(wom::SwerveDrive<4> *swerve){
     // assumes Middle is in placement position for centregrid_2
     return
     /*
@@ -106,7 +129,7 @@ std::shared_ptr<behaviour::Behaviour> BLUE_Middle_Dock(wom::SwerveDrive *swerve)
     */
     make<WaitTime>(1_s);
 }
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Dock(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Dock(wom::SwerveDrive<4> *swerve){
     // assumes Bottom is in placement position for innergrid_1
     return
     /*
@@ -118,7 +141,7 @@ std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Dock(wom::SwerveDrive *swerve)
 }
 
 // Single Score                 <- We should not need to move for this
-std::shared_ptr<behaviour::Behaviour> BLUE_Single(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Single(wom::SwerveDrive<4> *swerve){
     return
     /*
     make<ArmavatorScoreHigh>();
@@ -127,7 +150,7 @@ std::shared_ptr<behaviour::Behaviour> BLUE_Single(wom::SwerveDrive *swerve){
 }
 
 // Single Score + Dock          <- We should only be in middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Single_Dock(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Single_Dock(wom::SwerveDrive<4> *swerve){
     return
     /*
     make<ArmavatorScoreHigh>();
@@ -138,7 +161,7 @@ std::shared_ptr<behaviour::Behaviour> BLUE_Single_Dock(wom::SwerveDrive *swerve)
 }
 
 // Triple Score                 <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Triple(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Triple(wom::SwerveDrive<4> *swerve){
     /*
     make<ArmavatorScoreHigh>();
     make<ArmavatorGoToBalancePosition() & drive to centreTopMidGamePiece & deploy intake
@@ -146,6 +169,16 @@ std::shared_ptr<behaviour::Behaviour> BLUE_Top_Triple(wom::SwerveDrive *swerve){
     drive to adjacent inner grid & "(maybe)retract intake" & start moving arm up
     */
 
+    if (HasTrajectories({ "blue_top_triple_1", "blue_top_triple_2", "blue_top_triple_3", "blue_top_triple_4" })) {
+        return
+        make<WaitTime>(1_s)
+        << make<FollowTrajectory>(swerve, trajectories["blue_top_triple_1"])
+        << make<FollowTrajectory>(swerve, trajectories["blue_top_triple_2"])
+        << make<FollowTrajectory>(swerve, trajectories["blue_top_triple_3"])
+        << make<FollowTrajectory>(swerve, trajectories["blue_top_triple_4"]);
+    }
+
+    // Waypoints the trajectories were generated from, in case they weren't deployed
     auto wait_until = make<DrivebasePoseBehaviour>(swerve, frc::Pose2d{224_in, -45_in, 0_deg}) | make<WaitTime>(4_s);
     auto wait_until2 = make<DrivebasePoseBehaviour>(swerve, frc::Pose2d{0_in, 1.5_m, 0_deg}) | make<WaitTime>(2_s); 
     return
@@ -162,31 +195,31 @@ std::shared_ptr<behaviour::Behaviour> BLUE_Top_Triple(wom::SwerveDrive *swerve){
     // << wait_until2
     // << make<DrivebasePoseBehaviour>(swerve, frc::Pose2d{1_m, -1_m, 0_deg});
 }
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Triple(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Triple(wom::SwerveDrive<4> *swerve){
     return make<WaitTime>(1_s);
 }
 
 // Double Score + Dock          <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double_Dock(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double_Dock(wom::SwerveDrive<4> *swerve){
     return make<WaitTime>(1_s);
 }
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double_Dock(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double_Dock(wom::SwerveDrive<4> *swerve){
     return make<WaitTime>(1_s);
 }
 
 // Double                       <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double(wom::SwerveDrive<4> *swerve){
     return make<WaitTime>(1_s);
 }
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double(wom::SwerveDrive<4> *swerve){
     return make<WaitTime>(1_s);
 }
 
 // Quad Collect                 <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Quad_Collect(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Quad_Collect(wom::SwerveDrive<4> *swerve){
     return make<WaitTime>(1_s);
 }
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Quad_Collect(wom::SwerveDrive *swerve){
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Quad_Collect(wom::SwerveDrive<4> *swerve){
     return make<WaitTime>(1_s);
 }
 
@@ -223,4 +256,26 @@ FOR returning to a grid position after collecting from centre:
 
         
 
-*/
\ No newline at end of file
+*/
+
+
+const std::map<std::string, auto_factory_t> &GetAutos() {
+    static const std::map<std::string, auto_factory_t> autos{
+        { "Drive", Drive },
+        { "CircularPathing", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return CircularPathing(swerve); } },
+        { "BLUE_Top_Dock", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Top_Dock(swerve); } },
+        { "BLUE_Middle_Dock", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Middle_Dock(swerve); } },
+        { "BLUE_Bottom_Dock", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Bottom_Dock(swerve); } },
+        { "BLUE_Single", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Single(swerve); } },
+        { "BLUE_Single_Dock", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Single_Dock(swerve); } },
+        { "BLUE_Top_Triple", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Top_Triple(swerve); } },
+        { "BLUE_Bottom_Triple", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Bottom_Triple(swerve); } },
+        { "BLUE_Top_Double_Dock", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Top_Double_Dock(swerve); } },
+        { "BLUE_Bottom_Double_Dock", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Bottom_Double_Dock(swerve); } },
+        { "BLUE_Top_Double", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Top_Double(swerve); } },
+        { "BLUE_Bottom_Double", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Bottom_Double(swerve); } },
+        { "BLUE_Top_Quad_Collect", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Top_Quad_Collect(swerve); } },
+        { "BLUE_Bottom_Quad_Collect", [](wom::SwerveDrive<4> *swerve, wom::NavX *) { return BLUE_Bottom_Quad_Collect(swerve); } },
+    };
+    return autos;
+}
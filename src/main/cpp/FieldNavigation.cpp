@@ -0,0 +1,137 @@
+#include "FieldNavigation.h"
+
+#include <units/math.h>
+
+#include <cmath>
+#include <numbers>
+
+namespace {
+  //a rectangle on the field, in metres from the blue alliance wall
+  struct Box {
+    double xmin, ymin, xmax, ymax;
+  };
+
+  //the blue alliance's side of the 2023 field, from the field drawings, the red side is the mirror of it
+  const Box kBlueObstacles[] = {
+    {0, 0, 1.38, 5.49},         // grids
+    {2.92, 1.51, 4.85, 3.98},   // charge station
+    {0, 5.44, 3.36, 5.54},      // barrier between the community and the loading zone
+    {16.18, 5.49, 16.54, 8.02}  // double substation, at the far end of the blue loading zone
+  };
+
+  frc::Pose2d Origin(frc::Pose2d blue, frc::DriverStation::Alliance alliance) {
+    if (alliance != frc::DriverStation::Alliance::kRed)
+      return blue;
+    return frc::Pose2d{FieldNavigation::kFieldLength - blue.X(), blue.Y(), units::radian_t{std::numbers::pi} - blue.Rotation().Radians()};
+  }
+
+  std::vector<FieldNavigation::grid_t::Idx_t> TargetCells(FieldNavigation::grid_t &grid, const FieldNavigationConfig &config) {
+    //targets for both alliances, blue first
+    std::vector<FieldNavigation::grid_t::Idx_t> cells;
+    for (auto alliance : {frc::DriverStation::Alliance::kBlue, frc::DriverStation::Alliance::kRed}) {
+      frc::Pose2d origin = Origin(config.origin, alliance);
+      for (auto &target : config.targets) {
+        frc::Translation2d field = origin.Translation() + target.Translation().RotateBy(origin.Rotation());
+        cells.push_back(grid.Discretise({field.X(), field.Y()}));
+      }
+    }
+    return cells;
+  }
+}
+
+FieldNavigation::grid_t FieldNavigation::MakeGrid(units::meter_t footprint, units::meter_t resolution) {
+  int cols = (int)std::ceil((kFieldLength / resolution).value());
+  int rows = (int)std::ceil((kFieldWidth / resolution).value());
+  grid_t grid{0_m, resolution * cols, 0_m, resolution * rows, (size_t)cols, (size_t)rows};
+
+  grid.FillF([](units::meter_t x, units::meter_t y) {
+    for (const Box &box : kBlueObstacles) {
+      for (double bx : {x.value(), (kFieldLength - x).value()}) {
+        if (bx >= box.xmin && bx <= box.xmax && y.value() >= box.ymin && y.value() <= box.ymax)
+          return true;
+      }
+    }
+    return false;
+  });
+
+  //the field perimeter
+  for (int x = 0; x < cols; x++) {
+    grid.Set({x, 0}, true);
+    grid.Set({x, rows - 1}, true);
+  }
+  for (int y = 0; y < rows; y++) {
+    grid.Set({0, y}, true);
+    grid.Set({cols - 1, y}, true);
+  }
+
+  int grow = (int)std::ceil((footprint / resolution).value());
+  grid.Dilate(grow, grow);
+  return grid;
+}
+
+FieldNavigation::FieldNavigation(FieldNavigationConfig config) : _config(config), _roadmap([&config]() {
+  grid_t grid = MakeGrid(config.footprint, config.resolution);
+  auto targets = TargetCells(grid, config);
+  //costs are just distance, the robot drives the same speed everywhere
+  return roadmap_t{grid, targets, 1_s / 1_m, 1_s / 1_m};
+}()) { }
+
+bool FieldNavigation::SetAlliance(frc::DriverStation::Alliance alliance) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  bool changed = alliance != _alliance;
+  _alliance = alliance;
+  return changed;
+}
+
+frc::Translation2d FieldNavigation::ToField(frc::Translation2d pose) const {
+  frc::Pose2d origin = Origin(_config.origin, _alliance);
+  return origin.Translation() + pose.RotateBy(origin.Rotation());
+}
+
+frc::Translation2d FieldNavigation::FromField(frc::Translation2d field) const {
+  frc::Pose2d origin = Origin(_config.origin, _alliance);
+  return (field - origin.Translation()).RotateBy(-origin.Rotation());
+}
+
+frc::Pose2d FieldNavigation::FromField(frc::Pose2d field) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return field.RelativeTo(Origin(_config.origin, _alliance));
+}
+
+std::vector<frc::Translation2d> FieldNavigation::Route(frc::Pose2d from, frc::Pose2d to) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  grid_t &grid = _roadmap.GetGrid();
+  frc::Translation2d start = ToField(from.Translation()), end = ToField(to.Translation());
+  grid_t::Idx_t startCell = grid.Discretise({start.X(), start.Y()});
+
+  //the planner passes targets through exactly, this only allows for rounding
+  std::vector<grid_t::Idx_t> cells;
+  int target = -1;
+  for (size_t i = 0; i < _config.targets.size(); i++) {
+    if (_config.targets[i].Translation().Distance(to.Translation()) <= _config.resolution) {
+      target = (int)i + (_alliance == frc::DriverStation::Alliance::kRed ? (int)_config.targets.size() : 0);
+      break;
+    }
+  }
+  if (target >= 0)
+    cells = _roadmap.Route(startCell, target);
+  else
+    cells = _roadmap.Route(startCell, grid.Discretise({end.X(), end.Y()}));
+
+  //just the corners between the ends, leaving out any too close to them to matter
+  std::vector<frc::Translation2d> corners;
+  for (size_t i = 1; i + 1 < cells.size(); i++) {
+    auto center = grid.CenterOf(cells[i]);
+    frc::Translation2d corner{center.x, center.y};
+    if (corner.Distance(start) > 2 * _config.resolution && corner.Distance(end) > 2 * _config.resolution)
+      corners.push_back(FromField(corner));
+  }
+  return corners;
+}
+
+wom::HolonomicTrajectoryPlannerConfig FieldNavigation::PlannerConfig(wom::HolonomicTrajectoryPlannerConfig base) {
+  base.route = [this](frc::Pose2d start, frc::Pose2d target) {
+    return Route(start, target);
+  };
+  return base;
+}
@@ -4,6 +4,7 @@
 #include "behaviour/SwerveBaseBehaviour.h"
 #include "behaviour/SideIntakeBehaviour.h"
 #include "behaviour/GripperBehaviour.h"
+#include "PIDAutotune.h"
 
 #include <frc/smartdashboard/SmartDashboard.h>
 #include <frc/event/BooleanEvent.h>
@@ -24,7 +25,19 @@ void Robot::RobotInit() {
 
   map.swerveBase.gyro.Reset();
 
-  swerve = new wom::SwerveDrive(map.swerveBase.config, frc::Pose2d());
+  for (auto &mod : map.swerveBase.config.modules) {
+    sensors.Register(mod.driveMotor.encoder);
+    sensors.Register(mod.turnMotor.encoder);
+  }
+  sensors.Register(&map.swerveBase.gyro);
+  sensors.Sample();
+
+  LoadAutoTrajectories();
+
+  swerve = new wom::SwerveDrive<4>(map.swerveBase.config, frc::Pose2d());
+  // In simulation the encoders only move once per loop, so there's nothing to gain
+  if (frc::RobotBase::IsReal())
+    swerve->StartOdometryThread(200_Hz);
   // map.swerveBase.moduleConfigs[1].turnMotor.transmission->SetInverted(true);
   // map.swerveBase.moduleConfigs[3].turnMotor.transmission->SetInverted(true);
   BehaviourScheduler::GetInstance()->Register(swerve);
@@ -55,8 +68,10 @@ void Robot::RobotInit() {
 }
 
 void Robot::RobotPeriodic() {
-  auto dt = wom::now() - lastPeriodic;
-  lastPeriodic = wom::now();
+  sensors.Sample();
+
+  auto dt = sensors.GetTimestamp() - lastPeriodic;
+  lastPeriodic = sensors.GetTimestamp();
   
   loop.Poll();
   BehaviourScheduler::GetInstance()->Tick();
@@ -72,11 +87,13 @@ void Robot::RobotPeriodic() {
   // sideIntake->OnUpdate(dt);
 
   // gripper->OnUpdate(dt);
-  // auto visionPose = vision->OnUpdate(dt);
 
-  // if (visionPose.has_value()){
-  //   swerve->AddVisionMeasurement(visionPose.value().first.ToPose2d(), visionPose.value().second);
-  // }
+  // Vision poses are timestamped at capture, the drivebase fuses them at that time.
+  // They're field-relative, the drivebase's pose is zeroed where auto starts.
+  auto visionPose = vision->OnUpdate(dt);
+  if (visionPose.has_value()) {
+    swerve->AddVisionMeasurement(fieldNavigation.FromField(visionPose.value().first.ToPose2d()), visionPose.value().second);
+  }
 
   std::optional<units::meter_t> distance = map.gripper.gamepiecePresence.GetDistance();
   if (distance.has_value())
@@ -87,15 +104,21 @@ void Robot::RobotPeriodic() {
 
 void Robot::AutonomousInit() {
   swerve->OnStart();
+  // Before the reset, so vision fused after it uses the right origin
+  if (fieldNavigation.SetAlliance(frc::DriverStation::GetAlliance()))
+    alignPlanner.ClearCache();
   swerve->ResetPose(frc::Pose2d());
   BehaviourScheduler *sched = BehaviourScheduler::GetInstance();
-  sched->Schedule(Drive(swerve, &map.swerveBase.gyro));
+  _auto = GetAutos().at(_autoName)(swerve, &map.swerveBase.gyro);
+  sched->Schedule(_auto);
  }
 
 void Robot::AutonomousPeriodic() { }
 
 void Robot::TeleopInit() {
   loop.Clear();
+  if (fieldNavigation.SetAlliance(frc::DriverStation::GetAlliance()))
+    alignPlanner.ClearCache();
   BehaviourScheduler *sched = BehaviourScheduler::GetInstance();
   sched->InterruptAll(); // removes all previously scheduled behaviours
 
@@ -106,36 +129,36 @@ void Robot::TeleopInit() {
   map.controllers.driver.POV(0, &loop).Rising().IfHigh([sched, this]() {
     if (map.controllers.driver.GetRightBumper()) {
       if (map.controllers.driver.GetLeftBumper()){
-        sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.centreGrid2, false)); // central grid
+        sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.centreGrid2)); // central grid
       } else {
-        sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.outerGrid3, false)); // Outer Grid 3 (furthest from centre)
+        sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.outerGrid3)); // Outer Grid 3 (furthest from centre)
       }
     } else {
-      sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.innerGrid1, false)); // Inner Grid 1 (furthest from centre)
+      sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.innerGrid1)); // Inner Grid 1 (furthest from centre)
     }
   });
   // RIGHT D-PAD
   map.controllers.driver.POV(90, &loop).Rising().IfHigh([sched, this]() {
     if (map.controllers.driver.GetRightBumper()) {
-      sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.outerGrid2, false)); // Outer Grid 2
+      sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.outerGrid2)); // Outer Grid 2
     } else {
-      sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.innerGrid2, false)); // Inner Grid 2
+      sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.innerGrid2)); // Inner Grid 2
     }
   });
   // DOWN D-PAD
   map.controllers.driver.POV(180, &loop).Rising().IfHigh([sched, this]() {
     if (map.controllers.driver.GetRightBumper()) {
-      sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.outerGrid1, false)); // Outer Grid 1 (closest to centre)
+      sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.outerGrid1)); // Outer Grid 1 (closest to centre)
     } else{
-      sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.innerGrid3, false)); // Inner Grid 3 (closest to centre)
+      sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.innerGrid3)); // Inner Grid 3 (closest to centre)
     }
   });
   // LEFT D-PAD
   map.controllers.driver.POV(270, &loop).Rising().IfHigh([sched, this]() {
     if (map.controllers.driver.GetRightBumper()) {
-      sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.centreGrid3, false)); // Community Grid 3 (outer grid side)
+      sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.centreGrid3)); // Community Grid 3 (outer grid side)
     } else {
-      sched->Schedule(make<DrivebasePoseBehaviour>(swerve, map.swerveGridPoses.centreGrid1, false)); // Community Grid 1 (inner grid side)
+      sched->Schedule(make<DrivebaseAlign>(swerve, &alignPlanner, map.swerveGridPoses.centreGrid1)); // Community Grid 1 (inner grid side)
     }
   });
 
@@ -243,5 +266,31 @@ void Robot::DisabledInit() {
 }
 void Robot::DisabledPeriodic() {}
 
-void Robot::TestInit() { }
+void Robot::TestInit() {
+  BehaviourScheduler *sched = BehaviourScheduler::GetInstance();
+  sched->InterruptAll();
+
+  swerve->OnStart();
+
+  // Relay-tune the pose heading loop about the current heading. The proposed gains
+  // are published to the poseAnglePID NT path once the experiment completes.
+  using heading_tune_t = wom::PIDAutotune<units::radian, units::radians_per_second>;
+  sched->Schedule(make<heading_tune_t>(
+    "/drivetrain/autotune/heading",
+    map.swerveBase.poseAnglePID,
+    heading_tune_t::tune_config_t{
+      swerve->GetPose().Rotation().Radians(),
+      90_deg / 1_s,
+      0_deg / 1_s,
+      2_deg,
+      4,
+      0.15,
+      360_deg,
+      wom::PIDAutotuneRule::kSomeOvershoot
+    },
+    [this]() { return swerve->GetPose().Rotation().Radians(); },
+    [this](units::radians_per_second_t omega) { swerve->SetVelocity(frc::ChassisSpeeds{0_mps, 0_mps, omega}); },
+    swerve
+  )->WithTimeout(20_s));
+}
 void Robot::TestPeriodic() { }
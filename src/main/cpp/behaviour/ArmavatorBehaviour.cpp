@@ -14,21 +14,39 @@ void ArmavatorGoToPositionBehaviour::OnStart() {
   // _armavator->elevator->SetZeroing();
   
   //Sets current position
-  // ArmavatorPosition Elevator
-  // ArmavatorPosition current = armavator->GetCurrentPosition();
+  ArmavatorPosition current = _armavator->GetCurrentPosition();
+  grid_t &grid = _armavator->GetConfig().grid;
   //Sets positions information for the start and the end of the instructions
-  // grid_t::Idx_t start = armavator.config.grid.Discretise({current.angle, current.height});
-  // grid_t::Idx_t end = armavator.config.grid.Discretise({setpoint.angle, setpoint.height});
-  //Sets arm and elevator speeds for start and end
-  // waypoints = armavator->config.grid.AStar<units::second>(
-  //     start, end,
-  //     1 / (armavator->arm.MaxSpeed() * 0.8),
-  //     1 / (armavator->elevator.MaxSpeed() * 0.8)
-  // );
+  grid_t::Idx_t start = grid.Discretise({current.angle, current.height});
+  grid_t::Idx_t end = grid.Discretise({_setpoint.angle, _setpoint.height});
+  //Moves between presets are planned ahead of time, otherwise plans around the obstacles
+  //in the grid, with the cost of each waypoint being the time to get there
+  auto waypoints = _armavator->GetPresetPath(current, _setpoint);
+  if (!waypoints) {
+    waypoints = grid.AStar<units::second>(
+        start, end,
+        1 / (_armavator->arm->MaxSpeed() * 0.8),
+        1 / (_armavator->elevator->MaxSpeed() * 0.8)
+    );
+  }
+
+  //Smooths the path out and times it so both joints move at once, within what they can do
+  _trajectory = trajectory_t::FromPath<units::second>(grid, *waypoints, trajectory_t::Limits{
+    _armavator->arm->MaxSpeed() * 0.8,
+    _armavator->elevator->MaxSpeed() * 0.8,
+    _armavator->arm->MaxAcceleration() * 0.5,
+    _armavator->elevator->MaxAcceleration() * 0.5
+  });
 }
 
 //Function for OnTick
 void ArmavatorGoToPositionBehaviour::OnTick(units::second_t dt) {
+  //Follows the planned trajectory, then goes to the exact setpoint at the end
+  if (GetRunTime() < _trajectory.Duration()) {
+    trajectory_t::State state = _trajectory.Sample(GetRunTime());
+    _armavator->SetPosition({state.y, state.x});
+    return;
+  }
 
   if(_setpoint.height < 1_m) {
     if (_setpoint.angle >  0_rad){ // _setpoint.angle.value() < 0
@@ -40,28 +58,9 @@ void ArmavatorGoToPositionBehaviour::OnTick(units::second_t dt) {
   };
   _armavator->SetPosition(_setpoint);
 
-  //If statement for targetted waypoint position is empty
-  // if (!waypoints.empty()) {
-  //     grid_t::GridPathNode<units::second> waypoint = waypoints.front();
-  //     while (!waypoints.empty() && waypoint.cost <= GetRunTime()) {
-  //         waypoints.pop_front();
-  //         if (!waypoints.empty())
-  //             waypoint = waypoints.front();
-  //     }
-
-  //     ArmavatorPosition currentPosition = armavator->GetCurrentPosition();
-  //     grid_t::Idx_t current = armavator.config.grid.Discretise({currentPosition.angle, currentPosition.height});
-      
-  //     armavator->SetPosition({waypoint.position.y, waypoint.position.x});
-  
-  // //If waypoint is full, set next position
-  // } else {
-  //     armavator->SetPosition(setpoint);
-
-  //     //If the arm elevator is in correct final position, stop moving
+  //If the arm elevator is in correct final position, stop moving
   if (_armavator->IsStable())
     SetDone();
-  // }  
 }
 
 
@@ -9,7 +9,7 @@
 
 using namespace wom;
 
-ManualDrivebase::ManualDrivebase(wom::SwerveDrive *swerveDrivebase, frc::XboxController *driverController) : _swerveDrivebase(swerveDrivebase), _driverController(driverController) {
+ManualDrivebase::ManualDrivebase(wom::SwerveDrive<4> *swerveDrivebase, frc::XboxController *driverController) : _swerveDrivebase(swerveDrivebase), _driverController(driverController) {
   Controls(swerveDrivebase);
 }
 
@@ -42,7 +42,7 @@ void ManualDrivebase::OnTick(units::second_t deltaTime) {
   }
 
 DrivebasePoseBehaviour::DrivebasePoseBehaviour(
-    wom::SwerveDrive *swerveDrivebase, frc::Pose2d pose, bool hold)
+    wom::SwerveDrive<4> *swerveDrivebase, frc::Pose2d pose, bool hold)
     : _swerveDrivebase(swerveDrivebase), _pose(pose), _hold(hold) {
   Controls(swerveDrivebase);
 }
@@ -60,7 +60,58 @@ void DrivebasePoseBehaviour::OnTick(units::second_t deltaTime) {
   }
 }
 
-DrivebaseBalance::DrivebaseBalance(wom::SwerveDrive *swerveDrivebase, wom::NavX *gyro) : _swerveDrivebase(swerveDrivebase), _gyro(gyro) {
+FollowTrajectory::FollowTrajectory(wom::SwerveDrive<4> *swerveDrivebase, std::shared_ptr<wom::HolonomicTrajectory> trajectory)
+    : behaviour::Behaviour("FollowTrajectory"), _swerveDrivebase(swerveDrivebase), _trajectory(trajectory) {
+  Controls(swerveDrivebase);
+}
+
+void FollowTrajectory::OnStart() {
+  _time = 0_s;
+}
+
+void FollowTrajectory::OnTick(units::second_t deltaTime) {
+  _time += deltaTime;
+  wom::HolonomicTrajectorySample sample = _trajectory->Sample(_time);
+  _swerveDrivebase->SetPose(sample.pose, sample.velocity);
+
+  _swerveDriveTable->GetEntry("trajectoryTime").SetDouble(_time.value());
+  wom::WritePose2NT(_swerveDriveTable->GetSubTable("trajectoryPose"), sample.pose);
+
+  if (_time >= _trajectory->GetDuration() && _swerveDrivebase->IsAtSetPose()) {
+    SetDone();
+  }
+}
+
+DrivebaseAlign::DrivebaseAlign(wom::SwerveDrive<4> *swerveDrivebase, wom::HolonomicTrajectoryPlanner *planner, frc::Pose2d target)
+    : behaviour::Behaviour("DrivebaseAlign"), _swerveDrivebase(swerveDrivebase), _planner(planner), _target(target) {
+  Controls(swerveDrivebase);
+}
+
+void DrivebaseAlign::OnStart() {
+  _start = _swerveDrivebase->GetPose();
+  _trajectory = nullptr;
+  _time = 0_s;
+}
+
+void DrivebaseAlign::OnTick(units::second_t deltaTime) {
+  if (_trajectory == nullptr) {
+    _trajectory = _planner->Request(_start, _target);
+    if (_trajectory == nullptr) {
+      _swerveDrivebase->SetPose(_start);
+      return;
+    }
+  }
+
+  _time += deltaTime;
+  wom::HolonomicTrajectorySample sample = _trajectory->Sample(_time);
+  _swerveDrivebase->SetPose(sample.pose, sample.velocity);
+
+  if (_time >= _trajectory->GetDuration() && _swerveDrivebase->IsAtSetPose()) {
+    SetDone();
+  }
+}
+
+DrivebaseBalance::DrivebaseBalance(wom::SwerveDrive<4> *swerveDrivebase, wom::NavX *gyro) : _swerveDrivebase(swerveDrivebase), _gyro(gyro) {
   Controls(swerveDrivebase);
 }
 void DrivebaseBalance::OnTick(units::second_t deltaTime) {
@@ -79,7 +130,7 @@ void DrivebaseBalance::OnTick(units::second_t deltaTime) {
 }
 
 
-XDrivebase::XDrivebase(wom::SwerveDrive *swerveDrivebase) : _swerveDrivebase(swerveDrivebase) {
+XDrivebase::XDrivebase(wom::SwerveDrive<4> *swerveDrivebase) : _swerveDrivebase(swerveDrivebase) {
   Controls(swerveDrivebase);
 }
 void XDrivebase::OnTick(units::second_t deltaTime) {
@@ -6,7 +6,7 @@
 //     Controls(vision);
 //   }
 
-VisionBehaviour::VisionBehaviour(Vision *vision, wom::SwerveDrive *swerveDrivebase, frc::XboxController *codriver) : _vision(vision), _swerveDrivebase(swerveDrivebase), _codriver(codriver)
+VisionBehaviour::VisionBehaviour(Vision *vision, wom::SwerveDrive<4> *swerveDrivebase, frc::XboxController *codriver) : _vision(vision), _swerveDrivebase(swerveDrivebase), _codriver(codriver)
   {
     Controls(_vision);
   }
@@ -4,6 +4,7 @@
 #include "Elevator.h"
 #include "Gearbox.h"
 #include "Grid.h"
+#include "GridPathCache.h"
 #include "drivetrain/SwerveDrive.h"
 
 #include <frc/DigitalInput.h>
@@ -14,6 +15,17 @@
 #include <units/math.h>
 #include "behaviour/HasBehaviour.h"
 
+#include <memory>
+#include <optional>
+#include <vector>
+
+//class of info for setting positions
+struct ArmavatorPosition {
+  units::meter_t height;
+  units::radian_t angle;
+
+};
+
 //the config class
 struct ArmavatorConfig {
   using grid_t = wom::DiscretisedOccupancyGrid<units::radian, units::meter>;
@@ -22,13 +34,9 @@ struct ArmavatorConfig {
   wom::ArmConfig arm;
   wom::ElevatorConfig elevator;
   grid_t grid;
-};
-
-//class of info for setting positions
-struct ArmavatorPosition {
-  units::meter_t height;
-  units::radian_t angle;
 
+  //positions the armavator moves between a lot, paths between them are planned ahead of time
+  std::vector<ArmavatorPosition> presets{};
 };
 
 //creates the states used to control the robot
@@ -55,6 +63,11 @@ class Armavator : public behaviour::HasBehaviour {
   ArmavatorPosition GetCurrentPosition() const;
   bool IsStable() const;
 
+  ArmavatorConfig &GetConfig();
+
+  //the planned path between two presets, if both are presets and the paths are ready
+  std::optional<std::deque<ArmavatorConfig::grid_t::GridPathNode<units::second>>> GetPresetPath(ArmavatorPosition from, ArmavatorPosition to);
+
   //creates the arm and the elevator
   wom::Arm *arm;
   wom::Elevator *elevator;
@@ -70,4 +83,7 @@ class Armavator : public behaviour::HasBehaviour {
   wom::Gearbox &_armGearbox;
   wom::Gearbox &_elevatorGearbox;
   ArmavatorConfig &_config;
+
+  //paths between all the presets, rebuilt in the background when the grid changes
+  std::unique_ptr<wom::GridPathCache<units::radian, units::meter, units::second>> _presetPaths;
 };
\ No newline at end of file
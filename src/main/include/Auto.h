@@ -3,6 +3,10 @@
 #include "behaviour/Behaviour.h"
 #include "drivetrain/SwerveDrive.h"
 
+#include <functional>
+#include <map>
+#include <string>
+
 
 
 /*
@@ -12,7 +16,21 @@ Starting Poses corresponding with:
     Bottom: frc::Pose2d{0_m, 0_m, 0_deg}
 */
 
-std::shared_ptr<behaviour::Behaviour> Drive(wom::SwerveDrive *swerve, wom::NavX *gyro);
+std::shared_ptr<behaviour::Behaviour> Drive(wom::SwerveDrive<4> *swerve, wom::NavX *gyro);
+
+/**
+ * Map the precomputed trajectories in deploy/trajectories, generated by
+ * scripts/trajectory_gen.py. Call once from RobotInit, before building autos.
+ */
+void LoadAutoTrajectories();
+
+using auto_factory_t = std::function<std::shared_ptr<behaviour::Behaviour>(wom::SwerveDrive<4> *, wom::NavX *)>;
+
+/**
+ * Every implemented auto by name, so one can be picked at runtime (e.g. by the
+ * headless simulator) rather than being hard coded in AutonomousInit.
+ */
+const std::map<std::string, auto_factory_t> &GetAutos();
 
 
 enum endingConfig {
@@ -32,15 +50,15 @@ enum startingConfig {
 
 
 
-// std::shared_ptr<behaviour::Behaviour> Dock(wom::SwerveDrive *swerve, bool blueAlliance, enum startingConfig, enum endingConfig);
+// std::shared_ptr<behaviour::Behaviour> Dock(wom::SwerveDrive<4> *swerve, bool blueAlliance, enum startingConfig, enum endingConfig);
 
-// std::shared_ptr<behaviour::Behaviour> Single(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
+// std::shared_ptr<behaviour::Behaviour> Single(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
 
-// std::shared_ptr<behaviour::Behaviour> Double(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
+// std::shared_ptr<behaviour::Behaviour> Double(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
 
-// std::shared_ptr<behaviour::Behaviour> Triple(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
+// std::shared_ptr<behaviour::Behaviour> Triple(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
 
-// std::shared_ptr<behaviour::Behaviour> Quad(wom::SwerveDrive *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
+// std::shared_ptr<behaviour::Behaviour> Quad(wom::SwerveDrive<4> *swerve, bool blueAlliance, bool dock, enum startPos, enum endPos);
 
 
 
@@ -59,60 +77,60 @@ enum startingConfig {
 // BLUE
 
 // Docking Only
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Dock(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> BLUE_Middle_Dock(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Dock(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Dock(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Middle_Dock(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Dock(wom::SwerveDrive<4> *swerve);
 
 // Single Score                 <- We should not need to move for this
-std::shared_ptr<behaviour::Behaviour> BLUE_Single(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Single(wom::SwerveDrive<4> *swerve);
 
 // Single Score + Dock          <- We should only be in middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Single_Dock(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Single_Dock(wom::SwerveDrive<4> *swerve);
 
 // Triple Score                 <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Triple(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Triple(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Triple(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Triple(wom::SwerveDrive<4> *swerve);
 
 // Double Score + Dock          <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double_Dock(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double_Dock(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double_Dock(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double_Dock(wom::SwerveDrive<4> *swerve);
 
 // Double                       <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Double(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Double(wom::SwerveDrive<4> *swerve);
 
 // Quad Collect                 <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> BLUE_Top_Quad_Collect(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Quad_Collect(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Top_Quad_Collect(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> BLUE_Bottom_Quad_Collect(wom::SwerveDrive<4> *swerve);
 
 
 
 // RED
 
 // Docking Only
-std::shared_ptr<behaviour::Behaviour> RED_Top_Dock(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> RED_Middle_Dock(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> RED_Bottom_Dock(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Top_Dock(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Middle_Dock(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Bottom_Dock(wom::SwerveDrive<4> *swerve);
 
 // Single Score                 <- We should not need to move for this
-std::shared_ptr<behaviour::Behaviour> RED_Single(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Single(wom::SwerveDrive<4> *swerve);
 
 // Single Score + Dock          <- We should only be in middle for doing this one
-std::shared_ptr<behaviour::Behaviour> RED_Single_Dock(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Single_Dock(wom::SwerveDrive<4> *swerve);
 
 // Triple Score                 <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> RED_Top_Triple(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> RED_Bottom_Triple(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Top_Triple(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Bottom_Triple(wom::SwerveDrive<4> *swerve);
 
 // Double Score + Dock          <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> RED_Top_Double_Dock(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> RED_Bottom_Double_Dock(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Top_Double_Dock(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Bottom_Double_Dock(wom::SwerveDrive<4> *swerve);
 
 // Double                       <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> RED_Top_Double(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> RED_Bottom_Double(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Top_Double(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Bottom_Double(wom::SwerveDrive<4> *swerve);
 
 // Quad Collect                 <- We should never be in the middle for doing this one
-std::shared_ptr<behaviour::Behaviour> RED_Top_Quad_Collect(wom::SwerveDrive *swerve);
-std::shared_ptr<behaviour::Behaviour> RED_Bottom_Quad_Collect(wom::SwerveDrive *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Top_Quad_Collect(wom::SwerveDrive<4> *swerve);
+std::shared_ptr<behaviour::Behaviour> RED_Bottom_Quad_Collect(wom::SwerveDrive<4> *swerve);
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GridRoadmap.h"
+#include "drivetrain/HolonomicTrajectoryPlanner.h"
+
+#include <frc/DriverStation.h>
+#include <frc/geometry/Pose2d.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <units/velocity.h>
+
+#include <mutex>
+#include <vector>
+
+//info for planning drives around the field
+struct FieldNavigationConfig {
+  //where the robot is on the blue alliance when its pose is zeroed, in field coordinates
+  //(from the blue alliance wall, with the scoring table at y = 0). The red alliance is the mirror.
+  frc::Pose2d origin;
+  //how far the robot sticks out from its centre, with bumpers, obstacles are grown by this
+  units::meter_t footprint;
+  //size of each cell of the field grid
+  units::meter_t resolution = 5_cm;
+  //the poses to plan routes to ahead of time, relative to the origin like the robot's pose
+  std::vector<frc::Pose2d> targets{};
+};
+
+/**
+ * A map of where the robot can drive on the 2023 field, with the routes to every
+ * target worked out at startup, so the robot can get to them from anywhere
+ * without driving into the charge station or a grid.
+ *
+ * Poses in and out are relative to the origin, like the robot's pose, which is
+ * zeroed where auto starts.
+ */
+class FieldNavigation {
+ public:
+  using grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter>;
+  using roadmap_t = wom::GridRoadmap<units::meter, units::meter, units::second>;
+
+  static constexpr units::meter_t kFieldLength = 16.54_m;
+  static constexpr units::meter_t kFieldWidth = 8.02_m;
+
+  FieldNavigation(FieldNavigationConfig config);
+
+  /**
+   * The field with every obstacle on it, grown by the footprint so the robot can
+   * be planned as a point.
+   */
+  static grid_t MakeGrid(units::meter_t footprint, units::meter_t resolution);
+
+  /**
+   * Which alliance the robot is on, which flips where the origin is on the field.
+   * Each route is planned under one lock, so sees one alliance or the other.
+   * @return Whether it changed, in which case routes planned before are wrong and
+   * the planner's cache must be cleared, which also drops any in flight.
+   */
+  bool SetAlliance(frc::DriverStation::Alliance alliance);
+
+  /**
+   * A field-relative pose, e.g. from an AprilTag, relative to the origin like the
+   * robot's pose.
+   */
+  frc::Pose2d FromField(frc::Pose2d field);
+
+  /**
+   * The corners to drive through to get from from to to, not including either, or
+   * nothing if it's a straight line or there's no way there.
+   */
+  std::vector<frc::Translation2d> Route(frc::Pose2d from, frc::Pose2d to);
+
+  /**
+   * A config for the align planner that drives it along these routes.
+   */
+  wom::HolonomicTrajectoryPlannerConfig PlannerConfig(wom::HolonomicTrajectoryPlannerConfig base = {});
+
+ private:
+  frc::Translation2d ToField(frc::Translation2d pose) const;
+  frc::Translation2d FromField(frc::Translation2d field) const;
+
+  FieldNavigationConfig _config;
+  frc::DriverStation::Alliance _alliance = frc::DriverStation::Alliance::kBlue;
+
+  std::mutex _mutex;
+  roadmap_t _roadmap;
+};
@@ -2,6 +2,7 @@
 
 #include "RobotMap.h"
 #include "Vision.h"
+#include "SensorFrame.h"
 
 #include <string>
 #include <iostream>
@@ -41,12 +42,17 @@ class Robot : public frc::TimedRobot {
   // void SimulationPeriodic() override;
 
  private:
+  friend class HeadlessSim;
+
   frc::EventLoop loop;
   
   //creates nessesary instances to use in robot.cpp and robotmap.h
   RobotMap map;
+  wom::SensorFrame sensors;
+  FieldNavigation fieldNavigation{map.fieldNavigation};
+  wom::HolonomicTrajectoryPlanner alignPlanner{fieldNavigation.PlannerConfig(map.swerveBase.alignPlanner)};
   Armavator *armavator;
-  wom::SwerveDrive *swerve;
+  wom::SwerveDrive<4> *swerve;
   bool intakeSol = false;
   bool gripperSol = false;
   Vision *vision;
@@ -56,4 +62,8 @@ class Robot : public frc::TimedRobot {
 
   units::meter_t _elevatorSetpoint = 0_m;
   units::radian_t _armSetpoint = 0_deg;
+
+  // Name in GetAutos() of the routine to run in autonomous
+  std::string _autoName = "Drive";
+  behaviour::Behaviour::ptr _auto;
 };
\ No newline at end of file
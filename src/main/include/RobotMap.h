@@ -3,6 +3,7 @@
 #include "Arm.h"
 #include "Elevator.h"
 #include "Armavator.h"
+#include "ArmElevatorCSpace.h"
 #include "SideIntake.h"
 #include "Gyro.h"
 #include "behaviour/ArmavatorBehaviour.h"
@@ -10,6 +11,7 @@
 #include "Gripper.h"
 #include "behaviour/VisionBehaviour.h"
 #include "TOF.h"
+#include "FieldNavigation.h"
 
 #include <ctre/phoenix/motorcontrol/can/WPI_TalonFX.h>
 #include <frc/Compressor.h>
@@ -19,6 +21,7 @@
 
 #include "drivetrain/SwerveDrive.h"
 #include <frc/DoubleSolenoid.h>
+#include <frc/Filesystem.h>
 #include <units/length.h>
 #include <units/angle.h>
 
@@ -50,7 +53,8 @@ struct RobotMap {
 
   ////stores nessesary info for swerve
   struct SwerveBase{
-    wom::NavX gyro;
+    // As fast as the NavX goes over SPI, to keep up with the odometry thread
+    wom::NavX gyro{200_Hz};
     wpi::array<WPI_TalonFX*, 4> turnMotors{
       new WPI_TalonFX(6), new WPI_TalonFX(4), new WPI_TalonFX(3), new WPI_TalonFX(1)
     };
@@ -138,25 +142,25 @@ struct RobotMap {
       //  12_V / 4_mps // webers per metre
 
     };
-    wom::SwerveDriveConfig::pose_angle_conf_t poseAnglePID {
+    wom::SwerveDriveConfig<4>::pose_angle_conf_t poseAnglePID {
       "/drivetrain/pid/pose/angle/config",
       180_deg / 1_s / 45_deg,
-      wom::SwerveDriveConfig::pose_angle_conf_t::ki_t{0.1},
+      wom::SwerveDriveConfig<4>::pose_angle_conf_t::ki_t{0.1},
       0_deg / 1_deg,
       10_deg,
       10_deg / 1_s
     };
-    wom::SwerveDriveConfig::pose_position_conf_t posePositionPID{
+    wom::SwerveDriveConfig<4>::pose_position_conf_t posePositionPID{
       "/drivetrain/pid/pose/position/config",
       3_mps / 1_m,
-      wom::SwerveDriveConfig::pose_position_conf_t::ki_t{0.1},
+      wom::SwerveDriveConfig<4>::pose_position_conf_t::ki_t{0.1},
       0_m / 1_m,
       20_cm, 
       10_cm / 1_s,
       10_cm,
     };
 
-    wom::SwerveDriveConfig config{
+    wom::SwerveDriveConfig<4> config{
       "/drivetrain",
       anglePID, velocityPID,
       moduleConfigs,// each module
@@ -168,7 +172,10 @@ struct RobotMap {
       {0.9, 0.9, 0.9}
     };  
 
+    wom::HolonomicTrajectoryPlannerConfig alignPlanner;
+
     SwerveBase() {
+      alignPlanner.moduleRadius = moduleConfigs[0].position.Norm();
       for (size_t i = 0; i < 4; i++) {
         turnMotors[i]->ConfigSupplyCurrentLimit(SupplyCurrentLimitConfiguration(true, 15, 15, 0));
         driveMotors[i]->SetNeutralMode(NeutralMode::Brake); // [Potential Issue]
@@ -191,6 +198,17 @@ struct RobotMap {
   };
   SwerveGridPoses swerveGridPoses;
 
+  FieldNavigationConfig fieldNavigation{
+    frc::Pose2d{1.93_m, 2.75_m, 0_deg}, // where auto starts, in front of the centre of the blue grids
+    0.5_m, // half the bumpers
+    5_cm,
+    {
+      swerveGridPoses.innerGrid1, swerveGridPoses.innerGrid2, swerveGridPoses.innerGrid3,
+      swerveGridPoses.centreGrid1, swerveGridPoses.centreGrid2, swerveGridPoses.centreGrid3,
+      swerveGridPoses.outerGrid1, swerveGridPoses.outerGrid2, swerveGridPoses.outerGrid3
+    }
+  };
+
   // struct IntakeSystem {
   //   WPI_TalonSRX rightMotor{98};
   //   WPI_VictorSPX leftMotor{99};
@@ -320,19 +338,38 @@ struct RobotMap {
     };
     Elevator elevator;
 
-    //creates the config for the occupancygrid 
-    ArmavatorConfig::grid_t occupancyGrid = ArmavatorConfig::grid_t(
+    //the shape of the robot the arm has to avoid, seen from the side with the elevator at x = 0
+    wom::ArmElevatorGeometry geometry {
+      arm.config.armLength,
+      0_m,
       arm.config.minAngle, arm.config.maxAngle,
       0_m, elevator.config.maxHeight,
-      50, 50
-    ).FillF([this](units::radian_t angle, units::meter_t height) {
-      units::meter_t x = arm.config.armLength * units::math::cos(angle);
-      units::meter_t y = height + arm.config.armLength * units::math::sin(angle);
-      return !(y >= 0.1_m && y <= 6_ft);
-    });
+      //the pivot, relative to the carriage, the same as the hand-written grid this replaced
+      0_m, 0_m,
+      //keep the end of the arm off the floor, and under the height limit
+      0.1_m, 6_ft,
+      //add the arm's thickness, the frame and intake here once they're measured,
+      //anything the arm can hit, and measure the pivot and floor from the floor
+      {}
+    };
+
+    //creates the config for the occupancygrid, from the geometry, only generated again when the geometry changes
+    ArmavatorConfig::grid_t occupancyGrid = wom::ArmElevatorCSpace::LoadOrGenerate(
+      geometry, 50, 50,
+      frc::filesystem::GetOperatingDirectory() + "/cspace"
+    );
 
     ArmavatorConfig config {
-      arm.config, elevator.config, occupancyGrid
+      arm.config, elevator.config, occupancyGrid,
+      //the codriver's A/B/X/Y positions, then the auto scoring positions
+      {
+        ArmavatorPosition{1.0_m, 0_deg},
+        ArmavatorPosition{1.2_m, -75_deg},
+        ArmavatorPosition{1.0_m, 90_deg},
+        ArmavatorPosition{0.77_m, 45_deg},
+        ArmavatorPosition{1.3_m, 45_deg},
+        ArmavatorPosition{1.0_m, -80_deg}
+      }
     };
   }; Armavator armavator;
 
@@ -4,6 +4,7 @@
 #include "behaviour/Behaviour.h"
 #include "Armavator.h"
 #include "Grid.h"
+#include "GridTrajectory.h"
 #include <units/angle.h>
 #include <units/length.h>
 #include <iostream>
@@ -12,6 +13,7 @@
 class ArmavatorGoToPositionBehaviour : public behaviour::Behaviour {
  public:
    using grid_t = ArmavatorConfig::grid_t;
+   using trajectory_t = wom::GridTrajectory<units::radian, units::meter>;
 
    //constructor for class
    ArmavatorGoToPositionBehaviour(Armavator *armavator, ArmavatorPosition setpoint);
@@ -25,7 +27,7 @@ class ArmavatorGoToPositionBehaviour : public behaviour::Behaviour {
    Armavator *_armavator;
 
    ArmavatorPosition _setpoint;
-   std::deque<grid_t::GridPathNode<units::second>> _waypoints;
+   trajectory_t _trajectory;
 };
 
 // class ArmavatorManualBehaviour : public behaviour::Behaviour {
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "drivetrain/SwerveDrive.h"
+#include "drivetrain/HolonomicTrajectory.h"
+#include "drivetrain/HolonomicTrajectoryPlanner.h"
 #include "behaviour/Behaviour.h"
 #include <ctre/Phoenix.h>
 #include <frc/XboxController.h>
@@ -13,13 +15,13 @@
 
 class ManualDrivebase : public behaviour::Behaviour{
  public:
-  ManualDrivebase(wom::SwerveDrive *swerveDrivebase, frc::XboxController *driverController);
+  ManualDrivebase(wom::SwerveDrive<4> *swerveDrivebase, frc::XboxController *driverController);
 
   void OnTick(units::second_t deltaTime) override;
   void OnStart();
 
  private:
-  wom::SwerveDrive *_swerveDrivebase;
+  wom::SwerveDrive<4> *_swerveDrivebase;
   frc::XboxController *_driverController;
   const double driverDeadzone = 0.08;
   const double turningDeadzone = 0.1;
@@ -35,32 +37,70 @@ class ManualDrivebase : public behaviour::Behaviour{
 
 class DrivebasePoseBehaviour : public behaviour::Behaviour{
  public:
-  DrivebasePoseBehaviour(wom::SwerveDrive *swerveDrivebase, frc::Pose2d pose, bool hold = false);
+  DrivebasePoseBehaviour(wom::SwerveDrive<4> *swerveDrivebase, frc::Pose2d pose, bool hold = false);
   void OnTick(units::second_t deltaTime) override;
  
  private:
-  wom::SwerveDrive *_swerveDrivebase;
+  wom::SwerveDrive<4> *_swerveDrivebase;
   frc::Pose2d _pose;
   bool _hold;
   std::shared_ptr<nt::NetworkTable> _swerveDriveTable = nt::NetworkTableInstance::GetDefault().GetTable("swerve");
 };
 
+/**
+ * Follow a precomputed trajectory, using its velocity as feedforward to the pose
+ * PID loops. Finishes once the trajectory has ended and the drivebase has settled.
+ */
+class FollowTrajectory : public behaviour::Behaviour{
+ public:
+  FollowTrajectory(wom::SwerveDrive<4> *swerveDrivebase, std::shared_ptr<wom::HolonomicTrajectory> trajectory);
+
+  void OnStart() override;
+  void OnTick(units::second_t deltaTime) override;
+
+ private:
+  wom::SwerveDrive<4> *_swerveDrivebase;
+  std::shared_ptr<wom::HolonomicTrajectory> _trajectory;
+  units::second_t _time{0};
+  std::shared_ptr<nt::NetworkTable> _swerveDriveTable = nt::NetworkTableInstance::GetDefault().GetTable("swerve");
+};
+
+/**
+ * Drive to a pose along a trajectory from the planner. Holds position for the
+ * tick or two it takes to generate a trajectory that isn't already cached.
+ */
+class DrivebaseAlign : public behaviour::Behaviour{
+ public:
+  DrivebaseAlign(wom::SwerveDrive<4> *swerveDrivebase, wom::HolonomicTrajectoryPlanner *planner, frc::Pose2d target);
+
+  void OnStart() override;
+  void OnTick(units::second_t deltaTime) override;
+
+ private:
+  wom::SwerveDrive<4> *_swerveDrivebase;
+  wom::HolonomicTrajectoryPlanner *_planner;
+  frc::Pose2d _target;
+  frc::Pose2d _start;
+  std::shared_ptr<wom::HolonomicTrajectory> _trajectory;
+  units::second_t _time{0};
+};
+
 class DrivebaseBalance : public behaviour::Behaviour{
  public:
-  DrivebaseBalance(wom::SwerveDrive *swerveDrivebase, wom::NavX *gyro);
+  DrivebaseBalance(wom::SwerveDrive<4> *swerveDrivebase, wom::NavX *gyro);
 
   void OnTick(units::second_t deltaTime) override;
 
 
  private:
-  wom::SwerveDrive *_swerveDrivebase;
+  wom::SwerveDrive<4> *_swerveDrivebase;
   wom::NavX *_gyro;
 
-  wom::SwerveDriveConfig::balance_conf_t balancePIDConfig{
-    "swerve/balancePID/",
+  wom::SwerveDriveConfig<4>::balance_conf_t balancePIDConfig{
+    "swerve/balancePID",
     0.7_mps / 10_deg,
-    wom::SwerveDriveConfig::balance_conf_t::ki_t{0.00},
-    wom::SwerveDriveConfig::balance_conf_t::kd_t{0}
+    wom::SwerveDriveConfig<4>::balance_conf_t::ki_t{0.00},
+    wom::SwerveDriveConfig<4>::balance_conf_t::kd_t{0}
   };
   wom::PIDController<units::degree, units::meters_per_second> lateralBalancePID{
     "swerve/balancePID",
@@ -77,9 +117,9 @@ class DrivebaseBalance : public behaviour::Behaviour{
 
 class XDrivebase : public behaviour::Behaviour{
  public:
-  XDrivebase(wom::SwerveDrive *swerveDrivebase);
+  XDrivebase(wom::SwerveDrive<4> *swerveDrivebase);
   void OnTick(units::second_t deltaTime) override;
 
  private:
-  wom::SwerveDrive *_swerveDrivebase;
+  wom::SwerveDrive<4> *_swerveDrivebase;
 };
\ No newline at end of file
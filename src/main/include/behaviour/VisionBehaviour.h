@@ -9,12 +9,12 @@
 class VisionBehaviour : public behaviour::Behaviour {
  public:
   // VisionBehaviour(Vision *vision, frc::XboxController *codriver);
-  VisionBehaviour(Vision *vision, wom::SwerveDrive *swerveDrivebase, frc::XboxController *codriver);
+  VisionBehaviour(Vision *vision, wom::SwerveDrive<4> *swerveDrivebase, frc::XboxController *codriver);
 
   void OnTick(units::second_t dt) override;
 
  private: 
-  wom::SwerveDrive *_swerveDrivebase;
+  wom::SwerveDrive<4> *_swerveDrivebase;
   Vision *_vision;
   frc::XboxController *_codriver;
 };
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "ChargeStationSim.h"
+
+#include <units/math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ChargeStationSim::ChargeStationSim(ChargeStationConfig config, wom::sim::SwerveDriveSim<4> *drive)
+  : config(config), _drive(drive) { }
+
+std::pair<double, double> ChargeStationSim::Footprint() const {
+  if (units::math::abs(_drive->y - config.y) > config.width / 2)
+    return { 0, 0 };
+
+  // Extent of the wheelbase along the world x axis
+  double heading = _drive->angle.value();
+  double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+  for (auto &module : _drive->config.modules) {
+    double x = module.position.X().value() * std::cos(heading) - module.position.Y().value() * std::sin(heading);
+    lo = std::min(lo, x);
+    hi = std::max(hi, x);
+  }
+
+  double centre = (_drive->x - config.x).value();
+  double half = config.depth.value() / 2;
+  double a = std::max(centre + lo, -half), b = std::min(centre + hi, half);
+  if (b <= a)
+    return { 0, 0 };
+
+  // The robot's weight is spread evenly along its length
+  return { hi > lo ? (b - a) / (hi - lo) : 1, (a + b) / 2 };
+}
+
+void ChargeStationSim::Update(units::second_t dt) {
+  auto [fraction, arm] = Footprint();
+  load = fraction;
+
+  double m = load * _drive->config.mass.value();
+  double g = 9.81;
+  double height = config.comHeight.value();
+  double J = config.platformJ.value() + m * (arm * arm + height * height);
+  double limit = units::radian_t{config.maxAngle}.value();
+
+  // The hinge's friction sticks, which an ODE integrator handles badly, so step
+  // semi-implicitly by hand. The robot's centre of mass is above the hinge, so
+  // tipping moves it further the way the platform is tipping.
+  int substeps = std::max((int)std::ceil((dt / 1_ms).value()), 1);
+  double step = dt.value() / substeps;
+  double w = angularVelocity.value(), theta = angle.value();
+  for (int i = 0; i < substeps; i++) {
+    double gravity = m * g * (arm + height * std::sin(theta));
+    if (w == 0 && std::abs(gravity) <= config.friction)
+      continue;
+
+    double torque = gravity - config.damping * w - std::copysign(config.friction, w != 0 ? w : gravity);
+    double next = w + torque / J * step;
+    // Friction stops the platform rather than reversing it
+    w = (w != 0 && next * w < 0) ? 0 : next;
+    theta += w * step;
+
+    // Resting on the floor
+    if (std::abs(theta) >= limit) {
+      theta = std::copysign(limit, theta);
+      if (w * theta > 0)
+        w = 0;
+    }
+  }
+  angularVelocity = units::radians_per_second_t{w};
+  angle = units::radian_t{theta};
+
+  // Gravity pulls the robot down the slope, towards +x with the +x edge down
+  _drive->externalForce = Eigen::Vector2d{ m * g * std::sin(theta) * std::cos(theta), 0 };
+
+  // A robot half on the platform is tipped about half as far, as it would be on the ramp
+  double tilt = load * theta;
+  double heading = _drive->angle.value();
+  _drive->pitch = units::radian_t{tilt * std::cos(heading)};
+  _drive->roll = units::radian_t{tilt * std::sin(heading)};
+}
+
+bool ChargeStationSim::IsLevel() const {
+  return units::math::abs(angle) <= config.levelTolerance;
+}
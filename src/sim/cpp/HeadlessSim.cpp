@@ -0,0 +1,395 @@
+#include "HeadlessSim.h"
+#include "Auto.h"
+
+#include <frc/simulation/BatterySim.h>
+#include <frc/simulation/DriverStationSim.h>
+#include <frc/simulation/RoboRioSim.h>
+#include <frc/simulation/SimHooks.h>
+#include <hal/HALBase.h>
+#include <networktables/NetworkTableInstance.h>
+#include <wpi/json.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numbers>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+HeadlessSim::HeadlessSim(HeadlessSimConfig config) : _config(config), _rng(config.variation.seed) {
+  if (GetAutos().find(_config.autoName) == GetAutos().end())
+    throw std::invalid_argument("Unknown auto " + _config.autoName);
+
+  HAL_Initialize(500, 0);
+
+  // Time only moves when we step it. Behaviours are ticked with the robot loop
+  // rather than on their own threads, which would run in real time.
+  frc::sim::PauseTiming();
+  behaviour::BehaviourScheduler::GetInstance()->SetStepped(true);
+
+  frc::sim::DriverStationSim::SetDsAttached(true);
+  frc::sim::DriverStationSim::SetAutonomous(true);
+  frc::sim::DriverStationSim::SetEnabled(true);
+  frc::sim::DriverStationSim::NotifyNewData();
+
+  _robot = std::make_unique<Robot>();
+  _robot->_autoName = _config.autoName;
+  _robot->RobotInit();
+
+  // The robot's config is what the code believes, the sim gets the real robot
+  wom::SwerveDriveConfig<4> simConfig = _robot->map.swerveBase.config;
+  ApplyVariation(simConfig);
+  _sim = std::make_unique<wom::sim::SwerveDriveSim<4>>(simConfig, _config.moduleJ, _config.sim);
+
+  if (_config.balanceStart.has_value() && !_config.chargeStation.has_value())
+    _config.chargeStation = ChargeStationConfig{};
+  if (_config.chargeStation.has_value())
+    _chargeStation = std::make_unique<ChargeStationSim>(_config.chargeStation.value(), _sim.get());
+}
+
+HeadlessSim::~HeadlessSim() {
+  frc::sim::DriverStationSim::SetEnabled(false);
+  frc::sim::DriverStationSim::NotifyNewData();
+  frc::sim::ResumeTiming();
+}
+
+double HeadlessSim::Normal(double stddev) {
+  return stddev > 0 ? std::normal_distribution<double>{0, stddev}(_rng) : 0;
+}
+
+void HeadlessSim::ApplyVariation(wom::SwerveDriveConfig<4> &config) {
+  const HeadlessSimVariation &v = _config.variation;
+  auto scale = [&](double error) { return std::max(1 + Normal(error), 0.1); };
+
+  auto vary = [&](const wom::DCMotor &motor) {
+    return wom::DCMotor{
+      motor.nominalVoltage, motor.stallTorque * scale(v.motorConstantError),
+      motor.stallCurrent, motor.freeCurrent, motor.freeSpeed * scale(v.motorConstantError)
+    };
+  };
+
+  for (size_t i = 0; i < config.modules.size(); i++) {
+    config.modules[i].driveMotor.motor = vary(config.modules[i].driveMotor.motor);
+    config.modules[i].turnMotor.motor = vary(config.modules[i].turnMotor.motor);
+    _wheelSlip[i] = v.wheelSlip * std::uniform_real_distribution<double>{0, 1}(_rng);
+  }
+  config.mass = config.mass * scale(v.massError);
+
+  wom::sim::SimGyroConfig &gyro = _config.sim.gyro;
+  gyro.angleNoise = v.gyroNoise;
+  gyro.rateNoise = v.gyroRateNoise;
+  gyro.tiltNoise = v.gyroNoise;
+  gyro.bias = units::degrees_per_second_t{Normal(v.gyroBias.value())};
+  gyro.biasDrift = v.gyroBiasDrift;
+  gyro.latency = v.gyroLatency;
+  gyro.seed = _rng();
+  _batteryResistance = v.batteryResistance * scale(v.batteryResistanceError);
+}
+
+void HeadlessSim::ReadSensors() {
+  const HeadlessSimVariation &v = _config.variation;
+
+  // The sim sets perfect encoder readings, overwrite them with what the sensors
+  // would see. The sim's gyro model already adds the gyro's errors.
+  for (size_t i = 0; i < 4; i++) {
+    double drive = _sim->driveEncoderAngles(i) * (1 + _wheelSlip[i]) + Normal(v.encoderNoise.value());
+    double turn = _sim->turnAngles(i) + Normal(v.encoderNoise.value());
+    _sim->driveEncoders[i]->SetEncoderTurns(units::radian_t{drive});
+    _sim->turnEncoders[i]->SetEncoderTurns(units::radian_t{turn});
+  }
+
+  units::volt_t battery = frc::sim::BatterySim::Calculate(
+    _config.variation.batteryVoltage, _batteryResistance, { units::math::abs(_sim->totalCurrent) }
+  );
+  frc::sim::RoboRioSim::SetVInVoltage(battery);
+}
+
+HeadlessSimResult HeadlessSim::Run() {
+  using clock = std::chrono::steady_clock;
+
+  std::string name = _config.balanceStart.has_value() ? "balance" : _config.stepTarget.has_value() ? "step" : _config.autoName;
+  HeadlessSimResult result{ name, _config.variation.seed };
+  result.peakCurrent = 0_A;
+  result.steps = 0;
+  result.maxStepMicroseconds = 0;
+
+  auto start = clock::now();
+
+  // Start away from where the auto expects. The sensors see the start pose before
+  // the auto resets the robot's pose, so the robot believes it is where it should be.
+  const HeadlessSimVariation &v = _config.variation;
+  _sim->x = units::meter_t{Normal(v.startPositionError.value())};
+  _sim->y = units::meter_t{Normal(v.startPositionError.value())};
+  _sim->angle = units::degree_t{Normal(v.startHeadingError.value())};
+
+  if (_config.balanceStart.has_value()) {
+    // Already on the platform, which has tipped under the robot
+    units::meter_t start = _config.balanceStart.value();
+    _sim->x += _chargeStation->config.x + start;
+    _sim->y += _chargeStation->config.y;
+    _chargeStation->angle = start >= 0_m ? _chargeStation->config.maxAngle : -_chargeStation->config.maxAngle;
+  }
+  if (_chargeStation)
+    _chargeStation->Update(0_s);
+
+  // Let the sensors see the start pose
+  _sim->Update(0_s);
+  ReadSensors();
+  _robot->RobotPeriodic();
+
+  if (_config.balanceStart.has_value()) {
+    _robot->swerve->OnStart();
+    _robot->swerve->ResetPose(frc::Pose2d{ _sim->x, _sim->y, _sim->angle });
+    _robot->_auto = behaviour::make<DrivebaseBalance>(_robot->swerve, &_robot->map.swerveBase.gyro);
+    behaviour::BehaviourScheduler::GetInstance()->Schedule(_robot->_auto);
+  } else if (_config.stepTarget.has_value()) {
+    // Hold the target until the timeout
+    _robot->swerve->OnStart();
+    _robot->swerve->ResetPose(frc::Pose2d());
+    _robot->_auto = behaviour::make<DrivebasePoseBehaviour>(_robot->swerve, _config.stepTarget.value(), true);
+    behaviour::BehaviourScheduler::GetInstance()->Schedule(_robot->_auto);
+  } else {
+    _robot->AutonomousInit();
+  }
+
+  // After the auto is built, as behaviours that own a PIDConfig write its
+  // defaults to NT when they're constructed.
+  if (!_config.ntOverrides.empty()) {
+    auto nt = nt::NetworkTableInstance::GetDefault();
+    for (auto &[topic, value] : _config.ntOverrides) {
+      // Nothing would be listening, so the run would silently use the defaults
+      nt::NetworkTableEntry entry = nt.GetEntry(topic);
+      if (!entry.Exists())
+        throw std::invalid_argument("Nothing publishes " + topic + " to --set");
+      entry.SetDouble(value);
+    }
+    // PIDConfigs are updated by NT listeners, which run on another thread
+    nt.WaitForListenerQueue(1.0);
+  }
+
+  Record();
+
+  while (!_robot->_auto->IsFinished() && _time < _config.timeout) {
+    auto stepStart = clock::now();
+
+    // Notifiers aren't used, the robot loop is called directly, so there's
+    // nothing for StepTiming to wait on.
+    frc::sim::StepTimingAsync(_config.dt);
+    _time += _config.dt;
+
+    // The charge station tips under where the robot is now, then the drivetrain
+    // moves under the slope and sees the tilt.
+    if (_chargeStation)
+      _chargeStation->Update(_config.dt);
+    _sim->Update(_config.dt);
+    ReadSensors();
+    _robot->AutonomousPeriodic();
+    _robot->RobotPeriodic();
+
+    double stepMicroseconds = std::chrono::duration<double, std::micro>(clock::now() - stepStart).count();
+    result.maxStepMicroseconds = std::max(result.maxStepMicroseconds, stepMicroseconds);
+    result.steps++;
+
+    Record();
+  }
+
+  result.wallSeconds = std::chrono::duration<double>(clock::now() - start).count();
+
+  if (!_robot->_auto->IsFinished()) {
+    _robot->_auto->Interrupt();
+    result.state = behaviour::BehaviourState::TIMED_OUT;
+  } else {
+    result.state = _robot->_auto->GetBehaviourState();
+  }
+
+  if (_config.stepTarget.has_value() || _config.balanceStart.has_value()) {
+    // Held until the timeout on purpose
+    result.state = behaviour::BehaviourState::DONE;
+  }
+  if (_config.stepTarget.has_value())
+    result.stepResponse = MeasureStepResponse(_config.stepTarget.value());
+  if (_chargeStation)
+    result.balance = MeasureBalance();
+
+  result.simTime = _time;
+  result.finalPose = _trace.back().pose;
+  result.finalEstimatedPose = _trace.back().estimatedPose;
+  for (auto &sample : _trace)
+    result.peakCurrent = units::math::max(result.peakCurrent, sample.current);
+
+  if (!_config.tracePath.empty())
+    WriteTrace(result);
+
+  return result;
+}
+
+void HeadlessSim::Record() {
+  _trace.push_back(HeadlessSimSample{
+    _time,
+    frc::Pose2d{ _sim->x, _sim->y, _sim->angle },
+    _robot->swerve->GetPose(),
+    _sim->vx, _sim->vy,
+    _sim->angularVelocity,
+    _sim->totalCurrent,
+    _chargeStation ? _chargeStation->angle : 0_rad
+  });
+}
+
+HeadlessSimResult::StepResponse HeadlessSim::MeasureStepResponse(frc::Pose2d target) const {
+  // The step is from the origin
+  frc::Translation2d step = target.Translation();
+  double distance = step.Norm().value();
+  double turn = target.Rotation().Radians().value();
+
+  double positionBand = std::max(0.02 * distance, 0.02);
+  double headingBand = std::max(0.02 * std::abs(turn), units::radian_t{1_deg}.value());
+
+  HeadlessSimResult::StepResponse response{ std::nullopt, 0 };
+  for (auto &sample : _trace) {
+    frc::Translation2d error = sample.pose.Translation() - target.Translation();
+    double headingError = std::remainder(sample.pose.Rotation().Radians().value() - turn, 2 * std::numbers::pi);
+
+    // Past the target along the direction of the step
+    if (distance > 0)
+      response.overshoot = std::max(response.overshoot, (error.X() * step.X() + error.Y() * step.Y()).value() / (distance * distance));
+    if (turn != 0)
+      response.overshoot = std::max(response.overshoot, headingError / turn);
+
+    bool settled = error.Norm().value() <= positionBand && std::abs(headingError) <= headingBand;
+    if (!settled)
+      response.settlingTime.reset();
+    else if (!response.settlingTime.has_value())
+      response.settlingTime = sample.time;
+  }
+  return response;
+}
+
+HeadlessSimResult::Balance HeadlessSim::MeasureBalance() const {
+  double tolerance = units::radian_t{_chargeStation->config.levelTolerance}.value();
+
+  HeadlessSimResult::Balance balance{ std::nullopt, 0, _trace.back().stationAngle };
+  int side = 0;
+  for (auto &sample : _trace) {
+    double angle = sample.stationAngle.value();
+
+    // Only count tipping past level by more than the tolerance, so noise about level isn't an oscillation
+    if (std::abs(angle) > tolerance) {
+      int now = angle > 0 ? 1 : -1;
+      if (side != 0 && now != side)
+        balance.oscillations++;
+      side = now;
+      balance.timeToBalance.reset();
+    } else if (!balance.timeToBalance.has_value()) {
+      balance.timeToBalance = sample.time;
+    }
+  }
+  return balance;
+}
+
+static std::string StateName(behaviour::BehaviourState state) {
+  switch (state) {
+    case behaviour::BehaviourState::DONE: return "done";
+    case behaviour::BehaviourState::TIMED_OUT: return "timed out";
+    case behaviour::BehaviourState::INTERRUPTED: return "interrupted";
+    default: return "running";
+  }
+}
+
+static wpi::json SummaryJson(const HeadlessSimResult &result) {
+  wpi::json summary{
+    { "auto", result.autoName },
+    { "seed", result.seed },
+    { "result", StateName(result.state) },
+    { "simTime", result.simTime.value() },
+    { "finalPose", { result.finalPose.X().value(), result.finalPose.Y().value(), result.finalPose.Rotation().Degrees().value() } },
+    { "finalEstimatedPose", { result.finalEstimatedPose.X().value(), result.finalEstimatedPose.Y().value(), result.finalEstimatedPose.Rotation().Degrees().value() } },
+    { "peakCurrent", result.peakCurrent.value() },
+    { "steps", result.steps },
+    { "wallTime", result.wallSeconds },
+    { "maxStepMicroseconds", result.maxStepMicroseconds }
+  };
+
+  if (result.stepResponse.has_value()) {
+    auto &step = result.stepResponse.value();
+    summary["settlingTime"] = step.settlingTime.has_value() ? wpi::json(step.settlingTime.value().value()) : wpi::json(nullptr);
+    summary["overshoot"] = step.overshoot;
+  }
+
+  if (result.balance.has_value()) {
+    auto &balance = result.balance.value();
+    summary["timeToBalance"] = balance.timeToBalance.has_value() ? wpi::json(balance.timeToBalance.value().value()) : wpi::json(nullptr);
+    summary["oscillations"] = balance.oscillations;
+    summary["finalStationAngle"] = balance.finalAngle.convert<units::degree>().value();
+  }
+  return summary;
+}
+
+void HeadlessSim::WriteTrace(const HeadlessSimResult &result) const {
+  std::ofstream out(_config.tracePath);
+  if (!out) {
+    std::cerr << "Could not write trace " << _config.tracePath << std::endl;
+    return;
+  }
+
+  bool json = _config.tracePath.size() >= 5 && _config.tracePath.compare(_config.tracePath.size() - 5, 5, ".json") == 0;
+
+  if (json) {
+    wpi::json trace = wpi::json::array();
+    for (auto &s : _trace) {
+      trace.push_back(wpi::json{
+        { "time", s.time.value() },
+        { "x", s.pose.X().value() }, { "y", s.pose.Y().value() }, { "heading", s.pose.Rotation().Degrees().value() },
+        { "estX", s.estimatedPose.X().value() }, { "estY", s.estimatedPose.Y().value() }, { "estHeading", s.estimatedPose.Rotation().Degrees().value() },
+        { "vx", s.vx.value() }, { "vy", s.vy.value() }, { "omega", s.omega.value() },
+        { "current", s.current.value() },
+        { "station", s.stationAngle.convert<units::degree>().value() }
+      });
+    }
+    out << wpi::json{ { "summary", SummaryJson(result) }, { "trace", trace } }.dump(2) << std::endl;
+  } else {
+    out << "time,x,y,heading,est_x,est_y,est_heading,vx,vy,omega,current,station\n";
+    for (auto &s : _trace) {
+      out << s.time.value() << ","
+          << s.pose.X().value() << "," << s.pose.Y().value() << "," << s.pose.Rotation().Degrees().value() << ","
+          << s.estimatedPose.X().value() << "," << s.estimatedPose.Y().value() << "," << s.estimatedPose.Rotation().Degrees().value() << ","
+          << s.vx.value() << "," << s.vy.value() << "," << s.omega.value() << ","
+          << s.current.value() << "," << s.stationAngle.convert<units::degree>().value() << "\n";
+    }
+  }
+}
+
+void HeadlessSim::PrintSummaryJson(const HeadlessSimResult &result, std::ostream &out) {
+  out << SummaryJson(result).dump() << std::endl;
+}
+
+void HeadlessSim::PrintSummary(const HeadlessSimResult &result, std::ostream &out) {
+  out << result.autoName << ": " << StateName(result.state) << " after " << result.simTime.value() << "s sim time" << std::endl;
+  out << "  final pose      " << result.finalPose.X().value() << "m, " << result.finalPose.Y().value() << "m, "
+      << result.finalPose.Rotation().Degrees().value() << "deg" << std::endl;
+  out << "  estimated pose  " << result.finalEstimatedPose.X().value() << "m, " << result.finalEstimatedPose.Y().value() << "m, "
+      << result.finalEstimatedPose.Rotation().Degrees().value() << "deg" << std::endl;
+  out << "  peak current    " << result.peakCurrent.value() << "A" << std::endl;
+  if (result.stepResponse.has_value()) {
+    auto &step = result.stepResponse.value();
+    out << "  settling time   ";
+    if (step.settlingTime.has_value())
+      out << step.settlingTime.value().value() << "s" << std::endl;
+    else
+      out << "never settled" << std::endl;
+    out << "  overshoot       " << step.overshoot * 100 << "%" << std::endl;
+  }
+  if (result.balance.has_value()) {
+    auto &balance = result.balance.value();
+    out << "  time to balance ";
+    if (balance.timeToBalance.has_value())
+      out << balance.timeToBalance.value().value() << "s" << std::endl;
+    else
+      out << "not balanced" << std::endl;
+    out << "  oscillations    " << balance.oscillations << std::endl;
+    out << "  station angle   " << balance.finalAngle.convert<units::degree>().value() << "deg" << std::endl;
+  }
+  out << "  " << result.steps << " steps in " << result.wallSeconds << "s wall time ("
+      << (result.wallSeconds > 0 ? result.simTime.value() / result.wallSeconds : 0) << "x real time), slowest step "
+      << result.maxStepMicroseconds << "us" << std::endl;
+}
@@ -0,0 +1,135 @@
+/*
+  Headless simulator. Runs an auto from Auto.cpp against the simulated drivetrain
+  as fast as possible, e.g.
+    headlessSim --auto BLUE_Top_Triple --trace triple.csv
+*/
+
+#include "HeadlessSim.h"
+#include "Auto.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+static void Usage() {
+  std::cerr << "Usage: headlessSim [--auto NAME] [--dt SECONDS] [--timeout SECONDS]" << std::endl
+            << "                   [--integrator euler|semi-implicit|rk4] [--trace PATH.csv|PATH.json] [--json] [--list]" << std::endl
+            << "                   [--step X Y HEADING] [--set TOPIC=VALUE]..." << std::endl
+            << "                   [--charge-station X] [--balance OFFSET]" << std::endl
+            << "--step holds a pose setpoint (metres, degrees) until the timeout instead of running an auto." << std::endl
+            << "--charge-station puts the charge station's hinge at X metres." << std::endl
+            << "--balance starts on the charge station OFFSET metres from the hinge and balances until the timeout." << std::endl
+            << "--set sets an NT value, e.g. a PID gain: --set /drivetrain/pid/pose/angle/config/kP=5" << std::endl
+            << "Variation (standard deviations unless noted, default 0):" << std::endl
+            << "  --seed N" << std::endl
+            << "  --start-position-error METRES    --start-heading-error DEGREES" << std::endl
+            << "  --motor-error FRACTION           --mass-error FRACTION" << std::endl
+            << "  --wheel-slip FRACTION (maximum)  --battery-resistance-error FRACTION" << std::endl
+            << "  --encoder-noise RADIANS          --gyro-noise DEGREES" << std::endl
+            << "  --gyro-rate-noise DEG/S          --gyro-bias DEG/S" << std::endl
+            << "  --gyro-drift DEG/S/SQRT(S)       --gyro-latency SECONDS (fixed)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  HeadlessSimConfig config;
+  config.sim.publishNT = false;
+  bool json = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--list") {
+      for (auto &[name, factory] : GetAutos())
+        std::cout << name << std::endl;
+      return 0;
+    } else if (arg == "--auto" && hasValue) {
+      config.autoName = argv[++i];
+    } else if (arg == "--dt" && hasValue) {
+      config.dt = units::second_t{std::stod(argv[++i])};
+    } else if (arg == "--timeout" && hasValue) {
+      config.timeout = units::second_t{std::stod(argv[++i])};
+    } else if (arg == "--trace" && hasValue) {
+      config.tracePath = argv[++i];
+    } else if (arg == "--step" && i + 3 < argc) {
+      units::meter_t x{std::stod(argv[++i])};
+      units::meter_t y{std::stod(argv[++i])};
+      units::degree_t heading{std::stod(argv[++i])};
+      config.stepTarget = frc::Pose2d{x, y, heading};
+    } else if (arg == "--charge-station" && hasValue) {
+      config.chargeStation = ChargeStationConfig{};
+      config.chargeStation->x = units::meter_t{std::stod(argv[++i])};
+    } else if (arg == "--balance" && hasValue) {
+      config.balanceStart = units::meter_t{std::stod(argv[++i])};
+    } else if (arg == "--set" && hasValue) {
+      std::string value = argv[++i];
+      size_t eq = value.find('=');
+      if (eq == std::string::npos) {
+        Usage();
+        return 2;
+      }
+      config.ntOverrides[value.substr(0, eq)] = std::stod(value.substr(eq + 1));
+    } else if (arg == "--json") {
+      json = true;
+    } else if (arg == "--seed" && hasValue) {
+      config.variation.seed = (unsigned int)std::stoul(argv[++i]);
+    } else if (arg == "--start-position-error" && hasValue) {
+      config.variation.startPositionError = units::meter_t{std::stod(argv[++i])};
+    } else if (arg == "--start-heading-error" && hasValue) {
+      config.variation.startHeadingError = units::degree_t{std::stod(argv[++i])};
+    } else if (arg == "--motor-error" && hasValue) {
+      config.variation.motorConstantError = std::stod(argv[++i]);
+    } else if (arg == "--mass-error" && hasValue) {
+      config.variation.massError = std::stod(argv[++i]);
+    } else if (arg == "--wheel-slip" && hasValue) {
+      config.variation.wheelSlip = std::stod(argv[++i]);
+    } else if (arg == "--battery-resistance-error" && hasValue) {
+      config.variation.batteryResistanceError = std::stod(argv[++i]);
+    } else if (arg == "--encoder-noise" && hasValue) {
+      config.variation.encoderNoise = units::radian_t{std::stod(argv[++i])};
+    } else if (arg == "--gyro-noise" && hasValue) {
+      config.variation.gyroNoise = units::degree_t{std::stod(argv[++i])};
+    } else if (arg == "--gyro-rate-noise" && hasValue) {
+      config.variation.gyroRateNoise = units::degrees_per_second_t{std::stod(argv[++i])};
+    } else if (arg == "--gyro-bias" && hasValue) {
+      config.variation.gyroBias = units::degrees_per_second_t{std::stod(argv[++i])};
+    } else if (arg == "--gyro-drift" && hasValue) {
+      config.variation.gyroBiasDrift = std::stod(argv[++i]);
+    } else if (arg == "--gyro-latency" && hasValue) {
+      config.variation.gyroLatency = units::second_t{std::stod(argv[++i])};
+    } else if (arg == "--integrator" && hasValue) {
+      std::string name = argv[++i];
+      if (name == "euler") config.sim.integrator = wom::sim::Integrator::kEuler;
+      else if (name == "semi-implicit") config.sim.integrator = wom::sim::Integrator::kSemiImplicitEuler;
+      else if (name == "rk4") config.sim.integrator = wom::sim::Integrator::kRK4;
+      else {
+        Usage();
+        return 2;
+      }
+    } else {
+      Usage();
+      return 2;
+    }
+  }
+
+  if (GetAutos().find(config.autoName) == GetAutos().end()) {
+    std::cerr << "Unknown auto " << config.autoName << ", see --list" << std::endl;
+    return 2;
+  }
+
+  HeadlessSim sim{config};
+  HeadlessSimResult result;
+  try {
+    result = sim.Run();
+  } catch (std::invalid_argument &e) {
+    std::cerr << e.what() << std::endl;
+    return 2;
+  }
+  if (json)
+    HeadlessSim::PrintSummaryJson(result, std::cout);
+  else
+    HeadlessSim::PrintSummary(result, std::cout);
+
+  return result.Finished() ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "drivetrain/SwerveDrive.h"
+
+#include <units/angle.h>
+#include <units/angular_velocity.h>
+#include <units/length.h>
+#include <units/moment_of_inertia.h>
+#include <units/time.h>
+
+#include <utility>
+
+/**
+ * The charge station, as a platform hinged across its middle that tips under the
+ * robot's weight until one edge rests on the floor. The ramps aren't modelled,
+ * the robot drives straight from the floor onto the platform.
+ */
+struct ChargeStationConfig {
+  // Centre of the hinge in the sim's world frame. The platform tips about the world y axis.
+  units::meter_t x = 2.2_m;
+  units::meter_t y = 0_m;
+
+  // Platform top, along and across the direction it tips
+  units::meter_t depth = 48_in;
+  units::meter_t width = 8_ft;
+
+  // Where an edge of the platform hits the floor
+  units::degree_t maxAngle = 15_deg;
+
+  units::kilogram_square_meter_t platformJ{4};
+  // Friction in the hinge. Viscous in N m per rad/s, and Coulomb in N m, which
+  // holds the platform still until the robot is far enough off centre.
+  double damping = 30;
+  double friction = 60;
+
+  // Height of the robot's centre of mass above the hinge
+  units::meter_t comHeight = 0.3_m;
+
+  // Counts as balanced within this of level
+  units::degree_t levelTolerance = 2.5_deg;
+};
+
+class ChargeStationSim {
+ public:
+  ChargeStationSim(ChargeStationConfig config, wom::sim::SwerveDriveSim<4> *drive);
+
+  /**
+   * Tip the platform under the robot, holding the robot where it is over the
+   * step, then set the drivetrain's tilt and the force of the slope on it for
+   * its next Update.
+   */
+  void Update(units::second_t dt);
+
+  bool IsLevel() const;
+
+  ChargeStationConfig config;
+
+  // Positive with the +x edge down
+  units::radian_t angle{0};
+  units::radians_per_second_t angularVelocity{0};
+
+  // Fraction of the robot's length over the platform
+  double load = 0;
+
+ private:
+  // Fraction of the robot over the platform and its lever arm about the hinge (m)
+  std::pair<double, double> Footprint() const;
+
+  wom::sim::SwerveDriveSim<4> *_drive;
+};
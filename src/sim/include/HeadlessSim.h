@@ -0,0 +1,192 @@
+#pragma once
+
+#include "Robot.h"
+#include "ChargeStationSim.h"
+
+#include <frc/geometry/Pose2d.h>
+#include <units/angular_velocity.h>
+#include <units/impedance.h>
+#include <units/moment_of_inertia.h>
+#include <units/time.h>
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Random differences between the simulated robot and the one the code expects,
+ * for checking how robust an auto is. Errors are standard deviations unless noted.
+ * All zero (the default) is the ideal robot.
+ */
+struct HeadlessSimVariation {
+  unsigned int seed = 0;
+
+  // Where the robot actually starts relative to where the auto assumes
+  units::meter_t startPositionError = 0_m;
+  units::degree_t startHeadingError = 0_deg;
+
+  // Relative error of each motor's stall torque and free speed
+  double motorConstantError = 0;
+  // Relative error of the robot's mass
+  double massError = 0;
+  // Each module's wheel spins up to this fraction faster than the robot moves (uniform)
+  double wheelSlip = 0;
+
+  // Noise on every encoder and gyro reading
+  units::radian_t encoderNoise = 0_rad;
+  units::degree_t gyroNoise = 0_deg;
+  units::degrees_per_second_t gyroRateNoise{0};
+
+  // Gyro rate bias at the start, and its random walk in deg/s per sqrt(s)
+  units::degrees_per_second_t gyroBias{0};
+  double gyroBiasDrift = 0;
+  // Age of each gyro reading when the robot sees it (fixed)
+  units::second_t gyroLatency = 0_s;
+
+  // Battery sag, from the total current through the battery's internal resistance
+  units::volt_t batteryVoltage = 12.5_V;
+  units::ohm_t batteryResistance = 0.02_Ohm;
+  double batteryResistanceError = 0;
+};
+
+struct HeadlessSimConfig {
+  // Name of the routine in GetAutos()
+  std::string autoName = "Drive";
+
+  units::second_t dt = 20_ms;
+  // The auto is stopped if it hasn't finished by now
+  units::second_t timeout = 15_s;
+
+  units::kilogram_square_meter_t moduleJ{0.01};
+  wom::sim::SwerveDriveSimConfig sim;
+  HeadlessSimVariation variation;
+
+  /**
+   * Instead of the auto, step the pose setpoint from the origin to this pose and
+   * hold it until the timeout, measuring the step response of the pose loops.
+   */
+  std::optional<frc::Pose2d> stepTarget;
+
+  /**
+   * NetworkTables values set after the robot starts, by full topic name. As
+   * PIDConfigs are bound to NT, this sets the gains of any PID loop, e.g.
+   * "/drivetrain/pid/pose/angle/config/kP".
+   */
+  std::map<std::string, double> ntOverrides;
+
+  // Charge station for the robot to drive onto, if any
+  std::optional<ChargeStationConfig> chargeStation;
+
+  /**
+   * Instead of the auto, start on the charge station this far from its hinge
+   * along x, with the platform resting on that side, and run DrivebaseBalance
+   * until the timeout. Adds the default charge station if there isn't one.
+   */
+  std::optional<units::meter_t> balanceStart;
+
+  // Trace output, .json for JSON, anything else for CSV. Empty for no trace.
+  std::string tracePath;
+};
+
+struct HeadlessSimSample {
+  units::second_t time;
+  // Where the robot actually is
+  frc::Pose2d pose;
+  // Where the robot thinks it is
+  frc::Pose2d estimatedPose;
+  units::meters_per_second_t vx, vy;
+  units::radians_per_second_t omega;
+  units::ampere_t current;
+  // Tilt of the charge station, 0 without one
+  units::radian_t stationAngle;
+};
+
+struct HeadlessSimResult {
+  std::string autoName;
+  unsigned int seed;
+  behaviour::BehaviourState state;
+  // Sim time taken to finish, or the timeout
+  units::second_t simTime;
+  frc::Pose2d finalPose;
+  frc::Pose2d finalEstimatedPose;
+  units::ampere_t peakCurrent;
+
+  size_t steps;
+  double wallSeconds;
+  double maxStepMicroseconds;
+
+  /**
+   * Step response, if HeadlessSimConfig::stepTarget was set.
+   */
+  struct StepResponse {
+    // Time after which the pose stays within 2% of the step (at least 2cm and 1deg)
+    // of the target, or nullopt if it never settles.
+    std::optional<units::second_t> settlingTime;
+    // Furthest the robot went past the target, as a fraction of the step
+    double overshoot;
+  };
+  std::optional<StepResponse> stepResponse;
+
+  /**
+   * How the charge station settled, if there was one.
+   */
+  struct Balance {
+    // Time after which the platform stays level, or nullopt if it's not level at the end
+    std::optional<units::second_t> timeToBalance;
+    // Times the platform tipped from one side past level to the other
+    int oscillations;
+    units::radian_t finalAngle;
+  };
+  std::optional<Balance> balance;
+
+  bool Finished() const { return state == behaviour::BehaviourState::DONE; }
+};
+
+/**
+ * Runs the real Robot code against the simulated drivetrain with time stepped
+ * manually, so an auto runs as fast as the CPU allows instead of in real time.
+ *
+ * There is one HAL, NetworkTables instance and BehaviourScheduler per process,
+ * so only one HeadlessSim may exist at a time. Run several processes to run
+ * simulations in parallel.
+ */
+class HeadlessSim {
+ public:
+  HeadlessSim(HeadlessSimConfig config);
+  ~HeadlessSim();
+
+  HeadlessSimResult Run();
+
+  const std::vector<HeadlessSimSample> &GetTrace() const { return _trace; }
+
+  static void PrintSummary(const HeadlessSimResult &result, std::ostream &out);
+
+  /**
+   * Print the summary as a single line of JSON, for scripts driving many runs.
+   */
+  static void PrintSummaryJson(const HeadlessSimResult &result, std::ostream &out);
+
+ private:
+  double Normal(double stddev);
+  void ApplyVariation(wom::SwerveDriveConfig<4> &config);
+  void ReadSensors();
+  void Record();
+  HeadlessSimResult::StepResponse MeasureStepResponse(frc::Pose2d target) const;
+  HeadlessSimResult::Balance MeasureBalance() const;
+  void WriteTrace(const HeadlessSimResult &result) const;
+
+  HeadlessSimConfig _config;
+  std::unique_ptr<Robot> _robot;
+  std::unique_ptr<wom::sim::SwerveDriveSim<4>> _sim;
+  std::unique_ptr<ChargeStationSim> _chargeStation;
+
+  std::mt19937 _rng;
+  std::array<double, 4> _wheelSlip{};
+  units::ohm_t _batteryResistance;
+
+  units::second_t _time = 0_s;
+  std::vector<HeadlessSimSample> _trace;
+};
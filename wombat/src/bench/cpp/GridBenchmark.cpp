@@ -0,0 +1,379 @@
+/*
+  Grid and path planner benchmark. Builds random and structured occupancy grids at
+  several resolutions and times FillF, GetClosestValidNode, AStarStrict and
+  GridRoadmap on them, reporting latency percentiles, cells expanded and heap
+  allocations per call, e.g.
+    gridBenchmark --sizes 100,400 --queries 500 --csv after.csv --baseline before.csv
+  With --baseline, exits with 1 if anything got slower than the tolerance allows,
+  or expands or allocates more than it did.
+*/
+
+#include "Grid.h"
+#include "GridRoadmap.h"
+
+#include <units/length.h>
+#include <units/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Every heap allocation in the program goes through here, so the benchmark can
+// count how many each call makes. Every form is replaced so none bypass the
+// count, and none are inlined, so the compiler can't see malloc paired with
+// a delete it didn't come from.
+static std::atomic<size_t> heapAllocations{0};
+
+static void *Allocate(std::size_t size, std::size_t alignment = 0) {
+  heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  size = size == 0 ? 1 : size;
+  if (alignment > alignof(std::max_align_t))
+    // aligned_alloc wants the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+  return std::malloc(size);
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size) {
+  if (void *p = Allocate(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void *operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (void *p = Allocate(size, (std::size_t)alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return ::operator new(size, alignment);
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return Allocate(size);
+}
+
+[[gnu::noinline]] void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return Allocate(size);
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  return Allocate(size, (std::size_t)alignment);
+}
+
+[[gnu::noinline]] void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  return Allocate(size, (std::size_t)alignment);
+}
+
+// malloc and aligned_alloc are both released with free
+[[gnu::noinline]] void operator delete(void *p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+using grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter>;
+using roadmap_t = wom::GridRoadmap<units::meter, units::meter, units::second>;
+
+// As many targets as FieldNavigation has grid poses
+static constexpr size_t kRoadmapTargets = 9;
+
+// The grids are all 10 m square, only the number of cells changes
+static constexpr double kExtent = 10;
+
+struct Samples {
+  std::vector<double> us;
+  double expansions = 0;
+  double allocations = 0;
+
+  // Time f, adding what it did to the totals
+  template<typename F>
+  void Measure(F f) {
+    size_t before = heapAllocations.load(std::memory_order_relaxed);
+    auto begin = std::chrono::steady_clock::now();
+    f();
+    us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+    allocations += (double)(heapAllocations.load(std::memory_order_relaxed) - before);
+  }
+};
+
+struct Result {
+  std::string grid, op, search;
+  int size;
+  size_t count;
+  double p50, p90, p99, max, expansions, allocations;
+
+  std::string Key() const {
+    return grid + "," + std::to_string(size) + "," + op + "," + search;
+  }
+};
+
+static double Percentile(std::vector<double> sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  size_t i = (size_t)std::ceil(p * sorted.size());
+  return sorted[std::clamp<size_t>(i, 1, sorted.size()) - 1];
+}
+
+static Result Summarise(const std::string &grid, int size, const std::string &op, const std::string &search, Samples &s) {
+  std::sort(s.us.begin(), s.us.end());
+  double n = std::max<double>(1, s.us.size());
+  return Result{
+    grid, op, search, size, s.us.size(),
+    Percentile(s.us, 0.5), Percentile(s.us, 0.9), Percentile(s.us, 0.99), s.us.empty() ? 0 : s.us.back(),
+    s.expansions / n, s.allocations / n
+  };
+}
+
+/**
+ * The occupancy of a kind of grid, as a function of position in metres. Called
+ * again for every fill, so it must give the same grid each time it's made.
+ */
+using GridFactory = std::function<std::function<bool(units::meter_t, units::meter_t)>(int size, unsigned seed)>;
+
+static const std::vector<std::pair<std::string, GridFactory>> &GridKinds() {
+  static const std::vector<std::pair<std::string, GridFactory>> kinds{
+    // A quarter of the cells blocked at random, the worst case for jump point search
+    { "random", [](int, unsigned seed) {
+      auto rng = std::make_shared<std::mt19937>(seed);
+      return [rng](units::meter_t, units::meter_t) {
+        return std::bernoulli_distribution{0.25}(*rng);
+      };
+    }},
+    // Mostly open, with a few large obstacles, like the field or the armavator's space
+    { "open", [](int, unsigned) {
+      return [](units::meter_t mx, units::meter_t my) {
+        double x = mx.value(), y = my.value();
+        bool box = (x > 1 && x < 2 && y < 6) || (x > 3.5 && x < 6 && y > 3 && y < 5) || (x > 7.5 && x < 8.5 && y > 4);
+        bool round = std::hypot(x - 5, y - 8) < 1.2 || std::hypot(x - 8, y - 1.5) < 0.8;
+        return box || round;
+      };
+    }},
+    // An armavator configuration space: angle -90 to 270 degrees along x, height 0
+    // to 1.33 m along y, blocked wherever the end of the arm is off the floor to
+    // ceiling band
+    { "armavator", [](int, unsigned) {
+      return [](units::meter_t mx, units::meter_t my) {
+        double angle = (-90 + 360 * mx.value() / kExtent) * std::numbers::pi / 180;
+        double height = 1.33 * my.value() / kExtent;
+        double y = height + std::sin(angle);
+        return !(y >= 0.1 && y <= 1.83);
+      };
+    }},
+    // A 5 by 5 block of rooms, with a door in the middle of every wall
+    { "rooms", [](int size, unsigned) {
+      double wall = std::max(kExtent / size, 0.1);
+      return [wall](units::meter_t mx, units::meter_t my) {
+        double x = std::fmod(mx.value(), 2), y = std::fmod(my.value(), 2);
+        bool vertical = x < wall && mx.value() > 1 && std::abs(y - 1) > 0.4;
+        bool horizontal = y < wall && my.value() > 1 && std::abs(x - 1) > 0.4;
+        return vertical || horizontal;
+      };
+    }},
+  };
+  return kinds;
+}
+
+static std::vector<int> ParseInts(const std::string &list) {
+  std::vector<int> values;
+  std::stringstream ss{list};
+  std::string item;
+  while (std::getline(ss, item, ','))
+    values.push_back(std::stoi(item));
+  return values;
+}
+
+static std::map<std::string, Result> ReadCsv(const std::string &path) {
+  std::map<std::string, Result> results;
+  std::ifstream in{path};
+  if (!in)
+    throw std::invalid_argument("Can't read " + path);
+
+  std::string line;
+  std::getline(in, line);  // header
+  while (std::getline(in, line)) {
+    std::stringstream ss{line};
+    std::vector<std::string> fields;
+    std::string field;
+    while (std::getline(ss, field, ','))
+      fields.push_back(field);
+    if (fields.size() != 11)
+      throw std::invalid_argument("Bad line in " + path + ": " + line);
+
+    Result r{
+      fields[0], fields[2], fields[3], std::stoi(fields[1]), (size_t)std::stoul(fields[4]),
+      std::stod(fields[5]), std::stod(fields[6]), std::stod(fields[7]), std::stod(fields[8]),
+      std::stod(fields[9]), std::stod(fields[10])
+    };
+    results[r.Key()] = r;
+  }
+  return results;
+}
+
+static void WriteCsv(const std::string &path, const std::vector<Result> &results) {
+  std::ofstream out{path};
+  out << "grid,size,op,search,count,p50_us,p90_us,p99_us,max_us,expansions,allocations" << std::endl;
+  for (auto &r : results) {
+    out << r.grid << "," << r.size << "," << r.op << "," << r.search << "," << r.count << ","
+        << r.p50 << "," << r.p90 << "," << r.p99 << "," << r.max << "," << r.expansions << "," << r.allocations << std::endl;
+  }
+}
+
+static void Usage() {
+  std::cerr << "Usage: gridBenchmark [--sizes N,N,...] [--queries N] [--fills N] [--seed N]" << std::endl
+            << "                     [--csv PATH] [--baseline PATH] [--tolerance FRACTION]" << std::endl
+            << "--sizes is the number of cells along each side of the grids (default 50,100,200,400)." << std::endl
+            << "--baseline compares against a CSV from an earlier --csv run. Latency may be up to" << std::endl
+            << "  --tolerance (default 0.2) worse at the median, expansions and allocations not at all." << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::vector<int> sizes{ 50, 100, 200, 400 };
+  int queries = 200, fills = 20;
+  unsigned seed = 1;
+  double tolerance = 0.2;
+  std::string csvPath, baselinePath;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--sizes" && hasValue) {
+      sizes = ParseInts(argv[++i]);
+    } else if (arg == "--queries" && hasValue) {
+      queries = std::stoi(argv[++i]);
+    } else if (arg == "--fills" && hasValue) {
+      fills = std::stoi(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      seed = (unsigned)std::stoul(argv[++i]);
+    } else if (arg == "--csv" && hasValue) {
+      csvPath = argv[++i];
+    } else if (arg == "--baseline" && hasValue) {
+      baselinePath = argv[++i];
+    } else if (arg == "--tolerance" && hasValue) {
+      tolerance = std::stod(argv[++i]);
+    } else {
+      Usage();
+      return arg == "--help" ? 0 : 2;
+    }
+  }
+
+  std::vector<Result> results;
+  for (auto &[kind, factory] : GridKinds()) {
+    for (int size : sizes) {
+      grid_t grid{ 0_m, units::meter_t{kExtent}, 0_m, units::meter_t{kExtent}, (size_t)size, (size_t)size };
+
+      // Filling the grid, and the first nearest free cell lookup after, which
+      // rebuilds the distance fields
+      Samples fill, cold;
+      for (int i = 0; i < fills; i++) {
+        auto f = factory(size, seed);
+        fill.Measure([&]() { grid.FillF(f); });
+        cold.Measure([&]() { grid.GetClosestValidNode({ 0, 0 }); });
+      }
+      results.push_back(Summarise(kind, size, "FillF", "-", fill));
+      results.push_back(Summarise(kind, size, "GetClosestValidNode(cold)", "-", cold));
+
+      // The same start and end cells for every search mode
+      std::mt19937 rng{ seed };
+      std::uniform_int_distribution<int> cell{ 0, size - 1 };
+      std::vector<std::pair<grid_t::Idx_t, grid_t::Idx_t>> pairs;
+      Samples closest;
+      for (int i = 0; i < queries; i++) {
+        grid_t::Idx_t a{ cell(rng), cell(rng) }, b{ cell(rng), cell(rng) };
+        grid_t::Idx_t start, end;
+        closest.Measure([&]() { start = grid.GetClosestValidNode(a); });
+        closest.Measure([&]() { end = grid.GetClosestValidNode(b); });
+        pairs.emplace_back(start, end);
+      }
+      results.push_back(Summarise(kind, size, "GetClosestValidNode", "-", closest));
+
+      for (auto [name, search] : { std::pair{ "astar", wom::GridSearch::kAStar }, std::pair{ "jps", wom::GridSearch::kJumpPoint } }) {
+        // The first search sizes the scratch space, which every search after reuses
+        grid.AStarStrict<units::second>(pairs[0].first, pairs[0].second, 1_s / 1_m, 1_s / 1_m, 0_s, search);
+
+        Samples astar;
+        for (auto &[start, end] : pairs) {
+          astar.Measure([&]() { grid.AStarStrict<units::second>(start, end, 1_s / 1_m, 1_s / 1_m, 0_s, search); });
+          astar.expansions += (double)grid.GetLastExpansions();
+        }
+        results.push_back(Summarise(kind, size, "AStarStrict", name, astar));
+      }
+
+      // A roadmap to the ends of the first few pairs, then routes to them from every start
+      std::vector<grid_t::Idx_t> targets;
+      for (size_t i = 0; i < pairs.size() && targets.size() < kRoadmapTargets; i++)
+        targets.push_back(pairs[i].second);
+
+      Samples build;
+      std::optional<roadmap_t> roadmap;
+      build.Measure([&]() { roadmap.emplace(grid, targets, 1_s / 1_m, 1_s / 1_m); });
+      results.push_back(Summarise(kind, size, "GridRoadmap(build)", "-", build));
+
+      Samples route;
+      for (size_t i = 0; i < pairs.size(); i++)
+        route.Measure([&]() { roadmap->Route(pairs[i].first, (int)(i % targets.size())); });
+      results.push_back(Summarise(kind, size, "GridRoadmap::Route", "-", route));
+    }
+  }
+
+  std::cout << std::left << std::setw(10) << "grid" << std::setw(6) << "size" << std::setw(27) << "op" << std::setw(7) << "search"
+            << std::right << std::setw(10) << "p50 us" << std::setw(10) << "p90 us" << std::setw(10) << "p99 us" << std::setw(10) << "max us"
+            << std::setw(12) << "expansions" << std::setw(10) << "allocs" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  for (auto &r : results) {
+    std::cout << std::left << std::setw(10) << r.grid << std::setw(6) << r.size << std::setw(27) << r.op << std::setw(7) << r.search
+              << std::right << std::setw(10) << r.p50 << std::setw(10) << r.p90 << std::setw(10) << r.p99 << std::setw(10) << r.max
+              << std::setw(12) << r.expansions << std::setw(10) << r.allocations << std::endl;
+  }
+
+  if (!csvPath.empty())
+    WriteCsv(csvPath, results);
+
+  if (baselinePath.empty())
+    return 0;
+
+  auto baseline = ReadCsv(baselinePath);
+  int regressions = 0;
+  for (auto &r : results) {
+    auto it = baseline.find(r.Key());
+    if (it == baseline.end())
+      continue;
+    const Result &b = it->second;
+    // Anything under a microsecond is mostly the clock
+    bool slower = r.p50 > b.p50 * (1 + tolerance) && r.p50 - b.p50 > 1;
+    if (slower || r.expansions > b.expansions + 1e-6 || r.allocations > b.allocations + 1e-6) {
+      std::cout << "REGRESSION " << r.Key() << ": p50 " << b.p50 << " -> " << r.p50 << " us, expansions " << b.expansions
+                << " -> " << r.expansions << ", allocations " << b.allocations << " -> " << r.allocations << std::endl;
+      regressions++;
+    }
+  }
+  std::cout << regressions << " regressions against " << baselinePath << std::endl;
+  return regressions > 0 ? 1 : 0;
+}
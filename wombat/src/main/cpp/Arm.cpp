@@ -88,6 +88,12 @@ units::radians_per_second_t Arm::MaxSpeed() const {
   return _config.gearbox.motor.Speed(0_Nm, 12_V);
 }
 
+units::radians_per_second_squared_t Arm::MaxAcceleration() const {
+  units::newton_meter_t gravity = (_config.loadMass + _config.armMass / 2.0) * 9.81_mps_sq * _config.armLength;
+  auto inertia = (_config.loadMass + _config.armMass / 3.0) * _config.armLength * _config.armLength;
+  return (_config.gearbox.motor.stallTorque - gravity) / inertia * 1_rad;
+}
+
 bool Arm::IsStable() const {
   return _pid.IsStable();
 }
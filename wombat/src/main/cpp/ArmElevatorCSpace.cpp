@@ -0,0 +1,248 @@
+#include "ArmElevatorCSpace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace wom;
+
+static_assert(sizeof(ArmElevatorCSpace::FileHeader) == 24, "C-space header must be packed");
+
+CollisionShape CollisionShape::Box(std::string name, units::meter_t xmin, units::meter_t ymin, units::meter_t xmax, units::meter_t ymax) {
+  return CollisionShape{ name, {
+    { xmin.value(), ymin.value() },
+    { xmax.value(), ymin.value() },
+    { xmax.value(), ymax.value() },
+    { xmin.value(), ymax.value() }
+  } };
+}
+
+namespace {
+  double Cross(Eigen::Vector2d a, Eigen::Vector2d b) {
+    return a.x() * b.y() - a.y() * b.x();
+  }
+
+  double PointSegmentDistance(Eigen::Vector2d p, Eigen::Vector2d a, Eigen::Vector2d b) {
+    Eigen::Vector2d ab = b - a;
+    double t = ab.squaredNorm() > 0 ? std::clamp((p - a).dot(ab) / ab.squaredNorm(), 0.0, 1.0) : 0.0;
+    return (a + ab * t - p).norm();
+  }
+
+  double SegmentDistance(Eigen::Vector2d a, Eigen::Vector2d b, Eigen::Vector2d c, Eigen::Vector2d d) {
+    double d1 = Cross(b - a, c - a), d2 = Cross(b - a, d - a);
+    double d3 = Cross(d - c, a - c), d4 = Cross(d - c, b - c);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0)))
+      return 0;
+    return std::min({
+      PointSegmentDistance(a, c, d), PointSegmentDistance(b, c, d),
+      PointSegmentDistance(c, a, b), PointSegmentDistance(d, a, b)
+    });
+  }
+
+  bool Inside(Eigen::Vector2d p, const std::vector<Eigen::Vector2d> &polygon) {
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+      const Eigen::Vector2d &a = polygon[i], &b = polygon[j];
+      if ((a.y() > p.y()) != (b.y() > p.y()) && p.x() < (b.x() - a.x()) * (p.y() - a.y()) / (b.y() - a.y()) + a.x())
+        inside = !inside;
+    }
+    return inside;
+  }
+
+  // Whether the segment ab, thickened by radius, touches the polygon
+  bool Touches(Eigen::Vector2d a, Eigen::Vector2d b, double radius, const std::vector<Eigen::Vector2d> &polygon) {
+    if (polygon.empty())
+      return false;
+    if (Inside(a, polygon))
+      return true;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+      if (SegmentDistance(a, b, polygon[j], polygon[i]) <= radius)
+        return true;
+    return false;
+  }
+
+  void HashBytes(uint64_t &hash, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+    }
+  }
+
+  void HashDouble(uint64_t &hash, double value) {
+    // So 0 and -0 hash the same
+    if (value == 0)
+      value = 0;
+    HashBytes(hash, &value, sizeof(value));
+  }
+}
+
+bool ArmElevatorCSpace::Collides(const ArmElevatorGeometry &geometry, units::radian_t angle, units::meter_t height, units::meter_t margin) {
+  Eigen::Vector2d pivot{ geometry.pivotX.value(), (height + geometry.pivotY).value() };
+  Eigen::Vector2d tip = pivot + geometry.armLength.value() * Eigen::Vector2d{ std::cos(angle.value()), std::sin(angle.value()) };
+  double radius = (geometry.armRadius + margin).value();
+
+  // The arm is straight, so if the pivot is between them the tip is what reaches
+  // them first. If it isn't, that's where the elevator puts the carriage, which
+  // the arm can't do anything about.
+  if (geometry.floor && tip.y() - radius < geometry.floor->value())
+    return true;
+  if (geometry.ceiling && tip.y() + radius > geometry.ceiling->value())
+    return true;
+
+  for (auto &shape : geometry.shapes)
+    if (Touches(pivot, tip, radius, shape.vertices))
+      return true;
+  return false;
+}
+
+ArmElevatorCSpace::grid_t ArmElevatorCSpace::Generate(const ArmElevatorGeometry &geometry, int angleCells, int heightCells, unsigned int threads) {
+  if (angleCells <= 0 || heightCells <= 0)
+    throw std::invalid_argument("C-space must have at least one cell");
+
+  double dAngle = (geometry.maxAngle - geometry.minAngle).value() / angleCells;
+  double dHeight = (geometry.maxHeight - geometry.minHeight).value() / heightCells;
+
+  // Split each cell so that within a piece, no point on the arm moves more than
+  // the tolerance from where it is at the piece's centre
+  double tolerance = std::max(geometry.tolerance.value(), 1e-4);
+  int angleSteps = std::clamp((int)std::ceil(geometry.armLength.value() * std::abs(dAngle) / tolerance), 1, 256);
+  int heightSteps = std::clamp((int)std::ceil(std::abs(dHeight) / tolerance), 1, 256);
+  units::meter_t margin{ geometry.armLength.value() * std::abs(dAngle) / angleSteps / 2 + std::abs(dHeight) / heightSteps / 2 };
+
+  auto occupied = [&](int x, int y) {
+    for (int j = 0; j < heightSteps; j++) {
+      units::meter_t height = geometry.minHeight + units::meter_t{dHeight * (y + (j + 0.5) / heightSteps)};
+      for (int i = 0; i < angleSteps; i++) {
+        units::radian_t angle = geometry.minAngle + units::radian_t{dAngle * (x + (i + 0.5) / angleSteps)};
+        if (Collides(geometry, angle, height, margin))
+          return true;
+      }
+    }
+    return false;
+  };
+
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::min(threads, (unsigned int)heightCells);
+
+  // Rows are shared out in turn, so obstacles near one end don't all land on one thread
+  Eigen::MatrixXi matrix = Eigen::MatrixXi::Zero(heightCells, angleCells);
+  auto work = [&](unsigned int first) {
+    for (int y = (int)first; y < heightCells; y += (int)threads)
+      for (int x = 0; x < angleCells; x++)
+        matrix(y, x) = occupied(x, y) ? 1 : 0;
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int t = 1; t < threads; t++)
+    workers.emplace_back(work, t);
+  work(0);
+  for (auto &worker : workers)
+    worker.join();
+
+  return grid_t{ geometry.minAngle, geometry.maxAngle, geometry.minHeight, geometry.maxHeight, matrix };
+}
+
+uint64_t ArmElevatorCSpace::Hash(const ArmElevatorGeometry &geometry, int angleCells, int heightCells) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  uint32_t header[3] = { kVersion, (uint32_t)angleCells, (uint32_t)heightCells };
+  HashBytes(hash, header, sizeof(header));
+
+  for (double value : {
+    geometry.armLength.value(), geometry.armRadius.value(),
+    geometry.minAngle.value(), geometry.maxAngle.value(),
+    geometry.minHeight.value(), geometry.maxHeight.value(),
+    geometry.pivotX.value(), geometry.pivotY.value(),
+    geometry.tolerance.value()
+  })
+    HashDouble(hash, value);
+
+  for (auto &limit : { geometry.floor, geometry.ceiling }) {
+    uint8_t present = limit.has_value();
+    HashBytes(hash, &present, 1);
+    if (limit)
+      HashDouble(hash, limit->value());
+  }
+
+  // Names don't change the grid, only the shapes
+  uint64_t count = geometry.shapes.size();
+  HashBytes(hash, &count, sizeof(count));
+  for (auto &shape : geometry.shapes) {
+    count = shape.vertices.size();
+    HashBytes(hash, &count, sizeof(count));
+    for (auto &vertex : shape.vertices) {
+      HashDouble(hash, vertex.x());
+      HashDouble(hash, vertex.y());
+    }
+  }
+  return hash;
+}
+
+std::string ArmElevatorCSpace::CachePath(const ArmElevatorGeometry &geometry, int angleCells, int heightCells, std::string cacheDir) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "cspace_%016llx.bin", (unsigned long long)Hash(geometry, angleCells, heightCells));
+  return (std::filesystem::path(cacheDir) / name).string();
+}
+
+ArmElevatorCSpace::grid_t ArmElevatorCSpace::LoadOrGenerate(const ArmElevatorGeometry &geometry, int angleCells, int heightCells, std::string cacheDir) {
+  uint64_t hash = Hash(geometry, angleCells, heightCells);
+  std::string path = CachePath(geometry, angleCells, heightCells, cacheDir);
+  size_t bytes = ((size_t)angleCells * heightCells + 7) / 8;
+
+  std::ifstream in(path, std::ios::binary);
+  if (in) {
+    FileHeader header;
+    std::vector<uint8_t> bits(bytes);
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    in.read(reinterpret_cast<char *>(bits.data()), (std::streamsize)bits.size());
+
+    if (in && std::memcmp(header.magic, "WCSP", 4) == 0 && header.version == kVersion && header.hash == hash
+        && header.cols == (uint32_t)angleCells && header.rows == (uint32_t)heightCells) {
+      Eigen::MatrixXi matrix(heightCells, angleCells);
+      for (int y = 0; y < heightCells; y++) {
+        for (int x = 0; x < angleCells; x++) {
+          size_t i = (size_t)y * angleCells + x;
+          matrix(y, x) = (bits[i / 8] >> (i % 8)) & 1;
+        }
+      }
+      return grid_t{ geometry.minAngle, geometry.maxAngle, geometry.minHeight, geometry.maxHeight, matrix };
+    }
+    std::cerr << "Ignoring malformed c-space cache " << path << std::endl;
+  }
+
+  grid_t grid = Generate(geometry, angleCells, heightCells);
+
+  std::vector<uint8_t> bits(bytes, 0);
+  for (int y = 0; y < heightCells; y++) {
+    for (int x = 0; x < angleCells; x++) {
+      size_t i = (size_t)y * angleCells + x;
+      if (grid.GetBits().Get(x, y))
+        bits[i / 8] |= 1 << (i % 8);
+    }
+  }
+
+  // Written to the side then renamed, so a half written file is never loaded
+  std::error_code ec;
+  std::filesystem::create_directories(cacheDir, ec);
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    FileHeader header{ { 'W', 'C', 'S', 'P' }, kVersion, hash, (uint32_t)angleCells, (uint32_t)heightCells };
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(bits.data()), (std::streamsize)bits.size());
+    if (!out) {
+      std::cerr << "Could not save c-space cache " << path << std::endl;
+      return grid;
+    }
+  }
+  std::filesystem::rename(tmp, path, ec);
+  if (ec)
+    std::cerr << "Could not save c-space cache " << path << ": " << ec.message() << std::endl;
+  return grid;
+}
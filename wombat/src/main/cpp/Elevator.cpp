@@ -109,3 +109,7 @@ units::meter_t Elevator::GetHeight() const {
 units::meters_per_second_t Elevator::MaxSpeed() const {
   return _config.gearbox.motor.Speed((_config.mass * 9.81_mps_sq) * _config.radius, 12_V) / 1_rad * _config.radius;
 }
+
+units::meters_per_second_squared_t Elevator::MaxAcceleration() const {
+  return _config.gearbox.motor.stallTorque / _config.radius / _config.mass - 9.81_mps_sq;
+}
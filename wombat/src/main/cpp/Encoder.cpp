@@ -1,9 +1,12 @@
 #include "Encoder.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace wom;
 
 double Encoder::GetEncoderTicks() const {
-  return GetEncoderRawTicks() - _offset;
+  return GetSampledRawTicks() - _offset;
 }
 
 double Encoder::GetEncoderTicksPerRotation() const {
@@ -11,7 +14,7 @@ double Encoder::GetEncoderTicksPerRotation() const {
 }
 
 void Encoder::ZeroEncoder() {
-  _offset = GetEncoderRawTicks();
+  _offset = GetSampledRawTicks();
 }
 
 void Encoder::SetEncoderPosition(units::radian_t position) {
@@ -35,10 +38,40 @@ units::radian_t Encoder::GetEncoderPosition() {
 
 units::radians_per_second_t Encoder::GetEncoderAngularVelocity() {
   // return GetEncoderTickVelocity() / (double)GetEncoderTicksPerRotation() * 2 * 3.1415926;
-  units::turns_per_second_t n_turns_per_s{GetEncoderTickVelocity() / GetEncoderTicksPerRotation()};
+  units::turns_per_second_t n_turns_per_s{GetSampledTickVelocity() / GetEncoderTicksPerRotation()};
   return n_turns_per_s;
 }
 
+units::radian_t Encoder::ReadEncoderPosition() const {
+  units::turn_t n_turns{(GetEncoderRawTicks() - _offset) / GetEncoderTicksPerRotation()};
+  return n_turns;
+}
+
+void Encoder::Sample(units::second_t timestamp) {
+  _sample.Write(EncoderSample{ GetEncoderRawTicks(), GetEncoderTickVelocity(), timestamp });
+  _sampled = true;
+}
+
+void Encoder::ClearSample() {
+  _sampled = false;
+}
+
+bool Encoder::IsSampled() const {
+  return _sampled;
+}
+
+EncoderSample Encoder::GetSample() const {
+  return _sample.Read();
+}
+
+double Encoder::GetSampledRawTicks() const {
+  return _sampled ? _sample.Read().ticks : GetEncoderRawTicks();
+}
+
+double Encoder::GetSampledTickVelocity() const {
+  return _sampled ? _sample.Read().tickVelocity : GetEncoderTickVelocity();
+}
+
 double DigitalEncoder::GetEncoderRawTicks() const {
   return _nativeEncoder.Get();
 }
@@ -67,6 +100,11 @@ double CANSparkMaxEncoder::GetEncoderTickVelocity() const {
   #endif
 }
 
+// Status frame periods are whole milliseconds, 1 to 255
+static uint8_t StatusFramePeriod(units::hertz_t rate) {
+  return (uint8_t)std::clamp((int)std::floor(1000.0 / rate.value()), 1, 255);
+}
+
 TalonFXEncoder::TalonFXEncoder(ctre::phoenix::motorcontrol::can::TalonFX *controller, double reduction)
   : Encoder(2048, reduction), _controller(controller) {
     controller->ConfigSelectedFeedbackSensor(ctre::phoenix::motorcontrol::TalonFXFeedbackDevice::IntegratedSensor);
@@ -80,6 +118,10 @@ double TalonFXEncoder::GetEncoderTickVelocity() const {
   return _controller->GetSelectedSensorVelocity() * 10;
 }
 
+void TalonFXEncoder::SetUpdateRate(units::hertz_t rate) {
+  _controller->SetStatusFramePeriod(ctre::phoenix::motorcontrol::StatusFrameEnhanced::Status_2_Feedback0, StatusFramePeriod(rate));
+}
+
 TalonSRXEncoder::TalonSRXEncoder(ctre::phoenix::motorcontrol::can::TalonSRX *controller, double ticksPerRotation, double reduction) 
   : Encoder(ticksPerRotation, reduction), _controller(controller) {
     controller->ConfigSelectedFeedbackSensor(ctre::phoenix::motorcontrol::TalonSRXFeedbackDevice::QuadEncoder);
@@ -93,6 +135,10 @@ double TalonSRXEncoder::GetEncoderTickVelocity() const {
   return _controller->GetSelectedSensorVelocity() * 10;
 }
 
+void TalonSRXEncoder::SetUpdateRate(units::hertz_t rate) {
+  _controller->SetStatusFramePeriod(ctre::phoenix::motorcontrol::StatusFrameEnhanced::Status_2_Feedback0, StatusFramePeriod(rate));
+}
+
 DutyCycleEncoder::DutyCycleEncoder(int channel, double ticksPerRotation, double reduction) 
   : Encoder(ticksPerRotation, reduction), _dutyCycleEncoder(channel) {}
 
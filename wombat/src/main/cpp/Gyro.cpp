@@ -7,7 +7,7 @@ using namespace wom;
   #include "AHRS.h"
   class NavX::Impl {
    public:
-    Impl() : ahrs(frc::SPI::kMXP) { }
+    Impl(units::hertz_t updateRate) : ahrs(frc::SPI::kMXP, (uint8_t)updateRate.value()) { }
 
     void Calibrate() {
       ahrs.Calibrate();
@@ -37,6 +37,11 @@ using namespace wom;
       Reset();
       this->offset = offset.convert<units::degree>().value();
     }
+
+    // The real gyro measures its own rate and tilt
+    void SetRate(units::radians_per_second_t rate) {}
+    void SetPitch(units::radian_t pitch) {}
+    void SetRoll(units::radian_t roll) {}
    private:
     AHRS ahrs;
     double offset;
@@ -44,66 +49,100 @@ using namespace wom;
 #else
   class NavX::Impl {
    public:
+    Impl(units::hertz_t updateRate) { }
     void Calibrate() {}
     void Reset() { angle = 0; }
     double GetAngle() const { return angle; }
-    // TODO:
-    double GetRate() const { return 0; }
+    double GetRate() const { return rate; }
 
-    units::radian_t GetPitch() { return 0_rad; }
-    units::radian_t GetRoll() { return 0_rad; }
+    units::radian_t GetPitch() { return pitch; }
+    units::radian_t GetRoll() { return roll; }
 
     void SetAngle(units::radian_t offset) {
       angle = offset.convert<units::degree>().value();
     }
+
+    void SetRate(units::radians_per_second_t rate) {
+      this->rate = rate.convert<units::degrees_per_second>().value();
+    }
+    void SetPitch(units::radian_t pitch) { this->pitch = pitch; }
+    void SetRoll(units::radian_t roll) { this->roll = roll; }
    private:
     double angle{0};
+    double rate{0};
+    units::radian_t pitch{0};
+    units::radian_t roll{0};
   };
 #endif
 
-class NavXSimGyro : public sim::SimCapableGyro {
+class wom::NavXSimGyro : public sim::SimCapableGyro {
  public:
   NavXSimGyro(NavX *navx) : navx(navx) {}
   void SetAngle(units::radian_t angle) override {
     navx->SetAngle(angle);
   }
+  void SetRate(units::radians_per_second_t rate) override {
+    navx->impl->SetRate(rate);
+  }
+  void SetPitch(units::radian_t pitch) override {
+    navx->impl->SetPitch(pitch);
+  }
+  void SetRoll(units::radian_t roll) override {
+    navx->impl->SetRoll(roll);
+  }
  private:
   NavX *navx;
 };
 
-NavX::NavX() : impl(new NavX::Impl()) { }
+NavX::NavX(units::hertz_t updateRate) : impl(new NavX::Impl(updateRate)) { }
 NavX::~NavX() {
   delete impl;
 }
 
 void NavX::Calibrate() {
+  _sampled = false;
   impl->Calibrate();
 }
 
 void NavX::Reset() {
+  _sampled = false;
   impl->Reset();
 }
 
 double NavX::GetAngle() const {
-  return impl->GetAngle();
+  return _sampled ? _sample.Read().angle : impl->GetAngle();
 }
 
 double NavX::GetRate() const {
-  return impl->GetRate();
+  return _sampled ? _sample.Read().rate : impl->GetRate();
 }
 
 units::radian_t NavX::GetPitch() {
-  return impl->GetPitch();
+  return _sampled ? _sample.Read().pitch : impl->GetPitch();
 }
 
 units::radian_t NavX::GetRoll() {
-  return impl->GetRoll();
+  return _sampled ? _sample.Read().roll : impl->GetRoll();
 }
 
 void NavX::SetAngle(units::radian_t angle) {
+  _sampled = false;
   impl->SetAngle(angle);
 }
 
+void NavX::Sample(units::second_t timestamp) {
+  _sample.Write(GyroSample{ impl->GetAngle(), impl->GetRate(), impl->GetPitch(), impl->GetRoll(), timestamp });
+  _sampled = true;
+}
+
+GyroSample NavX::GetSample() const {
+  return _sample.Read();
+}
+
+double NavX::ReadAngle() const {
+  return impl->GetAngle();
+}
+
 std::shared_ptr<sim::SimCapableGyro> NavX::MakeSimGyro() {
   return std::make_shared<NavXSimGyro>(this);
 }
@@ -0,0 +1,27 @@
+#include "SensorFrame.h"
+
+using namespace wom;
+
+void SensorFrame::Register(Encoder *encoder) {
+  if (encoder != nullptr) _encoders.push_back(encoder);
+}
+
+void SensorFrame::Register(Gyro *gyro) {
+  if (gyro != nullptr) _gyros.push_back(gyro);
+}
+
+void SensorFrame::Sample() {
+  _timestamp = wom::now();
+
+  for (auto encoder : _encoders) {
+    encoder->Sample(_timestamp);
+  }
+
+  for (auto gyro : _gyros) {
+    gyro->Sample(_timestamp);
+  }
+}
+
+units::second_t SensorFrame::GetTimestamp() const {
+  return _timestamp;
+}
@@ -1,5 +1,7 @@
 #include "behaviour/BehaviourScheduler.h"
 
+#include <algorithm>
+
 using namespace behaviour;
 
 BehaviourScheduler::BehaviourScheduler() {}
@@ -39,6 +41,11 @@ void BehaviourScheduler::Schedule(Behaviour::ptr behaviour) {
     sys->_active_behaviour = behaviour;
   }
 
+  if (_stepped) {
+    _steppedBehaviours.push_back(behaviour);
+    return;
+  }
+
   _threads.emplace_back([behaviour, this]() {
     while (!behaviour->IsFinished()) {
       using namespace std::chrono_literals;
@@ -55,6 +62,20 @@ void BehaviourScheduler::Schedule(Behaviour::ptr behaviour) {
 
 void BehaviourScheduler::Tick() {
   std::lock_guard<std::recursive_mutex> lk(_active_mtx);
+
+  if (_stepped) {
+    // Copied, a behaviour may schedule another as it ticks
+    std::vector<Behaviour::ptr> behaviours = _steppedBehaviours;
+    for (auto &behaviour : behaviours) {
+      if (!behaviour->IsFinished())
+        behaviour->Tick();
+    }
+    _steppedBehaviours.erase(
+      std::remove_if(_steppedBehaviours.begin(), _steppedBehaviours.end(), [](const Behaviour::ptr &b) { return b->IsFinished(); }),
+      _steppedBehaviours.end()
+    );
+  }
+
   for (HasBehaviour *sys : _systems) {
     if (sys->_active_behaviour != nullptr) {
       if (sys->_active_behaviour->IsFinished()) {
@@ -76,4 +97,8 @@ void BehaviourScheduler::InterruptAll() {
     if (sys->_active_behaviour)
       sys->_active_behaviour->Interrupt();
   }
-}
\ No newline at end of file
+}
+
+void BehaviourScheduler::SetStepped(bool stepped) {
+  _stepped = stepped;
+}
@@ -0,0 +1,96 @@
+#include "drivetrain/HolonomicTrajectory.h"
+
+#include <wpi/fs.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+using namespace wom;
+
+static_assert(sizeof(HolonomicTrajectory::FileHeader) == 16, "Trajectory header must be packed");
+static_assert(sizeof(HolonomicTrajectory::FileSample) == 36, "Trajectory sample must be packed");
+
+std::shared_ptr<HolonomicTrajectory> HolonomicTrajectory::Load(std::string path) {
+  std::error_code ec;
+  uint64_t size = fs::file_size(path, ec);
+  if (ec || size < sizeof(FileHeader)) {
+    std::cerr << "Could not read trajectory " << path << std::endl;
+    return nullptr;
+  }
+
+  fs::file_t file = fs::OpenFileForRead(path, ec);
+  if (ec) {
+    std::cerr << "Could not open trajectory " << path << ": " << ec.message() << std::endl;
+    return nullptr;
+  }
+  wpi::MappedFileRegion region{file, size, 0, wpi::MappedFileRegion::kReadOnly, ec};
+  fs::CloseFile(file);
+  if (ec || !region) {
+    std::cerr << "Could not map trajectory " << path << ": " << ec.message() << std::endl;
+    return nullptr;
+  }
+
+  const FileHeader *header = reinterpret_cast<const FileHeader *>(region.const_data());
+  if (std::memcmp(header->magic, "WTRJ", 4) != 0 || header->version != kVersion
+      || header->count == 0 || header->dt <= 0
+      || size < sizeof(FileHeader) + header->count * sizeof(FileSample)) {
+    std::cerr << "Malformed trajectory " << path << std::endl;
+    return nullptr;
+  }
+
+  uint32_t count = header->count;
+  float dt = header->dt;
+  const FileSample *samples = reinterpret_cast<const FileSample *>(region.const_data() + sizeof(FileHeader));
+  return std::shared_ptr<HolonomicTrajectory>(new HolonomicTrajectory(std::move(region), samples, count, dt));
+}
+
+std::shared_ptr<HolonomicTrajectory> HolonomicTrajectory::FromSamples(std::vector<FileSample> samples, float dt) {
+  if (samples.empty() || dt <= 0)
+    throw std::invalid_argument("Trajectory must have samples and a positive dt");
+  return std::shared_ptr<HolonomicTrajectory>(new HolonomicTrajectory(std::move(samples), dt));
+}
+
+HolonomicTrajectory::HolonomicTrajectory(wpi::MappedFileRegion region, const FileSample *samples, uint32_t count, float dt)
+  : _region(std::move(region)), _samples(samples), _count(count), _dt(dt) { }
+
+HolonomicTrajectory::HolonomicTrajectory(std::vector<FileSample> samples, float dt)
+  : _owned(std::move(samples)), _samples(_owned.data()), _count((uint32_t)_owned.size()), _dt(dt) { }
+
+HolonomicTrajectorySample HolonomicTrajectory::Sample(units::second_t time) const {
+  double idx = std::clamp(time.value() / _dt, 0.0, (double)(_count - 1));
+  size_t i = std::min((size_t)idx, (size_t)_count - 1);
+  size_t j = std::min(i + 1, (size_t)_count - 1);
+  float f = (float)(idx - i);
+
+  const FileSample &a = _samples[i];
+  const FileSample &b = _samples[j];
+  auto lerp = [f](float x, float y) { return x + (y - x) * f; };
+
+  return HolonomicTrajectorySample{
+    units::second_t{idx * _dt},
+    frc::Pose2d{ units::meter_t{lerp(a.x, b.x)}, units::meter_t{lerp(a.y, b.y)}, units::radian_t{lerp(a.heading, b.heading)} },
+    FieldRelativeSpeeds{
+      units::meters_per_second_t{lerp(a.vx, b.vx)},
+      units::meters_per_second_t{lerp(a.vy, b.vy)},
+      units::radians_per_second_t{lerp(a.omega, b.omega)}
+    },
+    units::meters_per_second_squared_t{lerp(a.ax, b.ax)},
+    units::meters_per_second_squared_t{lerp(a.ay, b.ay)},
+    units::radians_per_second_squared_t{lerp(a.alpha, b.alpha)}
+  };
+}
+
+units::second_t HolonomicTrajectory::GetDuration() const {
+  return units::second_t{(_count - 1) * _dt};
+}
+
+frc::Pose2d HolonomicTrajectory::GetInitialPose() const {
+  return Sample(0_s).pose;
+}
+
+frc::Pose2d HolonomicTrajectory::GetFinalPose() const {
+  return Sample(GetDuration()).pose;
+}
@@ -0,0 +1,209 @@
+#include "drivetrain/HolonomicTrajectoryPlanner.h"
+
+#include <frc/trajectory/TrajectoryGenerator.h>
+#include <frc/trajectory/constraint/CentripetalAccelerationConstraint.h>
+#include <units/math.h>
+
+#include <cmath>
+#include <numbers>
+#include <optional>
+
+using namespace wom;
+
+HolonomicTrajectoryPlanner::HolonomicTrajectoryPlanner(HolonomicTrajectoryPlannerConfig config)
+  : _config(config), _worker([this]() { Run(); }) { }
+
+HolonomicTrajectoryPlanner::~HolonomicTrajectoryPlanner() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _running = false;
+  }
+  _cv.notify_all();
+  _worker.join();
+}
+
+std::shared_ptr<HolonomicTrajectory> HolonomicTrajectoryPlanner::Request(frc::Pose2d start, frc::Pose2d target) {
+  key_t key = Quantise(start, target);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _cache.find(key);
+  if (it != _cache.end())
+    return it->second;
+
+  if (_pending.insert(key).second) {
+    _queue.push_back(key);
+    _cv.notify_one();
+  }
+  return nullptr;
+}
+
+size_t HolonomicTrajectoryPlanner::GetCacheSize() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _cache.size();
+}
+
+void HolonomicTrajectoryPlanner::ClearCache() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _cache.clear();
+  _cacheOrder.clear();
+  _queue.clear();
+  _pending.clear();
+  // Anything being generated now is dropped when it finishes
+  _generation++;
+}
+
+HolonomicTrajectoryPlanner::key_t HolonomicTrajectoryPlanner::Quantise(frc::Pose2d start, frc::Pose2d target) const {
+  return key_t{
+    {
+      (int)std::lround((start.X() / _config.positionQuantum).value()),
+      (int)std::lround((start.Y() / _config.positionQuantum).value()),
+      (int)std::lround((start.Rotation().Radians() / _config.angleQuantum).value())
+    },
+    { target.X().value(), target.Y().value(), target.Rotation().Radians().value() }
+  };
+}
+
+frc::Pose2d HolonomicTrajectoryPlanner::Dequantise(int x, int y, int theta) const {
+  return frc::Pose2d{ x * _config.positionQuantum, y * _config.positionQuantum, theta * _config.angleQuantum };
+}
+
+void HolonomicTrajectoryPlanner::Run() {
+  while (true) {
+    key_t key;
+    uint64_t generation;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [this]() { return !_running || !_queue.empty(); });
+      if (!_running)
+        return;
+      key = _queue.front();
+      _queue.pop_front();
+      generation = _generation;
+    }
+
+    frc::Pose2d target{units::meter_t{key.target[0]}, units::meter_t{key.target[1]}, units::radian_t{key.target[2]}};
+    auto trajectory = Generate(Dequantise(key.start[0], key.start[1], key.start[2]), target);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (generation != _generation)
+      continue;
+    _pending.erase(key);
+    _cache[key] = trajectory;
+    _cacheOrder.push_back(key);
+    while (_cacheOrder.size() > _config.cacheSize) {
+      _cache.erase(_cacheOrder.front());
+      _cacheOrder.pop_front();
+    }
+  }
+}
+
+std::shared_ptr<HolonomicTrajectory> HolonomicTrajectoryPlanner::Generate(frc::Pose2d start, frc::Pose2d target) const {
+  using FileSample = HolonomicTrajectory::FileSample;
+
+  double dtheta = std::remainder((target.Rotation().Radians() - start.Rotation().Radians()).value(), 2 * std::numbers::pi);
+  double theta0 = start.Rotation().Radians().value();
+
+  // Turning can take at most half of the modules' speed, leaving the rest for translation
+  units::radians_per_second_t maxOmega = _config.maxAngularVelocity;
+  if (_config.moduleRadius > 0_m)
+    maxOmega = units::math::min(maxOmega, units::radians_per_second_t{(_config.maxVelocity / _config.moduleRadius).value() / 2});
+
+  // The heading is smoothstepped, which peaks at 1.5 dtheta / T and 6 dtheta / T^2
+  double turnTime = std::max(
+    1.5 * std::abs(dtheta) / maxOmega.value(),
+    std::sqrt(6 * std::abs(dtheta) / _config.maxAngularAcceleration.value())
+  );
+
+  std::optional<frc::Trajectory> path;
+  frc::Translation2d delta = target.Translation() - start.Translation();
+  if (delta.Norm() >= _config.positionQuantum) {
+    std::vector<frc::Translation2d> interior;
+    if (_config.route)
+      interior = _config.route(start, target);
+
+    path = Path(start, target, interior, _config.maxVelocity);
+
+    // A module's speed is the robot's plus its speed from turning, so take the
+    // turning out of what translation can use
+    double omega = 1.5 * std::abs(dtheta) / std::max(path->TotalTime().value(), turnTime);
+    units::meters_per_second_t turnSpeed{omega * _config.moduleRadius.value()};
+    if (turnSpeed > 0_mps)
+      path = Path(start, target, interior, _config.maxVelocity - turnSpeed);
+  }
+
+  double pathTime = path.has_value() ? path->TotalTime().value() : 0;
+  double duration = std::max(pathTime, turnTime);
+  if (duration <= 0) {
+    // Already there, just hold the target
+    return HolonomicTrajectory::FromSamples({
+      FileSample{ (float)target.X().value(), (float)target.Y().value(), (float)(theta0 + dtheta), 0, 0, 0, 0, 0, 0 }
+    }, (float)_config.dt.value());
+  }
+
+  // If turning takes longer, the path is followed slower rather than finishing first
+  double k = pathTime / duration;
+  double dt = _config.dt.value();
+  size_t count = (size_t)std::ceil(duration / dt) + 1;
+
+  std::vector<FileSample> samples;
+  samples.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    double t = std::min(i * dt, duration);
+
+    double x = target.X().value(), y = target.Y().value();
+    double vx = 0, vy = 0, ax = 0, ay = 0;
+    if (path.has_value()) {
+      frc::Trajectory::State state = path->Sample(units::second_t{t * k});
+      double phi = state.pose.Rotation().Radians().value();
+      double v = state.velocity.value() * k;
+      double a = state.acceleration.value() * k * k;
+      double an = v * v * state.curvature.value();
+
+      x = state.pose.X().value();
+      y = state.pose.Y().value();
+      vx = v * std::cos(phi);
+      vy = v * std::sin(phi);
+      ax = a * std::cos(phi) - an * std::sin(phi);
+      ay = a * std::sin(phi) + an * std::cos(phi);
+    }
+
+    // Smoothstep the heading so it starts and ends at rest
+    double f = t / duration;
+    double ease = f * f * (3 - 2 * f);
+    double easeRate = 6 * f * (1 - f) / duration;
+    double easeAccel = (6 - 12 * f) / (duration * duration);
+
+    samples.push_back(FileSample{
+      (float)x, (float)y, (float)(theta0 + dtheta * ease),
+      (float)vx, (float)vy, (float)(dtheta * easeRate),
+      (float)ax, (float)ay, (float)(dtheta * easeAccel)
+    });
+  }
+
+  return HolonomicTrajectory::FromSamples(std::move(samples), (float)dt);
+}
+
+frc::Trajectory HolonomicTrajectoryPlanner::Path(frc::Pose2d start, frc::Pose2d target, const std::vector<frc::Translation2d> &interior, units::meters_per_second_t maxVelocity) const {
+  frc::TrajectoryConfig trajConfig{maxVelocity, _config.maxAcceleration};
+  trajConfig.AddConstraint(frc::CentripetalAccelerationConstraint{_config.maxCentripetalAcceleration});
+
+  // The spline heading is the direction of travel, not the robot heading
+  auto towards = [](frc::Translation2d from, frc::Translation2d to) {
+    frc::Translation2d d = to - from;
+    return frc::Rotation2d{d.X().value(), d.Y().value()};
+  };
+
+  if (interior.empty()) {
+    frc::Rotation2d direction = towards(start.Translation(), target.Translation());
+    return frc::TrajectoryGenerator::GenerateTrajectory(
+      std::vector<frc::Pose2d>{ frc::Pose2d{start.Translation(), direction}, frc::Pose2d{target.Translation(), direction} },
+      trajConfig
+    );
+  }
+  return frc::TrajectoryGenerator::GenerateTrajectory(
+    frc::Pose2d{start.Translation(), towards(start.Translation(), interior.front())},
+    interior,
+    frc::Pose2d{target.Translation(), towards(interior.back(), target.Translation())},
+    trajConfig
+  );
+}
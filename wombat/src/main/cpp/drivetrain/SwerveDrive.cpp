@@ -1,9 +1,16 @@
 #include "drivetrain/SwerveDrive.h"
 #include "NTUtil.h"
 
+#include <frc/Threads.h>
 #include <networktables/NetworkTableInstance.h>
 #include <units/math.h>
 
+#include <Eigen/QR>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 using namespace wom;
 
 void SwerveModuleConfig::WriteNT(std::shared_ptr<nt::NetworkTable> table) const {
@@ -32,6 +39,11 @@ void SwerveModule::OnUpdate(units::second_t dt) {
   units::volt_t driveVoltage{0};
   units::volt_t turnVoltage{0};
 
+  // Read each encoder once per update, the same reading is used throughout.
+  units::radians_per_second_t driveAngularVelocity = _config.driveMotor.encoder->GetEncoderAngularVelocity();
+  units::meters_per_second_t speed{driveAngularVelocity.value() * _config.wheelRadius.value()};
+  units::radian_t turnAngle = _config.turnMotor.encoder->GetEncoderPosition();
+
   switch(_state) {
     case SwerveModuleState::kIdle:
       driveVoltage = 0_V;
@@ -40,8 +52,8 @@ void SwerveModule::OnUpdate(units::second_t dt) {
     case SwerveModuleState::kPID:
       {
         auto feedforward = _config.driveMotor.motor.Voltage(0_Nm, units::radians_per_second_t{(_velocityPIDController.GetSetpoint() / _config.wheelRadius).value()});
-        driveVoltage = _velocityPIDController.Calculate(GetSpeed(), dt, feedforward);
-        turnVoltage = _anglePIDController.Calculate(_config.turnMotor.encoder->GetEncoderPosition(), dt);
+        driveVoltage = _velocityPIDController.Calculate(speed, dt, feedforward);
+        turnVoltage = _anglePIDController.Calculate(turnAngle, dt);
       }
       break;
   }
@@ -50,21 +62,19 @@ void SwerveModule::OnUpdate(units::second_t dt) {
   // units::volt_t max_voltage_for_current_limit = _config.turnMotor.motor.Voltage(max_torque_at_current_limit, _config.turnMotor.encoder->GetEncoderAngularVelocity());
   // turnVoltage = units::math::max(units::math::min(turnVoltage, max_voltage_for_current_limit), -max_voltage_for_current_limit);
 
-  // units::newton_meter_t max_torque_at_current_limit_d = _config.driveMotor.motor.Torque(75_A);
-  // units::volt_t max_voltage_for_current_limit_d = _config.driveMotor.motor.Voltage(max_torque_at_current_limit_d, _config.driveMotor.encoder->GetEncoderAngularVelocity());
-  // driveVoltage = units::math::max(units::math::min(driveVoltage, max_voltage_for_current_limit_d), -max_voltage_for_current_limit_d);
-
-
-  units::newton_meter_t torqueLimit = 50_kg/4 * _config.wheelRadius * _currentAccelerationLimit;
-  units::volt_t voltageMax = _config.driveMotor.motor.Voltage(torqueLimit, _config.driveMotor.encoder->GetEncoderAngularVelocity());
-  units::volt_t voltageMin = _config.driveMotor.motor.Voltage(-torqueLimit, _config.driveMotor.encoder->GetEncoderAngularVelocity());
-
-  driveVoltage = units::math::max(units::math::min(driveVoltage, voltageMax), voltageMin);
+  // Acceleration is limited for the whole chassis by the setpoint generator, so
+  // the modules slow down and speed up together rather than each on its own. The
+  // current limit stays as a safety net for what the generator can't see, e.g. a
+  // wheel held still against a wall or the PID correcting a large error.
+  units::newton_meter_t maxDriveTorque = _config.driveMotor.motor.Torque(_config.driveCurrentLimit);
+  units::volt_t driveVoltageMax = _config.driveMotor.motor.Voltage(maxDriveTorque, driveAngularVelocity);
+  units::volt_t driveVoltageMin = _config.driveMotor.motor.Voltage(-maxDriveTorque, driveAngularVelocity);
+  driveVoltage = units::math::max(units::math::min(driveVoltage, driveVoltageMax), driveVoltageMin);
 
   //driveVoltage = units::math::min(driveVoltage, 10_V);
   turnVoltage = units::math::min(turnVoltage, 7_V);
 
-  driveVoltage = units::math::min(units::math::max(driveVoltage, -4_V), 4_V); // was originally 10_V
+  driveVoltage = units::math::min(units::math::max(driveVoltage, -_config.maxDriveVoltage), _config.maxDriveVoltage);
   turnVoltage = units::math::min(units::math::max(turnVoltage, -7_V), 7_V);
 
   // turnVoltage = units::math::min(turnVoltage, 6_V);
@@ -75,23 +85,26 @@ void SwerveModule::OnUpdate(units::second_t dt) {
   _config.driveMotor.transmission->SetVoltage(driveVoltage);
   _config.turnMotor.transmission->SetVoltage(turnVoltage);
 
-  _table->GetEntry("speed").SetDouble(GetSpeed().value());
-  _table->GetEntry("angle").SetDouble(_config.turnMotor.encoder->GetEncoderPosition().convert<units::degree>().value());
+  _table->GetEntry("speed").SetDouble(speed.value());
+  _table->GetEntry("angle").SetDouble(turnAngle.convert<units::degree>().value());
   _config.WriteNT(_table->GetSubTable("config"));
 }
 
-void SwerveModule::SetAccelerationLimit(units::meters_per_second_squared_t limit){
-  _currentAccelerationLimit = limit;
+units::meters_per_second_t SwerveModule::MaxSpeed() const {
+  units::radians_per_second_t free = _config.driveMotor.motor.Speed(0_Nm, _config.maxDriveVoltage);
+  return units::meters_per_second_t{free.value() * _config.wheelRadius.value()};
 }
 
-void SwerveDrive::SetAccelerationLimit(units::meters_per_second_squared_t limit){
-  for (int motorNumber = 0; motorNumber < 4; motorNumber++){
-    _modules[motorNumber].SetAccelerationLimit(limit);
-  }
+template<size_t N>
+void SwerveDrive<N>::SetAccelerationLimit(units::meters_per_second_squared_t limit){
+  _setpointGenerator.GetConfig().maxAcceleration = limit;
 }
 
 void SwerveModule::SetIdle() {
   _state = SwerveModuleState::kIdle;
+  // The setpoint is where the generator picks up from, and an idle module isn't
+  // being driven anywhere. The angle is kept so the wheels aren't steered back.
+  _velocityPIDController.SetSetpoint(0_mps);
 }
 
 void SwerveModule::SetPID(units::radian_t angle, units::meters_per_second_t speed, units::second_t dt) {
@@ -137,27 +150,70 @@ frc::SwerveModulePosition SwerveModule::GetPosition() const {
   };
 }
 
+frc::SwerveModulePosition SwerveModule::ReadPosition() const {
+  return frc::SwerveModulePosition {
+    units::meter_t{ _config.driveMotor.encoder->ReadEncoderPosition().value() * _config.wheelRadius.value() },
+    _config.turnMotor.encoder->ReadEncoderPosition()
+  };
+}
+
+frc::SwerveModuleState SwerveModule::GetSetpoint() const {
+  return frc::SwerveModuleState {
+    _velocityPIDController.GetSetpoint(),
+    frc::Rotation2d{_anglePIDController.GetSetpoint()}
+  };
+}
+
 const SwerveModuleConfig &SwerveModule::GetConfig() const {
   return _config;
 }
 
-void SwerveDriveConfig::WriteNT(std::shared_ptr<nt::NetworkTable> table) {
+template<size_t N>
+void SwerveDriveConfig<N>::WriteNT(std::shared_ptr<nt::NetworkTable> table) {
   table->GetEntry("mass").SetDouble(mass.value());
 }
 
-SwerveDrive::SwerveDrive(SwerveDriveConfig config, frc::Pose2d initialPose) :
+template<size_t N>
+static wpi::array<frc::Translation2d, N> ModuleTranslations(const wpi::array<SwerveModuleConfig, N> &modules) {
+  wpi::array<frc::Translation2d, N> translations(wpi::empty_array);
+  unroll<N>([&](auto i) { translations[i] = modules[i].position; });
+  return translations;
+}
+
+template<size_t N>
+static wpi::array<frc::SwerveModulePosition, N> ZeroPositions() {
+  wpi::array<frc::SwerveModulePosition, N> positions(wpi::empty_array);
+  unroll<N>([&](auto i) { positions[i] = frc::SwerveModulePosition{ 0_m, frc::Rotation2d{0_deg} }; });
+  return positions;
+}
+
+template<size_t N>
+std::array<SwerveModule, N> SwerveDrive<N>::MakeModules(const config_t &config) {
+  return [&]<size_t... I>(std::index_sequence<I...>) {
+    return std::array<SwerveModule, N>{
+      SwerveModule(config.path + "/modules/" + std::to_string(I + 1), config.modules[I], config.anglePID, config.velocityPID)...
+    };
+  }(std::make_index_sequence<N>{});
+}
+
+// No faster than the slowest module can be driven, so the generator scales the
+// chassis down before any module saturates
+template<size_t N>
+static SwerveSetpointConfig LimitToModules(SwerveSetpointConfig config, const std::array<SwerveModule, N> &modules) {
+  for (auto &mod : modules)
+    config.maxModuleSpeed = units::math::min(config.maxModuleSpeed, mod.MaxSpeed());
+  return config;
+}
+
+template<size_t N>
+SwerveDrive<N>::SwerveDrive(config_t config, frc::Pose2d initialPose) :
   _config(config),
-  _kinematics( _config.modules[0].position, _config.modules[1].position, _config.modules[2].position, _config.modules[3].position),
-  _poseEstimator(
+  _modules(MakeModules(_config)),
+  _kinematics(ModuleTranslations(_config.modules)),
+  _setpointGenerator(_kinematics, LimitToModules(_config.setpoint, _modules)),
+  _odometry(
     _kinematics, frc::Rotation2d(0_deg),
-    wpi::array<frc::SwerveModulePosition, 4> { 
-      frc::SwerveModulePosition { 0_m, frc::Rotation2d{0_deg} },
-      frc::SwerveModulePosition { 0_m, frc::Rotation2d{0_deg} },
-      frc::SwerveModulePosition { 0_m, frc::Rotation2d{0_deg} },
-      frc::SwerveModulePosition { 0_m, frc::Rotation2d{0_deg} }
-    },
-    initialPose,
-    _config.stateStdDevs, _config.visionMeasurementStdDevs
+    ZeroPositions<N>()
   ),
   _anglePIDController(config.path + "/pid/heading", _config.poseAnglePID),
   _xPIDController(config.path + "/pid/x", _config.posePositionPID),
@@ -167,32 +223,38 @@ SwerveDrive::SwerveDrive(SwerveDriveConfig config, frc::Pose2d initialPose) :
 
   _anglePIDController.SetWrap(360_deg);
 
-  int i = 1;
-  for (auto cfg : _config.modules) {
-    _modules.emplace_back(config.path + "/modules/" + std::to_string(i), cfg, config.anglePID, config.velocityPID);
-    i++;
+  // Same gain as frc::SwerveDrivePoseEstimator, so existing std devs carry over
+  for (size_t i = 0; i < 3; i++) {
+    double q = _config.stateStdDevs[i] * _config.stateStdDevs[i];
+    double r = _config.visionMeasurementStdDevs[i] * _config.visionMeasurementStdDevs[i];
+    _visionK[i] = q == 0 ? 0 : q / (q + std::sqrt(q * r));
   }
 
+  _odometry.ResetPosition(_config.gyro->GetRotation2d(), GetModulePositions(false), frc::Pose2d{});
   ResetPose(initialPose);
 }
 
+template<size_t N>
+SwerveDrive<N>::~SwerveDrive() {
+  StopOdometryThread();
+}
+
 
 frc::ChassisSpeeds FieldRelativeSpeeds::ToChassisSpeeds(const units::radian_t robotHeading) {
   return frc::ChassisSpeeds::FromFieldRelativeSpeeds(vx, vy, omega, frc::Rotation2d{robotHeading});
 }
 
-void SwerveDrive::OnUpdate(units::second_t dt) {
+template<size_t N>
+void SwerveDrive<N>::OnUpdate(units::second_t dt) {
   switch (_state) {
     case SwerveDriveState::kIdle:
-      for (auto mod = _modules.begin(); mod < _modules.end(); mod++) {
-        mod->SetIdle();
-      }
+      unroll<N>([&](auto i) { _modules[i].SetIdle(); });
       break;
     case SwerveDriveState::kPose:
       {
-        _target_fr_speeds.vx = _xPIDController.Calculate(GetPose().X(), dt);
-        _target_fr_speeds.vy = _yPIDController.Calculate(GetPose().Y(), dt);
-        _target_fr_speeds.omega = _anglePIDController.Calculate(GetPose().Rotation().Radians(), dt);
+        _target_fr_speeds.vx = _xPIDController.Calculate(GetPose().X(), dt, _pose_feedforward.vx);
+        _target_fr_speeds.vy = _yPIDController.Calculate(GetPose().Y(), dt, _pose_feedforward.vy);
+        _target_fr_speeds.omega = _anglePIDController.Calculate(GetPose().Rotation().Radians(), dt, _pose_feedforward.omega);
       }
       [[fallthrough]];
     case SwerveDriveState::kFieldRelativeVelocity:
@@ -200,10 +262,11 @@ void SwerveDrive::OnUpdate(units::second_t dt) {
       [[fallthrough]];
     case SwerveDriveState::kVelocity:
       {
-        auto target_states = _kinematics.ToSwerveModuleStates(_target_speed);
-        for (size_t i = 0; i < _modules.size(); i++) {
+        // Start from what the modules are already being driven to, whichever state set it
+        auto target_states = _setpointGenerator.Generate(GetModuleSetpoints(), _target_speed, dt);
+        unroll<N>([&](auto i) {
           _modules[i].SetPID(target_states[i].angle.Radians(), target_states[i].speed, dt);
-        }
+        });
       }
       break;
     case SwerveDriveState::kIndividualTuning: 
@@ -211,61 +274,59 @@ void SwerveDrive::OnUpdate(units::second_t dt) {
       break;
 
     case SwerveDriveState::kTuning:
-      for (size_t i = 0; i < _modules.size(); i++) {
-        _modules[i].SetPID(_angle, _speed, dt);
-      }
+      unroll<N>([&](auto i) { _modules[i].SetPID(_angle, _speed, dt); });
       break;
     case SwerveDriveState::kXWheels:
-      _modules[0].SetPID(45_deg, 0_mps, dt);
-      _modules[1].SetPID(135_deg, 0_mps, dt);
-      _modules[2].SetPID(315_deg, 0_mps, dt);
-      _modules[3].SetPID(225_deg, 0_mps, dt);
+      // Point each wheel through the centre of the robot so it can't roll
+      unroll<N>([&](auto i) {
+        _modules[i].SetPID(_config.modules[i].position.Angle().Radians(), 0_mps, dt);
+      });
       break;
   }
 
-  for (auto mod = _modules.begin(); mod < _modules.end(); mod++) {
-    mod->OnUpdate(dt);
-  }
+  unroll<N>([&](auto i) { _modules[i].OnUpdate(dt); });
 
-  _poseEstimator.Update(
-    _config.gyro->GetRotation2d(),
-    wpi::array<frc::SwerveModulePosition, 4>{
-      _modules[0].GetPosition(),
-      _modules[1].GetPosition(),
-      _modules[2].GetPosition(),
-      _modules[3].GetPosition()
-    }
-  );
+  if (!_odometryRunning)
+    UpdateOdometry(false);
 
-  WritePose2NT(_table->GetSubTable("estimatedPose"), _poseEstimator.GetEstimatedPosition());
+  WritePose2NT(_table->GetSubTable("estimatedPose"), GetPose());
   _config.WriteNT(_table->GetSubTable("config"));
 }
 
-void SwerveDrive::SetXWheelState(){
+template<size_t N>
+void SwerveDrive<N>::SetXWheelState(){
   _state = SwerveDriveState::kXWheels;
 }
 
 
-void SwerveDrive::OnStart() {
+template<size_t N>
+void SwerveDrive<N>::OnStart() {
   _xPIDController.Reset();
   _yPIDController.Reset();
   _anglePIDController.Reset();
 
-  for (auto mod = _modules.begin(); mod < _modules.end(); mod++) {
-    mod->OnStart();
-  }
+  // Zeroing moves the module angles under the odometry, so hold off the odometry
+  // thread and rebase it on the new readings rather than integrate the jump
+  std::lock_guard<std::mutex> lock(_estimatorMutex);
+  unroll<N>([&](auto i) { _modules[i].OnStart(); });
+  bool live = _odometryRunning;
+  frc::Rotation2d heading = live ? _config.gyro->ReadRotation2d() : _config.gyro->GetRotation2d();
+  _odometry.ResetPosition(heading, GetModulePositions(live), _odometry.GetPose());
 }
 
-void SwerveDrive::SetIdle() {
+template<size_t N>
+void SwerveDrive<N>::SetIdle() {
   _state = SwerveDriveState::kIdle;
 }
 
-void SwerveDrive::SetVelocity(frc::ChassisSpeeds speeds) {
+template<size_t N>
+void SwerveDrive<N>::SetVelocity(frc::ChassisSpeeds speeds) {
   _state = SwerveDriveState::kVelocity;
   _target_speed = speeds;
 }
 
-void SwerveDrive::SetIndividualTuning(int mod, units::radian_t angle, units::meters_per_second_t speed) {
+template<size_t N>
+void SwerveDrive<N>::SetIndividualTuning(int mod, units::radian_t angle, units::meters_per_second_t speed) {
   // _modules[mod].SetPID(angle, speed);
   _mod = mod;
   _angle = angle;
@@ -273,7 +334,8 @@ void SwerveDrive::SetIndividualTuning(int mod, units::radian_t angle, units::met
   _state = SwerveDriveState::kIndividualTuning;
 }
 
-void SwerveDrive::SetTuning(units::radian_t angle, units::meters_per_second_t speed) {
+template<size_t N>
+void SwerveDrive<N>::SetTuning(units::radian_t angle, units::meters_per_second_t speed) {
   
   _angle = angle;
   _speed = speed;
@@ -282,119 +344,379 @@ void SwerveDrive::SetTuning(units::radian_t angle, units::meters_per_second_t sp
 
 
 
-void SwerveDrive::SetFieldRelativeVelocity(FieldRelativeSpeeds speeds) {
+template<size_t N>
+void SwerveDrive<N>::SetFieldRelativeVelocity(FieldRelativeSpeeds speeds) {
   _state = SwerveDriveState::kFieldRelativeVelocity;
   _target_fr_speeds = speeds;
 }
 
-void SwerveDrive::SetPose(frc::Pose2d pose) {
+template<size_t N>
+void SwerveDrive<N>::SetPose(frc::Pose2d pose, FieldRelativeSpeeds feedforward) {
   _state = SwerveDriveState::kPose;
+  _pose_feedforward = feedforward;
   _anglePIDController.SetSetpoint(pose.Rotation().Radians());
   _xPIDController.SetSetpoint(pose.X());
   _yPIDController.SetSetpoint(pose.Y());
 }
 
-bool SwerveDrive::IsAtSetPose() {
+template<size_t N>
+bool SwerveDrive<N>::IsAtSetPose() {
   return _anglePIDController.IsStable() && _xPIDController.IsStable() && _yPIDController.IsStable();
 }
 
-void SwerveDrive::ResetPose(frc::Pose2d pose) {
-  _poseEstimator.ResetPosition(_config.gyro->GetRotation2d(),
-    wpi::array<frc::SwerveModulePosition, 4>{
-      _modules[0].GetPosition(),
-      _modules[1].GetPosition(),
-      _modules[2].GetPosition(),
-      _modules[3].GetPosition()
-    }, pose
-  );
+static frc::Pose2d ComposePose(const frc::Pose2d &a, const frc::Pose2d &b) {
+  return a.TransformBy(frc::Transform2d{frc::Pose2d{}, b});
+}
+
+static frc::Pose2d InversePose(const frc::Pose2d &a) {
+  return frc::Pose2d{}.TransformBy(frc::Transform2d{a, frc::Pose2d{}});
 }
 
-frc::Pose2d SwerveDrive::GetPose() {
-  return _poseEstimator.GetEstimatedPosition();
+static frc::Pose2d InterpolatePose(const frc::Pose2d &a, const frc::Pose2d &b, double t) {
+  frc::Twist2d twist = a.Log(b);
+  return a.Exp(frc::Twist2d{ twist.dx * t, twist.dy * t, twist.dtheta * t });
 }
 
-void SwerveDrive::AddVisionMeasurement(frc::Pose2d pose, units::second_t timestamp) {
-  _poseEstimator.AddVisionMeasurement(pose, timestamp);
+template<size_t N>
+void SwerveDrive<N>::ResetPose(frc::Pose2d pose) {
+  std::lock_guard<std::mutex> lock(_estimatorMutex);
+  frc::Pose2d odometry = _odometry.GetPose();
+  _odometryOrigin = ComposePose(pose, InversePose(odometry));
+  _resetTime = wom::now();
+  PushPose(_resetTime, odometry);
 }
 
+template<size_t N>
+frc::Pose2d SwerveDrive<N>::GetPose() {
+  auto latest = _poseHistory.Latest();
+  return latest.has_value() ? latest.value().pose : frc::Pose2d{};
+}
+
+template<size_t N>
+std::optional<frc::Pose2d> SwerveDrive<N>::GetPoseAt(units::second_t timestamp) {
+  std::lock_guard<std::mutex> lock(_estimatorMutex);
+  // Poses from before a reset were in a different frame
+  if (timestamp < _resetTime)
+    return {};
+  auto odometry = GetOdometryAt(timestamp);
+  if (!odometry.has_value())
+    return {};
+  return ComposePose(_odometryOrigin, odometry.value());
+}
+
+template<size_t N>
+void SwerveDrive<N>::AddVisionMeasurement(frc::Pose2d pose, units::second_t timestamp) {
+  std::lock_guard<std::mutex> lock(_estimatorMutex);
+  // Taken before the last reset, it would be applied in the new frame
+  if (timestamp < _resetTime)
+    return;
+  auto odometry = GetOdometryAt(timestamp);
+  if (!odometry.has_value())
+    return;
+
+  // Move the estimate at the time of measurement part way to the vision pose
+  frc::Pose2d estimate = ComposePose(_odometryOrigin, odometry.value());
+  frc::Twist2d error = estimate.Log(pose);
+  frc::Pose2d corrected = estimate.Exp(frc::Twist2d{
+    error.dx * _visionK[0], error.dy * _visionK[1], error.dtheta * _visionK[2]
+  });
+
+  // Re-anchor the odometry frame there. The odometry since the measurement is
+  // relative to it, so it is replayed onto the correction without being walked.
+  _odometryOrigin = ComposePose(corrected, InversePose(odometry.value()));
+
+  auto latest = _poseHistory.Latest();
+  PushPose(latest.has_value() ? latest.value().timestamp : wom::now(), _odometry.GetPose());
+}
+
+template<size_t N>
+std::optional<frc::Pose2d> SwerveDrive<N>::GetOdometryAt(units::second_t timestamp) {
+  size_t n = _poseHistory.Size();
+  if (n == 0)
+    return {};
+
+  TimestampedPose newest = _poseHistory.Get(0).value();
+  if (timestamp >= newest.timestamp)
+    return newest.odometry;
+
+  TimestampedPose oldest = _poseHistory.Get(n - 1).value();
+  if (timestamp < oldest.timestamp)
+    return {};
+
+  // Age increases as time decreases. Keep timestamp(lo) > t >= timestamp(hi).
+  size_t lo = 0, hi = n - 1;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (_poseHistory.Get(mid).value().timestamp <= timestamp)
+      hi = mid;
+    else
+      lo = mid;
+  }
+
+  TimestampedPose before = _poseHistory.Get(hi).value();
+  TimestampedPose after = _poseHistory.Get(lo).value();
+  double t = ((timestamp - before.timestamp) / (after.timestamp - before.timestamp)).value();
+  return InterpolatePose(before.odometry, after.odometry, t);
+}
+
+template<size_t N>
+void SwerveDrive<N>::PushPose(units::second_t timestamp, frc::Pose2d odometry) {
+  _poseHistory.Push(TimestampedPose{ timestamp, ComposePose(_odometryOrigin, odometry), odometry });
+}
+
+template<size_t N>
+wpi::array<frc::SwerveModuleState, N> SwerveDrive<N>::GetModuleSetpoints() const {
+  wpi::array<frc::SwerveModuleState, N> setpoints(wpi::empty_array);
+  unroll<N>([&](auto i) { setpoints[i] = _modules[i].GetSetpoint(); });
+  return setpoints;
+}
+
+template<size_t N>
+wpi::array<frc::SwerveModulePosition, N> SwerveDrive<N>::GetModulePositions(bool live) const {
+  wpi::array<frc::SwerveModulePosition, N> positions(wpi::empty_array);
+  unroll<N>([&](auto i) { positions[i] = live ? _modules[i].ReadPosition() : _modules[i].GetPosition(); });
+  return positions;
+}
+
+template<size_t N>
+void SwerveDrive<N>::UpdateOdometry(bool live) {
+  // Read under the lock too, so a reading from before OnStart zeroes the encoders
+  // can't be integrated after it. Stamped under the lock, so the history stays in
+  // time order with ResetPose's entries.
+  std::lock_guard<std::mutex> lock(_estimatorMutex);
+  frc::Rotation2d heading = live ? _config.gyro->ReadRotation2d() : _config.gyro->GetRotation2d();
+  auto positions = GetModulePositions(live);
+
+  // The thread can wake before the devices send a new frame. A repeated frame
+  // stamped now would record the robot as stopped since the last one, so wait
+  // for the next.
+  if (live) {
+    bool fresh = heading != _lastHeading;
+    unroll<N>([&](auto i) {
+      fresh = fresh || positions[i].distance != _lastPositions[i].distance || positions[i].angle != _lastPositions[i].angle;
+    });
+    if (!fresh)
+      return;
+  }
+  _lastHeading = heading;
+  _lastPositions = positions;
+
+  PushPose(wom::now(), _odometry.Update(heading, positions));
+}
+
+template<size_t N>
+void SwerveDrive<N>::StartOdometryThread(units::hertz_t rate) {
+  if (_odometryRunning.exchange(true))
+    return;
+
+  // Otherwise most wakeups would see the same CAN frame as the last
+  for (auto &mod : _config.modules) {
+    mod.driveMotor.encoder->SetUpdateRate(rate);
+    mod.turnMotor.encoder->SetUpdateRate(rate);
+  }
+
+  _odometryThread = std::thread([this, rate]() {
+    // Fails quietly without the privileges to set RT priority, e.g. in simulation
+    frc::SetCurrentThreadPriority(true, 15);
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / rate.value())
+    );
+    auto next = std::chrono::steady_clock::now();
+
+    while (_odometryRunning) {
+      UpdateOdometry(true);
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+  });
+}
+
+template<size_t N>
+void SwerveDrive<N>::StopOdometryThread() {
+  _odometryRunning = false;
+  if (_odometryThread.joinable())
+    _odometryThread.join();
+}
+
+template struct wom::SwerveDriveConfig<3>;
+template struct wom::SwerveDriveConfig<4>;
+template class wom::SwerveDrive<3>;
+template class wom::SwerveDrive<4>;
+
 /* SIMULATION */
 
-wom::sim::SwerveDriveSim::SwerveDriveSim(SwerveDriveConfig config, units::kilogram_square_meter_t moduleJ)
-  : config(config), kinematics(config.modules[0].position, config.modules[1].position, config.modules[2].position, config.modules[3].position),
+template<size_t N>
+wom::sim::SwerveDriveSim<N>::SwerveDriveSim(SwerveDriveConfig<N> config, units::kilogram_square_meter_t moduleJ, SwerveDriveSimConfig simConfig)
+  : config(config), simConfig(simConfig), kinematics(ModuleTranslations(config.modules)),
     moduleJ(moduleJ),
     table(nt::NetworkTableInstance::GetDefault().GetTable(config.path + "/sim")),
-    gyro(config.gyro->MakeSimGyro())
+    gyro(config.gyro->MakeSimGyro()),
+    _gyroModel(simConfig.gyro),
+    _moduleMass(config.mass / (double)N)
   {
-    for (size_t i = 0; i < config.modules.size(); i++) {
-      driveEncoders.push_back(config.modules[i].driveMotor.encoder->MakeSimEncoder());
-      turnEncoders.push_back(config.modules[i].turnMotor.encoder->MakeSimEncoder());
-    }
-  }
+    Eigen::Matrix<double, 2 * N, 3> inverseKinematics;
 
-void wom::sim::SwerveDriveSim::Update(units::second_t dt) {
+    for (size_t i = 0; i < N; i++) {
+      const SwerveModuleConfig &module = config.modules[i];
+      driveEncoders[i] = module.driveMotor.encoder->MakeSimEncoder();
+      turnEncoders[i] = module.turnMotor.encoder->MakeSimEncoder();
 
-  Eigen::Vector2d resultantForceVector{0, 0};
+      _drive.invR(i) = 1 / module.driveMotor.motor.R.value();
+      _drive.invKv(i) = 1 / module.driveMotor.motor.Kv.value();
+      _drive.Kt(i) = module.driveMotor.motor.Kt.value();
+      _turn.invR(i) = 1 / module.turnMotor.motor.R.value();
+      _turn.invKv(i) = 1 / module.turnMotor.motor.Kv.value();
+      _turn.Kt(i) = module.turnMotor.motor.Kt.value();
+      _wheelRadius(i) = module.wheelRadius.value();
 
-  totalCurrent = 0_A;
+      inverseKinematics.row(2 * i) << 1, 0, -module.position.Y().value();
+      inverseKinematics.row(2 * i + 1) << 0, 1, module.position.X().value();
 
-  for (size_t i = 0; i < config.modules.size(); i++) {
-    /* Calculate drive motor forces */
-    driveCurrents[i] = config.modules[i].driveMotor.motor.Current(
-      driveSpeeds[i],
-      config.modules[i].driveMotor.transmission->GetEstimatedRealVoltage()
-    );
-    auto drive_torque = config.modules[i].driveMotor.motor.Torque(driveCurrents[i]);
-    units::newton_t force_magnitude = drive_torque / config.modules[i].wheelRadius;
-    totalCurrent += driveCurrents[i];
-
-    driveVelocity[i] += force_magnitude / (config.mass / 4) * dt;
-    driveSpeeds[i] = 1_rad * driveVelocity[i] / config.modules[i].wheelRadius;
-    driveEncoderAngles[i] += driveSpeeds[i] * dt;
-    driveEncoders[i]->SetEncoderTurnVelocity(driveSpeeds[i]);
-    driveEncoders[i]->SetEncoderTurns(driveEncoderAngles[i]);
-
-    /* Reconcile turning motor - assuming no losses or wheel slip */
-    turnCurrents[i] = config.modules[i].turnMotor.motor.Current(
-      turnSpeeds[i],
-      config.modules[i].turnMotor.transmission->GetEstimatedRealVoltage()
+      _entries.turnTorque[i] = table->GetSubTable("modules/" + std::to_string(i))->GetEntry("turnTorque");
+    }
+
+    _forwardKinematics = inverseKinematics.completeOrthogonalDecomposition().pseudoInverse();
+
+    // A DC motor driving an inertia decays to its free speed at Kt / (R Kv J)
+    vector_t driveInertia = _moduleMass.value() * _wheelRadius.array().square();
+    stiffness = std::max(
+      (_drive.Kt.array() * _drive.invR.array() * _drive.invKv.array() / driveInertia.array()).maxCoeff(),
+      (_turn.Kt.array() * _turn.invR.array() * _turn.invKv.array()).maxCoeff() / moduleJ.value()
     );
-    totalCurrent += turnCurrents[i];
 
-    auto turn_torque = config.modules[i].turnMotor.motor.Torque(turnCurrents[i]);
-    turnSpeeds[i] += 1_rad * turn_torque / moduleJ * dt;
-    turnAngles[i] += turnSpeeds[i] * dt;
-    turnEncoders[i]->SetEncoderTurnVelocity(turnSpeeds[i]);
-    turnEncoders[i]->SetEncoderTurns(turnAngles[i]);
+    _entries.vx = table->GetEntry("vx");
+    _entries.vy = table->GetEntry("vy");
+    _entries.angle = table->GetEntry("angle");
+    _entries.angularVelocity = table->GetEntry("angularVelocity");
+    _entries.x = table->GetEntry("x");
+    _entries.y = table->GetEntry("y");
+    _entries.totalCurrent = table->GetEntry("totalCurrent");
+    _entries.substeps = table->GetEntry("substeps");
+  }
 
-    auto mtable = table->GetSubTable("modules/" + std::to_string(i));
-    mtable->GetEntry("turnTorque").SetDouble(turn_torque.value());
+template<size_t N>
+Eigen::Vector3d wom::sim::SwerveDriveSim<N>::ChassisSpeeds(const vector_t &velocity, const vector_t &turnAngle) const {
+  // Interleaved [ vx0, vy0, vx1, vy1, ... ] to match the kinematics rows
+  Eigen::Matrix<double, 2, N> moduleVelocities;
+  moduleVelocities.row(0) = (velocity.array() * turnAngle.array().cos()).transpose();
+  moduleVelocities.row(1) = (velocity.array() * turnAngle.array().sin()).transpose();
+  return _forwardKinematics * Eigen::Map<const Eigen::Matrix<double, 2 * N, 1>>(moduleVelocities.data());
+}
+
+template<size_t N>
+typename wom::sim::SwerveDriveSim<N>::state_t wom::sim::SwerveDriveSim<N>::Derivative(
+    const state_t &state, const vector_t &driveVoltages, const vector_t &turnVoltages) const {
+  auto velocity = state.template segment<N>(0).array();
+  auto turnSpeed = state.template segment<N>(N).array();
+  auto driveSpeed = velocity / _wheelRadius.array();
+
+  state_t dstate;
+
+  /* Drive motors accelerate each module's share of the robot's mass. I = (V - w / Kv) / R */
+  auto driveCurrent = (driveVoltages.array() - driveSpeed * _drive.invKv.array()) * _drive.invR.array();
+  dstate.template segment<N>(0) = (_drive.Kt.array() * driveCurrent / _wheelRadius.array() / _moduleMass.value()).matrix();
+
+  /* External force, in the robot frame, along each wheel */
+  double angle = state(4 * N + 2);
+  if (!externalForce.isZero()) {
+    double fx = externalForce(0) * std::cos(angle) + externalForce(1) * std::sin(angle);
+    double fy = -externalForce(0) * std::sin(angle) + externalForce(1) * std::cos(angle);
+    auto turnAngle = state.template segment<N>(3 * N).array();
+    dstate.template segment<N>(0) += ((fx * turnAngle.cos() + fy * turnAngle.sin()) / (double)N / _moduleMass.value()).matrix();
   }
 
-  auto chassis_state = kinematics.ToChassisSpeeds(
-    frc::SwerveModuleState { driveVelocity[0], frc::Rotation2d{turnAngles[0]} },
-    frc::SwerveModuleState { driveVelocity[1], frc::Rotation2d{turnAngles[1]} },
-    frc::SwerveModuleState { driveVelocity[2], frc::Rotation2d{turnAngles[2]} },
-    frc::SwerveModuleState { driveVelocity[3], frc::Rotation2d{turnAngles[3]} }
-  );
+  /* Turning motors - assuming no losses or wheel slip */
+  auto turnCurrent = (turnVoltages.array() - turnSpeed * _turn.invKv.array()) * _turn.invR.array();
+  dstate.template segment<N>(N) = (_turn.Kt.array() * turnCurrent / moduleJ.value()).matrix();
 
-  /* Get body angular velocity and angle */
-  angularVelocity = chassis_state.omega;
-  angle += angularVelocity * dt;
+  dstate.template segment<N>(2 * N) = driveSpeed.matrix();
+  dstate.template segment<N>(3 * N) = turnSpeed.matrix();
 
-  vx = chassis_state.vx;
-  vy = chassis_state.vy;
+  // Note vx, vy are in robot frame whilst x, y are in world frame
+  Eigen::Vector3d chassis = ChassisSpeeds(state.template segment<N>(0), state.template segment<N>(3 * N));
+  dstate(4 * N) = chassis(0) * std::cos(angle) - chassis(1) * std::sin(angle);
+  dstate(4 * N + 1) = chassis(0) * std::sin(angle) + chassis(1) * std::cos(angle);
+  dstate(4 * N + 2) = chassis(2);
 
-  x += (vx * units::math::cos(angle) - vy * units::math::sin(angle)) * dt;
-  y += (vx * units::math::sin(angle) + vy * units::math::cos(angle)) * dt;
+  return dstate;
+}
 
+template<size_t N>
+void wom::sim::SwerveDriveSim<N>::Update(units::second_t dt) {
+  // Voltages are held for the whole step
+  vector_t driveVoltages, turnVoltages;
+  for (size_t i = 0; i < N; i++) {
+    driveVoltages(i) = config.modules[i].driveMotor.transmission->GetEstimatedRealVoltage().value();
+    turnVoltages(i) = config.modules[i].turnMotor.transmission->GetEstimatedRealVoltage().value();
+  }
+
+  state_t state;
+  state << driveVelocity, turnSpeeds, driveEncoderAngles, turnAngles, x.value(), y.value(), angle.value();
+
+  substeps = std::max(
+    Substeps(simConfig.integrator, stiffness, dt.value(), simConfig.stiffnessSafety, simConfig.maxSubsteps),
+    std::min((int)std::ceil((dt / simConfig.maxSubstep).value()), simConfig.maxSubsteps)
+  );
+  double h = dt.value() / substeps;
+  auto f = [&](const state_t &s) { return Derivative(s, driveVoltages, turnVoltages); };
+  for (int step = 0; step < substeps; step++)
+    state = Step(simConfig.integrator, f, state, h, 2 * N);
+
+  driveVelocity = state.template segment<N>(0);
+  turnSpeeds = state.template segment<N>(N);
+  driveEncoderAngles = state.template segment<N>(2 * N);
+  turnAngles = state.template segment<N>(3 * N);
+  driveSpeeds = driveVelocity.cwiseQuotient(_wheelRadius);
+
+  driveCurrents = ((driveVoltages - driveSpeeds.cwiseProduct(_drive.invKv)).cwiseProduct(_drive.invR));
+  turnCurrents = ((turnVoltages - turnSpeeds.cwiseProduct(_turn.invKv)).cwiseProduct(_turn.invR));
+  totalCurrent = units::ampere_t{driveCurrents.sum() + turnCurrents.sum()};
+
+  for (size_t i = 0; i < N; i++) {
+    driveEncoders[i]->SetEncoderTurnVelocity(units::radians_per_second_t{driveSpeeds(i)});
+    driveEncoders[i]->SetEncoderTurns(units::radian_t{driveEncoderAngles(i)});
+    turnEncoders[i]->SetEncoderTurnVelocity(units::radians_per_second_t{turnSpeeds(i)});
+    turnEncoders[i]->SetEncoderTurns(units::radian_t{turnAngles(i)});
+  }
+
+  /* Get body velocity, angular velocity and angle */
+  Eigen::Vector3d chassis = ChassisSpeeds(driveVelocity, turnAngles);
+  vx = units::meters_per_second_t{chassis(0)};
+  vy = units::meters_per_second_t{chassis(1)};
+  angularVelocity = units::radians_per_second_t{chassis(2)};
+
+  x = units::meter_t{state(4 * N)};
+  y = units::meter_t{state(4 * N + 1)};
+  angle = units::radian_t{state(4 * N + 2)};
+
+  if (simConfig.publishNT)
+    Publish();
+
+  // The gyro reads CW+
+  SimGyroReading reading = _gyroModel.Update(dt, SimGyroReading{ -angle, -angularVelocity, pitch, roll });
+  gyro->SetAngle(reading.angle);
+  gyro->SetRate(reading.rate);
+  gyro->SetPitch(reading.pitch);
+  gyro->SetRoll(reading.roll);
+}
+
+template<size_t N>
+void wom::sim::SwerveDriveSim<N>::Publish() {
   // Note vx, vy are in robot frame whilst x, y are in world frame
-  table->GetEntry("vx").SetDouble(vx.value());
-  table->GetEntry("vy").SetDouble(vy.value());
-  table->GetEntry("angle").SetDouble(angle.convert<units::degree>().value());
-  table->GetEntry("angularVelocity").SetDouble(angularVelocity.convert<units::degrees_per_second>().value());
-  table->GetEntry("x").SetDouble(x.value());
-  table->GetEntry("y").SetDouble(y.value());
-  table->GetEntry("totalCurrent").SetDouble(totalCurrent.value());
-
-  gyro->SetAngle(-angle);
-}
\ No newline at end of file
+  _entries.vx.SetDouble(vx.value());
+  _entries.vy.SetDouble(vy.value());
+  _entries.angle.SetDouble(angle.convert<units::degree>().value());
+  _entries.angularVelocity.SetDouble(angularVelocity.convert<units::degrees_per_second>().value());
+  _entries.x.SetDouble(x.value());
+  _entries.y.SetDouble(y.value());
+  _entries.totalCurrent.SetDouble(totalCurrent.value());
+  _entries.substeps.SetDouble(substeps);
+
+  vector_t turnTorque = _turn.Kt.cwiseProduct(turnCurrents);
+  for (size_t i = 0; i < N; i++)
+    _entries.turnTorque[i].SetDouble(turnTorque(i));
+}
+
+template class wom::sim::SwerveDriveSim<3>;
+template class wom::sim::SwerveDriveSim<4>;
@@ -7,6 +7,7 @@
 
 #include <frc/DigitalInput.h>
 #include <frc/simulation/DIOSim.h>
+#include <units/angular_acceleration.h>
 #include <units/mass.h>
 #include <units/voltage.h>
 #include <units/current.h>
@@ -53,6 +54,8 @@ namespace wom {
 
     units::radian_t GetAngle() const;
     units::radians_per_second_t MaxSpeed() const;
+    //the fastest the arm can speed up, at stall torque while holding itself up horizontally
+    units::radians_per_second_squared_t MaxAcceleration() const;
     
     bool IsStable() const;
   private:
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wom {
+  /**
+   * A polygon the arm must stay out of, e.g. the frame, bumpers or intake, seen
+   * from the side in the robot frame: x forward and y up from the floor, in metres,
+   * with the elevator at x = 0.
+   */
+  struct CollisionShape {
+    std::string name;
+    std::vector<Eigen::Vector2d> vertices;
+
+    static CollisionShape Box(std::string name, units::meter_t xmin, units::meter_t ymin, units::meter_t xmax, units::meter_t ymax);
+  };
+
+  /**
+   * The geometry of an arm pivoting on the carriage of an elevator. Angle 0 is the
+   * arm pointing forward, 90 degrees is straight up. Height is the height of the
+   * carriage, as the elevator measures it.
+   */
+  struct ArmElevatorGeometry {
+    units::meter_t armLength;
+    // Half the thickness of the arm, including whatever it's holding
+    units::meter_t armRadius = 0_m;
+
+    units::radian_t minAngle;
+    units::radian_t maxAngle;
+    units::meter_t minHeight;
+    units::meter_t maxHeight;
+
+    // Where the arm pivots, relative to the carriage
+    units::meter_t pivotX = 0_m;
+    units::meter_t pivotY = 0_m;
+
+    // The arm may not reach below the floor or above the ceiling, e.g. the height
+    // limit. Only the arm is limited, the carriage goes wherever the elevator's
+    // range allows.
+    std::optional<units::meter_t> floor = std::nullopt;
+    std::optional<units::meter_t> ceiling = std::nullopt;
+
+    std::vector<CollisionShape> shapes{};
+
+    // How far the arm may move within one collision check, smaller is slower but
+    // marks fewer free configurations as occupied near obstacles
+    units::meter_t tolerance = 0.01_m;
+  };
+
+  /**
+   * Generates the configuration space (angle, height) occupancy grid of an arm on
+   * an elevator from its geometry, instead of writing it by hand.
+   *
+   * A cell is occupied if the arm collides anywhere in the range of angles and
+   * heights it covers, not just at its centre. Each cell is split up finely enough
+   * that no point on the arm moves more than the tolerance within a piece, and the
+   * arm is checked at the centre of each piece, thickened by the tolerance. Rows
+   * are checked in parallel.
+   *
+   * Generating is still too slow to do at every startup for fine grids, so
+   * LoadOrGenerate keeps them on disk, named by a hash of the geometry, and only
+   * generates when the geometry has changed.
+   */
+  class ArmElevatorCSpace {
+   public:
+    using grid_t = DiscretisedOccupancyGrid<units::radian, units::meter>;
+
+    struct FileHeader {
+      char magic[4];
+      uint32_t version;
+      uint64_t hash;
+      uint32_t cols;
+      uint32_t rows;
+    };
+
+    static constexpr uint32_t kVersion = 2;
+
+    /**
+     * Generate the grid, with angle along x and height along y.
+     * @param threads The number of threads to check rows on, 0 for one per core.
+     */
+    static grid_t Generate(const ArmElevatorGeometry &geometry, int angleCells, int heightCells, unsigned int threads = 0);
+
+    /**
+     * Load the grid for this geometry from cacheDir, or generate it and save it
+     * there if it's missing or unreadable. Failing to save is not an error.
+     */
+    static grid_t LoadOrGenerate(const ArmElevatorGeometry &geometry, int angleCells, int heightCells, std::string cacheDir);
+
+    /**
+     * The hash of everything that changes the generated grid.
+     */
+    static uint64_t Hash(const ArmElevatorGeometry &geometry, int angleCells, int heightCells);
+
+    /**
+     * The file the grid for this geometry is kept in, inside cacheDir.
+     */
+    static std::string CachePath(const ArmElevatorGeometry &geometry, int angleCells, int heightCells, std::string cacheDir);
+
+    /**
+     * Whether the arm at this angle and height, thickened by margin, hits anything.
+     */
+    static bool Collides(const ArmElevatorGeometry &geometry, units::radian_t angle, units::meter_t height, units::meter_t margin = 0_m);
+  };
+}
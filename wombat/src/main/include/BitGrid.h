@@ -0,0 +1,208 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace wom {
+  /**
+   * A 2D grid of bits, packed 64 cells to a word along each row. Bulk operations
+   * work a word at a time over contiguous rows, in plain loops the compiler can
+   * vectorise for whatever the target has (SSE/AVX on desktop, NEON on the rio).
+   *
+   * Bits past the last column of each row are always 0, so whole words can be
+   * compared and counted.
+   */
+  class BitGrid {
+   public:
+    using word_t = uint64_t;
+    static constexpr int kWordBits = 64;
+
+    BitGrid() : BitGrid(0, 0) {}
+
+    BitGrid(int cols, int rows)
+      : _cols(cols), _rows(rows), _stride((cols + kWordBits - 1) / kWordBits), _words((size_t)_stride * rows, 0) {}
+
+    // Nonzero entries are set. Rows of the matrix are rows of the grid.
+    explicit BitGrid(const Eigen::MatrixXi &matrix) : BitGrid((int)matrix.cols(), (int)matrix.rows()) {
+      for (int y = 0; y < _rows; y++)
+        for (int x = 0; x < _cols; x++)
+          if (matrix(y, x))
+            Set(x, y, true);
+    }
+
+    int Cols() const { return _cols; }
+    int Rows() const { return _rows; }
+    size_t Size() const { return (size_t)_cols * _rows; }
+    // Words per row
+    int Stride() const { return _stride; }
+
+    bool Get(int x, int y) const {
+      return (Row(y)[x / kWordBits] >> (x % kWordBits)) & 1;
+    }
+
+    void Set(int x, int y, bool value) {
+      word_t bit = word_t{1} << (x % kWordBits);
+      word_t &word = Row(y)[x / kWordBits];
+      word = value ? (word | bit) : (word & ~bit);
+    }
+
+    // Set a whole row from one bool per column
+    void SetRow(int y, const bool *values) {
+      word_t *row = Row(y);
+      for (int w = 0; w < _stride; w++) {
+        word_t word = 0;
+        int end = std::min(kWordBits, _cols - w * kWordBits);
+        for (int b = 0; b < end; b++)
+          word |= word_t{values[w * kWordBits + b]} << b;
+        row[w] = word;
+      }
+    }
+
+    word_t *Row(int y) { return _words.data() + (size_t)y * _stride; }
+    const word_t *Row(int y) const { return _words.data() + (size_t)y * _stride; }
+
+    void Fill(bool value) {
+      std::fill(_words.begin(), _words.end(), value ? ~word_t{0} : word_t{0});
+      if (value)
+        ClearPadding();
+    }
+
+    size_t Count() const {
+      size_t count = 0;
+      for (word_t word : _words)
+        count += std::popcount(word);
+      return count;
+    }
+
+    /**
+     * First column at or after x in row y that is set (or clear), or Cols() if
+     * there isn't one.
+     */
+    int NextSet(int y, int x) const { return Scan(y, x, 0); }
+    int NextClear(int y, int x) const { return Scan(y, x, ~word_t{0}); }
+
+    BitGrid &operator|=(const BitGrid &other) {
+      CheckSize(other);
+      for (size_t i = 0; i < _words.size(); i++)
+        _words[i] |= other._words[i];
+      return *this;
+    }
+
+    BitGrid &operator&=(const BitGrid &other) {
+      CheckSize(other);
+      for (size_t i = 0; i < _words.size(); i++)
+        _words[i] &= other._words[i];
+      return *this;
+    }
+
+    void Invert() {
+      for (word_t &word : _words)
+        word = ~word;
+      ClearPadding();
+    }
+
+    /**
+     * Grow every set cell into a (2 rx + 1) x (2 ry + 1) rectangle, e.g. to
+     * inflate obstacles by the robot's footprint. Cells off the grid count as clear.
+     */
+    void Dilate(int rx, int ry) {
+      std::vector<word_t> shifted(_stride * 2);
+      for (int y = 0; y < _rows; y++) {
+        word_t *row = Row(y);
+        // Dilating by d then by up to d + 1 covers 2d + 1, so this is O(log rx) passes
+        for (int covered = 0; covered < rx;) {
+          int step = std::min(covered + 1, rx - covered);
+          ShiftRow(row, shifted.data(), step);
+          ShiftRow(row, shifted.data() + _stride, -step);
+          for (int w = 0; w < _stride; w++)
+            row[w] |= shifted[w] | shifted[_stride + w];
+          covered += step;
+        }
+      }
+      ClearPadding();
+
+      std::vector<word_t> previous;
+      for (int covered = 0; covered < ry;) {
+        int step = std::min(covered + 1, ry - covered);
+        previous = _words;
+        for (int y = 0; y < _rows; y++) {
+          word_t *row = Row(y);
+          const word_t *above = y - step >= 0 ? previous.data() + (size_t)(y - step) * _stride : nullptr;
+          const word_t *below = y + step < _rows ? previous.data() + (size_t)(y + step) * _stride : nullptr;
+          for (int w = 0; w < _stride; w++)
+            row[w] |= (above ? above[w] : 0) | (below ? below[w] : 0);
+        }
+        covered += step;
+      }
+    }
+
+    Eigen::MatrixXi ToMatrix() const {
+      Eigen::MatrixXi matrix(_rows, _cols);
+      for (int y = 0; y < _rows; y++)
+        for (int x = 0; x < _cols; x++)
+          matrix(y, x) = Get(x, y);
+      return matrix;
+    }
+
+    bool operator==(const BitGrid &other) const {
+      return _cols == other._cols && _rows == other._rows && _words == other._words;
+    }
+
+   private:
+    void CheckSize(const BitGrid &other) const {
+      if (other._cols != _cols || other._rows != _rows)
+        throw std::invalid_argument("Rows / Cols Mismatch!");
+    }
+
+    void ClearPadding() {
+      int used = _cols % kWordBits;
+      if (used == 0)
+        return;
+      word_t mask = (word_t{1} << used) - 1;
+      for (int y = 0; y < _rows; y++)
+        Row(y)[_stride - 1] &= mask;
+    }
+
+    // Move every bit of a row s columns towards higher x (or lower, if s is negative)
+    void ShiftRow(const word_t *in, word_t *out, int s) const {
+      int words = std::abs(s) / kWordBits, bits = std::abs(s) % kWordBits;
+      for (int w = 0; w < _stride; w++) {
+        int src = s >= 0 ? w - words : w + words;
+        word_t a = (src >= 0 && src < _stride) ? in[src] : 0;
+        if (bits == 0) {
+          out[w] = a;
+        } else if (s >= 0) {
+          word_t b = (src - 1 >= 0 && src - 1 < _stride) ? in[src - 1] : 0;
+          out[w] = (a << bits) | (b >> (kWordBits - bits));
+        } else {
+          word_t b = (src + 1 >= 0 && src + 1 < _stride) ? in[src + 1] : 0;
+          out[w] = (a >> bits) | (b << (kWordBits - bits));
+        }
+      }
+    }
+
+    int Scan(int y, int x, word_t invert) const {
+      if (x >= _cols)
+        return _cols;
+      const word_t *row = Row(y);
+      int w = x / kWordBits;
+      // Ignore the bits before x
+      word_t word = (row[w] ^ invert) & (~word_t{0} << (x % kWordBits));
+      while (true) {
+        if (word != 0)
+          return std::min(w * kWordBits + std::countr_zero(word), _cols);
+        if (++w >= _stride)
+          return _cols;
+        word = row[w] ^ invert;
+      }
+    }
+
+    int _cols, _rows, _stride;
+    std::vector<word_t> _words;
+  };
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <bit>
+#include <deque>
+#include <limits>
+#include <vector>
+
+namespace wom {
+  /**
+   * An incremental planner over a DiscretisedOccupancyGrid (D* Lite, Koenig &
+   * Likhachev 2002). It searches backwards from a fixed goal and keeps the
+   * search between calls, so when cells of the grid change or the start moves,
+   * Plan only repairs the part of the search those changes affect instead of
+   * starting again.
+   *
+   * Moves and costs are the same as AStarStrict. Changes to the grid are found
+   * by comparing it with a snapshot taken at the last Plan, so the grid can be
+   * edited any way in between. The planner keeps a reference to the grid, which
+   * must outlive it.
+   */
+  template<typename T_X, typename T_Y, typename CostT>
+  class DStarLite {
+   public:
+    using grid_t = DiscretisedOccupancyGrid<T_X, T_Y>;
+    using Idx_t = typename grid_t::Idx_t;
+    using path_t = std::deque<typename grid_t::template GridPathNode<CostT>>;
+    using dx_cost_t = typename grid_t::template converting_unit<T_X, CostT>;
+    using dy_cost_t = typename grid_t::template converting_unit<T_Y, CostT>;
+
+    DStarLite(grid_t &grid, dx_cost_t dxCost, dy_cost_t dyCost)
+      : _grid(grid), _dxCost(dxCost), _dyCost(dyCost) { }
+
+    /**
+     * Plan towards a new goal. This throws away the search so far.
+     */
+    void SetGoal(Idx_t goal) {
+      _goal = goal;
+      _hasGoal = true;
+      _initialised = false;
+    }
+
+    /**
+     * The best path from start to the goal, as AStarStrict would return it. Blank
+     * if there's no goal, either end is in an obstacle, or there's no way through.
+     */
+    path_t Plan(Idx_t start) {
+      _expanded = 0;
+      if (!_hasGoal)
+        return path_t{};
+
+      if (!_initialised || _snapshot.Cols() != _grid.GetBits().Cols() || _snapshot.Rows() != _grid.GetBits().Rows()) {
+        Initialise(start);
+      } else {
+        // The heuristic is from the start, so moving it shifts the keys of
+        // everything in the queue by up to the distance moved. Add that to new
+        // keys instead of reordering the queue.
+        _km += _step.Octile(_last, start);
+        _last = start;
+        UpdateChangedCells();
+      }
+
+      if (_grid.Get(start) || _grid.Get(_goal))
+        return path_t{};
+
+      ComputeShortestPath(start);
+      return ExtractPath(start);
+    }
+
+    /**
+     * Number of cells expanded by the last Plan.
+     */
+    size_t GetLastExpansions() const {
+      return _expanded;
+    }
+
+   private:
+    static constexpr double kInf = std::numeric_limits<double>::infinity();
+
+    struct Key {
+      double k1, k2;
+
+      bool operator<(const Key &other) const {
+        return k1 < other.k1 || (k1 == other.k1 && k2 < other.k2);
+      }
+
+      /**
+       * Whether k1 is clearly below other's, allowing for the same key summed in a
+       * different order coming out a hair apart.
+       */
+      bool Before(const Key &other) const {
+        return k1 < other.k1 - 1e-9 * std::max(1.0, std::abs(other.k1));
+      }
+    };
+
+    void Initialise(Idx_t start) {
+      const BitGrid &bits = _grid.GetBits();
+      _cols = bits.Cols();
+      _rows = bits.Rows();
+      _step = _grid.template StepCostsOf<CostT>(_dxCost, _dyCost);
+
+      size_t n = bits.Size();
+      _g.assign(n, kInf);
+      _rhs.assign(n, kInf);
+      _open.Resize(n);
+      _km = 0;
+      _last = start;
+      _snapshot = bits;
+      _initialised = true;
+
+      if (InGrid(_goal)) {
+        _rhs[Id(_goal)] = 0;
+        _open.Push(Id(_goal), CalculateKey(Id(_goal)));
+      }
+    }
+
+    // Each toggled cell changes the cost of every move into or out of it
+    void UpdateChangedCells() {
+      BitGrid previous = _snapshot;
+      _snapshot = _grid.GetBits();
+      for (int y = 0; y < _rows; y++) {
+        const BitGrid::word_t *now = _snapshot.Row(y), *before = previous.Row(y);
+        for (int w = 0; w < _snapshot.Stride(); w++) {
+          for (BitGrid::word_t changed = now[w] ^ before[w]; changed != 0; changed &= changed - 1) {
+            int x = w * BitGrid::kWordBits + std::countr_zero(changed);
+            for (int dy = -1; dy <= 1; dy++)
+              for (int dx = -1; dx <= 1; dx++)
+                if (InGrid(Idx_t{ x + dx, y + dy }))
+                  UpdateVertex((y + dy) * _cols + x + dx);
+          }
+        }
+      }
+    }
+
+    Key CalculateKey(int id) const {
+      double best = std::min(_g[id], _rhs[id]);
+      return Key{ best + _step.Octile(_last, IdxOf(id)) + _km, best };
+    }
+
+    void UpdateVertex(int id) {
+      if (id != Id(_goal)) {
+        double rhs = kInf;
+        if (!Occupied(id)) {
+          ForEachNeighbour(id, [&](int neighbour, double cost) {
+            rhs = std::min(rhs, cost + _g[neighbour]);
+          });
+        }
+        _rhs[id] = rhs;
+      }
+
+      if (_g[id] != _rhs[id])
+        _open.Push(id, CalculateKey(id));
+      else if (_open.Contains(id))
+        _open.Remove(id);
+    }
+
+    void ComputeShortestPath(Idx_t start) {
+      int s = Id(start);
+      // Cells whose k1 ties with the start's are settled too, otherwise one left
+      // with a stale g could send ExtractPath the wrong way
+      while (!_open.Empty() && (!CalculateKey(s).Before(_open.TopKey()) || _rhs[s] != _g[s])) {
+        int u = _open.Top();
+        Key old = _open.TopKey(), updated = CalculateKey(u);
+        _expanded++;
+
+        if (old < updated) {
+          _open.Push(u, updated);
+        } else if (_g[u] > _rhs[u]) {
+          _g[u] = _rhs[u];
+          _open.Remove(u);
+          ForEachNeighbour(u, [&](int neighbour, double) { UpdateVertex(neighbour); });
+        } else {
+          _g[u] = kInf;
+          UpdateVertex(u);
+          ForEachNeighbour(u, [&](int neighbour, double) { UpdateVertex(neighbour); });
+        }
+      }
+    }
+
+    // Follow the cheapest move from each cell until the goal
+    path_t ExtractPath(Idx_t start) {
+      path_t path;
+      int s = Id(start);
+      if (_g[s] == kInf)
+        return path;
+
+      double cost = 0;
+      int goal = Id(_goal);
+      path.push_back({ _grid.CenterOf(start), units::unit_t<CostT>{0} });
+      for (int current = s; current != goal;) {
+        int next = -1;
+        double best = kInf, step = 0;
+        ForEachNeighbour(current, [&](int neighbour, double c) {
+          if (c + _g[neighbour] < best) {
+            best = c + _g[neighbour];
+            next = neighbour;
+            step = c;
+          }
+        });
+        // A cycle means the search is broken, don't loop forever
+        if (next < 0 || path.size() > _g.size())
+          return path_t{};
+
+        cost += step;
+        current = next;
+        path.push_back({ _grid.CenterOf(IdxOf(current)), units::unit_t<CostT>{cost} });
+      }
+      return path;
+    }
+
+    // Calls f(neighbour, cost) for every free cell one move from a free cell id
+    template<typename F>
+    void ForEachNeighbour(int id, F f) const {
+      if (Occupied(id))
+        return;
+      int x = id % _cols, y = id / _cols;
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          int nx = x + dx, ny = y + dy;
+          if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= _cols || ny >= _rows)
+            continue;
+          int neighbour = ny * _cols + nx;
+          if (!Occupied(neighbour))
+            f(neighbour, _step.Move(dx, dy));
+        }
+      }
+    }
+
+    bool Occupied(int id) const {
+      return _snapshot.Get(id % _cols, id / _cols);
+    }
+
+    bool InGrid(Idx_t idx) const {
+      return idx.x() >= 0 && idx.y() >= 0 && idx.x() < _cols && idx.y() < _rows;
+    }
+
+    int Id(Idx_t idx) const {
+      return idx.y() * _cols + idx.x();
+    }
+
+    Idx_t IdxOf(int id) const {
+      return Idx_t{ id % _cols, id / _cols };
+    }
+
+    grid_t &_grid;
+    dx_cost_t _dxCost;
+    dy_cost_t _dyCost;
+
+    Idx_t _goal{ 0, 0 };
+    bool _hasGoal = false, _initialised = false;
+
+    int _cols = 0, _rows = 0;
+    detail::StepCosts _step{ 0, 0, 0 };
+    std::vector<double> _g, _rhs;
+    detail::IndexedHeap<Key> _open;
+    double _km = 0;
+    Idx_t _last{ 0, 0 };
+    BitGrid _snapshot;
+    size_t _expanded = 0;
+  };
+}
@@ -4,6 +4,7 @@
 #include "PID.h"
 #include "behaviour/HasBehaviour.h"
 #include "behaviour/Behaviour.h"
+#include <units/acceleration.h>
 #include <units/length.h>
 #include <units/mass.h>
 
@@ -59,6 +60,8 @@ namespace wom {
 
     units::meter_t GetHeight() const;
     units::meters_per_second_t MaxSpeed() const;
+    //the fastest the carriage can speed up going up, at stall torque against gravity
+    units::meters_per_second_squared_t MaxAcceleration() const;
   
    private:
    //information that cannot be changed or edited by user
@@ -3,15 +3,24 @@
 #include <frc/Encoder.h>
 #include <units/angle.h>
 #include <units/angular_velocity.h>
+#include <units/frequency.h>
 
 #include <rev/CANSparkMax.h>
 #include <ctre/phoenix.h>
 #include <frc/DutyCycleEncoder.h>
 
+#include <atomic>
+
 #include "sim/SimEncoder.h"
 #include "Util.h"
 
 namespace wom {
+  struct EncoderSample {
+    double ticks = 0;
+    double tickVelocity = 0;   // ticks/s
+    units::second_t timestamp{0};
+  };
+
   class Encoder {
    public:
     Encoder(double encoderTicksPerRotation, double reduction) : _encoderTicksPerRotation(encoderTicksPerRotation), _reduction(reduction) {};
@@ -19,6 +28,12 @@ namespace wom {
     virtual double    GetEncoderTickVelocity() const = 0;  // ticks/s
     virtual void      ZeroEncoder();
 
+    /**
+     * Ask the device to report its position at least this often, for readers
+     * faster than the robot loop. Encoders read directly have nothing to set.
+     */
+    virtual void SetUpdateRate(units::hertz_t rate) {}
+
     void SetEncoderPosition(units::radian_t position);
     void SetEncoderOffset(units::radian_t offset);
 
@@ -30,11 +45,37 @@ namespace wom {
     units::radian_t GetEncoderPosition();
     units::radians_per_second_t GetEncoderAngularVelocity();   // rad/s
 
+    /**
+     * Read the position from the hardware, bypassing any sample. Used by consumers
+     * that run faster than the robot loop, such as the odometry thread.
+     */
+    units::radian_t ReadEncoderPosition() const;
+
+    /**
+     * Read the hardware once and hold the reading. From then on position and
+     * velocity come from the latest sample instead of the hardware. Usually
+     * called by a SensorFrame at the top of the robot loop.
+     */
+    void Sample(units::second_t timestamp);
+    /**
+     * Go back to reading the hardware on every call.
+     */
+    void ClearSample();
+    bool IsSampled() const;
+    EncoderSample GetSample() const;
+
     virtual std::shared_ptr<sim::SimCapableEncoder> MakeSimEncoder() = 0;
    private:
+    double GetSampledRawTicks() const;
+    double GetSampledTickVelocity() const;
+
+    SeqLocked<EncoderSample> _sample;
+    std::atomic<bool> _sampled{false};
+
     double _encoderTicksPerRotation;
     double _reduction = 1.0;
-    double _offset = 0;
+    // Set from the robot loop, read by the odometry thread through ReadEncoderPosition
+    std::atomic<double> _offset{0};
   };
 
   class DigitalEncoder : public Encoder {
@@ -75,6 +116,7 @@ namespace wom {
 
     double GetEncoderRawTicks() const override;
     double GetEncoderTickVelocity() const override;
+    void SetUpdateRate(units::hertz_t rate) override;
 
     std::shared_ptr<sim::SimCapableEncoder> MakeSimEncoder() override;
    private:
@@ -87,6 +129,7 @@ namespace wom {
    
     double GetEncoderRawTicks() const override;
     double GetEncoderTickVelocity() const override;
+    void SetUpdateRate(units::hertz_t rate) override;
 
     std::shared_ptr<sim::SimCapableEncoder> MakeSimEncoder() override;
    private: 
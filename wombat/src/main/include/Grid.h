@@ -1,5 +1,7 @@
 #pragma once
 
+#include "BitGrid.h"
+
 #include <Eigen/Core>
 
 #include <units/base.h>
@@ -8,36 +10,216 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
-#include <unordered_set>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
 
 namespace wom {
   namespace detail {
-    // From https://wjngkoh.wordpress.com/2015/03/04/c-hash-function-for-eigen-matrix-and-vector/
-    template<typename T>
-    struct matrix_hash {
-      std::size_t operator()(T const& matrix) const {
-        size_t seed = 0;
-        for (size_t i = 0; i < (size_t)matrix.size(); ++i) {
-          auto elem = *(matrix.data() + i);
-          seed ^= std::hash<typename T::Scalar>()(elem) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-      }
-    };
-
     template<typename I, typename O>
     O remap(I x, I in_min, I in_max, O out_min, O out_max) {
       return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
     }
-  }
 
+    /**
+     * Exact 1D squared distance transform (Felzenszwalb & Huttenlocher): for each
+     * p, d[p] = min over q of (p - q)^2 + f[q], and arg[p] is the q that gave it.
+     * v and z are scratch of at least n and n + 1.
+     */
+    inline void DistanceTransform1D(const double *f, int n, double *d, int *arg, int *v, double *z) {
+      int k = 0;
+      v[0] = 0;
+      z[0] = -std::numeric_limits<double>::infinity();
+      z[1] = std::numeric_limits<double>::infinity();
+      for (int q = 1; q < n; q++) {
+        double s;
+        while ((s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]))) <= z[k])
+          k--;
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<double>::infinity();
+      }
+
+      k = 0;
+      for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q)
+          k++;
+        d[q] = (double)(q - v[k]) * (q - v[k]) + f[v[k]];
+        arg[q] = v[k];
+      }
+    }
+
+    /**
+     * For every cell, the id (y * cols + x) of the nearest cell whose bit equals
+     * value, and the Euclidean distance to it in cells. Cells with no such cell
+     * get -1 and infinity. Linear in the number of cells.
+     */
+    inline void NearestCells(const BitGrid &grid, bool value, std::vector<int> &nearest, std::vector<float> &distance) {
+      // Stands in for infinity, so the parabola intersections stay finite
+      constexpr double kFar = 1e20;
+
+      int cols = grid.Cols(), rows = grid.Rows(), n = std::max(cols, rows);
+      std::vector<double> colDist((size_t)cols * rows);
+      std::vector<int> colArg((size_t)cols * rows);
+      std::vector<double> f(n), d(n), z(n + 1);
+      std::vector<int> arg(n), v(n);
+      nearest.assign((size_t)cols * rows, -1);
+      distance.assign((size_t)cols * rows, std::numeric_limits<float>::infinity());
+      if (cols == 0 || rows == 0)
+        return;
+
+      // Down each column, the nearest matching row
+      for (int x = 0; x < cols; x++) {
+        for (int y = 0; y < rows; y++)
+          f[y] = grid.Get(x, y) == value ? 0 : kFar;
+        DistanceTransform1D(f.data(), rows, d.data(), arg.data(), v.data(), z.data());
+        for (int y = 0; y < rows; y++) {
+          colDist[(size_t)y * cols + x] = d[y];
+          colArg[(size_t)y * cols + x] = arg[y];
+        }
+      }
+
+      // Along each row, the nearest of those
+      for (int y = 0; y < rows; y++) {
+        DistanceTransform1D(colDist.data() + (size_t)y * cols, cols, d.data(), arg.data(), v.data(), z.data());
+        for (int x = 0; x < cols; x++) {
+          if (d[x] >= kFar)
+            continue;
+          int fx = arg[x], fy = colArg[(size_t)y * cols + fx];
+          nearest[(size_t)y * cols + x] = fy * cols + fx;
+          distance[(size_t)y * cols + x] = (float)std::sqrt(d[x]);
+        }
+      }
+    }
+
+    // Cost of moving one cell along x, along y, and diagonally, in a search's cost unit
+    struct StepCosts {
+      double x, y, diagonal;
+
+      double Move(int dx, int dy) const {
+        return dx == 0 ? y : dy == 0 ? x : diagonal;
+      }
+
+      // Octile distance, the exact cost of the best path through an empty grid
+      double Octile(Eigen::Vector2i from, Eigen::Vector2i to) const {
+        int ax = std::abs(to.x() - from.x()), ay = std::abs(to.y() - from.y());
+        int diagonal = std::min(ax, ay);
+        return diagonal * this->diagonal + (ax - diagonal) * this->x + (ay - diagonal) * this->y;
+      }
+    };
+
+    /**
+     * A binary min-heap of ids in [0, n) that tracks where each id is, so the key
+     * of an id already in the heap can be changed in O(log n). Ids are removed
+     * from the position table as they leave, so it is ready for the next search
+     * without clearing.
+     */
+    template<typename Key>
+    class IndexedHeap {
+     public:
+      void Resize(size_t n) {
+        _heap.clear();
+        _pos.assign(n, -1);
+      }
+
+      bool Empty() const { return _heap.empty(); }
+      size_t Size() const { return _heap.size(); }
+      bool Contains(int id) const { return _pos[id] >= 0; }
+
+      int Top() const { return _heap.front().second; }
+      const Key &TopKey() const { return _heap.front().first; }
 
-  template<typename CostT>
-  struct AStarNode {
-    Eigen::Vector2i position;
-    std::shared_ptr<AStarNode> parent;
-    units::unit_t<CostT> gScore;
-    units::unit_t<CostT> fScore;
+      // Insert id, or change its key if it's already in the heap
+      void Push(int id, Key key) {
+        if (Contains(id)) {
+          int i = _pos[id];
+          bool up = key < _heap[i].first;
+          _heap[i].first = key;
+          if (up) SiftUp(i); else SiftDown(i);
+        } else {
+          _heap.emplace_back(key, id);
+          _pos[id] = (int)_heap.size() - 1;
+          SiftUp((int)_heap.size() - 1);
+        }
+      }
+
+      int Pop() {
+        int id = Top();
+        Remove(id);
+        return id;
+      }
+
+      void Remove(int id) {
+        int i = _pos[id];
+        _pos[id] = -1;
+        if (i != (int)_heap.size() - 1) {
+          _heap[i] = _heap.back();
+          _pos[_heap[i].second] = i;
+          _heap.pop_back();
+          SiftDown(i);
+          SiftUp(i);
+        } else {
+          _heap.pop_back();
+        }
+      }
+
+      void Clear() {
+        for (auto &entry : _heap)
+          _pos[entry.second] = -1;
+        _heap.clear();
+      }
+
+     private:
+      void Swap(int a, int b) {
+        std::swap(_heap[a], _heap[b]);
+        _pos[_heap[a].second] = a;
+        _pos[_heap[b].second] = b;
+      }
+
+      void SiftUp(int i) {
+        while (i > 0) {
+          int parent = (i - 1) / 2;
+          if (!(_heap[i].first < _heap[parent].first))
+            break;
+          Swap(i, parent);
+          i = parent;
+        }
+      }
+
+      void SiftDown(int i) {
+        int n = (int)_heap.size();
+        while (true) {
+          int smallest = i, l = 2 * i + 1, r = 2 * i + 2;
+          if (l < n && _heap[l].first < _heap[smallest].first) smallest = l;
+          if (r < n && _heap[r].first < _heap[smallest].first) smallest = r;
+          if (smallest == i)
+            break;
+          Swap(i, smallest);
+          i = smallest;
+        }
+      }
+
+      std::vector<std::pair<Key, int>> _heap;
+      std::vector<int> _pos;
+    };
+  }
+
+  /**
+   * How a DiscretisedOccupancyGrid search explores the grid.
+   */
+  enum class GridSearch {
+    kAStar,
+    /**
+     * Jump point search: A* that only stops at cells where the path may need to
+     * turn to get around an obstacle, skipping the runs of cells in between, so it
+     * expands far fewer cells on open grids. Finds paths of the same cost as
+     * kAStar. Every move must cost the same wherever it is, so searches with a
+     * clearance cost fall back to kAStar.
+     */
+    kJumpPoint
   };
 
   template<typename T_X, typename T_Y>
@@ -59,167 +241,247 @@ namespace wom {
     };
 
     DiscretisedOccupancyGrid(X_t xmin, X_t xmax, Y_t ymin, Y_t ymax, size_t ux, size_t uy)
-      : _xmin(xmin), _xmax(xmax), _ymin(ymin), _ymax(ymax)
-    {
-      _grid.resize(uy, ux);
-      Reset();
-    }
+      : _xmin(xmin), _xmax(xmax), _ymin(ymin), _ymax(ymax), _grid((int)ux, (int)uy) { }
 
     DiscretisedOccupancyGrid(X_t xmin, X_t xmax, Y_t ymin, Y_t ymax, Eigen::MatrixXi matrix)
       : _xmin(xmin), _xmax(xmax), _ymin(ymin), _ymax(ymax), _grid(matrix) { }
 
     void Reset() {
-      _grid.fill(0);
+      _grid.Fill(false);
+      Changed();
     }
 
     void Fill(bool value) {
-      _grid.fill(value ? 1 : 0);
+      _grid.Fill(value);
+      Changed();
     }
 
     DiscretisedOccupancyGrid FillF(std::function<bool(X_t, Y_t)> f) {
-      for (int x = 0; x < _grid.cols(); x++) {
-        for (int y = 0; y < _grid.rows(); y++) {
-          ContinuousIdxT ci = CenterOf(Eigen::Vector2i{x, y});
-          _grid(y, x) = f(ci.x, ci.y);
-        }
+      std::vector<X_t> xs = ColumnCenters();
+      for (int y = 0; y < _grid.Rows(); y++) {
+        Y_t cy = CenterOf(Idx_t{ 0, y }).y;
+        for (int x = 0; x < _grid.Cols(); x++)
+          _grid.Set(x, y, f(xs[x], cy));
       }
+      Changed();
+      return *this;
+    }
+
+    /**
+     * As FillF, but f is called once per row with the centre of every column (in
+     * X_t's units) and returns whether each is occupied, so f can vectorise its
+     * maths with Eigen.
+     */
+    DiscretisedOccupancyGrid FillRowsF(std::function<Eigen::Array<bool, Eigen::Dynamic, 1>(Y_t, const Eigen::ArrayXd &)> f) {
+      std::vector<X_t> centers = ColumnCenters();
+      Eigen::ArrayXd xs(_grid.Cols());
+      for (int x = 0; x < _grid.Cols(); x++)
+        xs(x) = centers[x].value();
+
+      for (int y = 0; y < _grid.Rows(); y++) {
+        Eigen::Array<bool, Eigen::Dynamic, 1> row = f(CenterOf(Idx_t{ 0, y }).y, xs);
+        if (row.size() != _grid.Cols())
+          throw std::invalid_argument("Rows / Cols Mismatch!");
+        _grid.SetRow(y, row.data());
+      }
+      Changed();
       return *this;
     }
 
     void Load(const Eigen::MatrixXi &matrix) {
-      if (matrix.cols() != _grid.cols() || matrix.rows() != _grid.rows()) {
+      if (matrix.cols() != _grid.Cols() || matrix.rows() != _grid.Rows()) {
         throw std::invalid_argument("Rows / Cols Mismatch!");
       } else {
-        _grid = matrix;
+        _grid = BitGrid(matrix);
+        Changed();
       }
     }
 
     bool Get(Idx_t idx) {
       if (idx.y() < 0 || idx.x() < 0)
         return true;
-      if (idx.y() >= _grid.rows() || idx.x() >= _grid.cols())
+      if (idx.y() >= _grid.Rows() || idx.x() >= _grid.Cols())
         return true;
       
-      return _grid(idx.y(), idx.x());
+      return _grid.Get(idx.x(), idx.y());
     }
 
     void Set(Idx_t idx, bool occupied) {
-      _grid(idx.y(), idx.x()) = occupied;
+      _grid.Set(idx.x(), idx.y(), occupied);
+      Changed();
     }
 
-    Idx_t Discretise(ContinuousIdxT i) {
+    /**
+     * Mark every cell occupied in either grid as occupied. The grids must be the
+     * same size.
+     */
+    void Union(const DiscretisedOccupancyGrid &other) {
+      _grid |= other._grid;
+      Changed();
+    }
+
+    /**
+     * Grow obstacles by rx cells along x and ry cells along y, e.g. to inflate them
+     * by a robot's footprint so the robot can be planned as a point.
+     */
+    void Dilate(int rx, int ry) {
+      _grid.Dilate(rx, ry);
+      Changed();
+    }
+
+    const BitGrid &GetBits() const {
+      return _grid;
+    }
+
+    /**
+     * Goes up by one every time the grid is changed through this class, so users
+     * can tell whether anything they derived from it is out of date.
+     */
+    uint64_t GetVersion() const {
+      return _version;
+    }
+
+    Idx_t Discretise(ContinuousIdxT i) const {
       return Eigen::Vector2i{
-        (int)detail::remap(i.x, _xmin, _xmax, 0.0, (double)_grid.cols()),
-        (int)detail::remap(i.y, _ymin, _ymax, 0.0, (double)_grid.rows())
+        (int)detail::remap(i.x, _xmin, _xmax, 0.0, (double)_grid.Cols()),
+        (int)detail::remap(i.y, _ymin, _ymax, 0.0, (double)_grid.Rows())
       };
     }
 
-    ContinuousIdxT CenterOf(Idx_t idx) {
+    ContinuousIdxT CenterOf(Idx_t idx) const {
       return ContinuousIdxT {
-        (detail::remap((double)idx.x(), 0.0, (double)_grid.cols(), _xmin, _xmax) + detail::remap((double)idx.x() + 1, 0.0, (double)_grid.cols(), _xmin, _xmax)) / 2.0,
-        (detail::remap((double)idx.y(), 0.0, (double)_grid.rows(), _ymin, _ymax) + detail::remap((double)idx.y() + 1, 0.0, (double)_grid.rows(), _ymin, _ymax)) / 2.0
+        (detail::remap((double)idx.x(), 0.0, (double)_grid.Cols(), _xmin, _xmax) + detail::remap((double)idx.x() + 1, 0.0, (double)_grid.Cols(), _xmin, _xmax)) / 2.0,
+        (detail::remap((double)idx.y(), 0.0, (double)_grid.Rows(), _ymin, _ymax) + detail::remap((double)idx.y() + 1, 0.0, (double)_grid.Rows(), _ymin, _ymax)) / 2.0
       };
     }
 
+    /**
+     * Whether the straight line between the centres of a and b only passes through
+     * free cells. Where it passes exactly through the corner of a cell, both cells
+     * beside the corner must be free.
+     */
+    bool LineOfSight(Idx_t a, Idx_t b) {
+      if (Get(a) || Get(b))
+        return false;
+
+      int nx = std::abs(b.x() - a.x()), ny = std::abs(b.y() - a.y());
+      int sx = b.x() > a.x() ? 1 : -1, sy = b.y() > a.y() ? 1 : -1;
+      Idx_t cell = a;
+      for (int ix = 0, iy = 0; ix < nx || iy < ny;) {
+        // Which cell edge the line crosses next, compared without division
+        long decision = (long)(1 + 2 * ix) * ny - (long)(1 + 2 * iy) * nx;
+        if (decision == 0) {
+          if (Get(cell + Idx_t{ sx, 0 }) || Get(cell + Idx_t{ 0, sy }))
+            return false;
+          cell += Idx_t{ sx, sy };
+          ix++;
+          iy++;
+        } else if (decision < 0) {
+          cell.x() += sx;
+          ix++;
+        } else {
+          cell.y() += sy;
+          iy++;
+        }
+        if (Get(cell))
+          return false;
+      }
+      return true;
+    }
+
     /* SEARCH */
     template<typename From, typename To>
     using converting_unit = typename units::unit_t<units::compound_unit<To, units::inverse<From>>>;
 
-    Idx_t GetClosestValidNode(Idx_t start) {
-      std::unordered_set<Idx_t, detail::matrix_hash<Idx_t>> visited;
-      visited.insert(start);
-
-      std::deque<Idx_t> q;
-      q.push_front(start);
-
-      while (!q.empty()) {
-        Idx_t current = q.back();
-        q.pop_back();
-
-        if (!Get(current)) {
-          return current;
-        } else {
-          for (int dx = -1; dx <= 1; dx++) {
-            for (int dy = -1; dy <= 1; dy++) {
-              Idx_t newPos = current + Idx_t{ dx, dy };
-              if (!visited.contains(newPos)) {
-                visited.insert(newPos);
-                q.push_front(newPos);
-              }
-            }
-          }
-        }
-      }
+    /**
+     * The free cell nearest to idx (by straight-line distance in cells), or idx
+     * clamped onto the grid if every cell is occupied. idx may be off the grid.
+     * O(1) once the distance fields are built, which happens on the first call
+     * after the grid changes.
+     */
+    Idx_t GetClosestValidNode(Idx_t idx) {
+      const DistanceFields &fields = GetFields();
+      if (_grid.Size() == 0)
+        return idx;
+
+      Idx_t clamped{ std::clamp(idx.x(), 0, _grid.Cols() - 1), std::clamp(idx.y(), 0, _grid.Rows() - 1) };
+      int nearest = fields.nearestFree[Id(clamped)];
+      return nearest < 0 ? clamped : IdxOf(nearest);
+    }
 
-      return start;
+    /**
+     * Distance from the centre of idx to the centre of the nearest occupied cell,
+     * in cells. The cells just outside the grid count as occupied, so a free cell
+     * always has a clearance of at least 1. Occupied and off-grid cells have 0.
+     */
+    double GetClearance(Idx_t idx) {
+      if (Get(idx))
+        return 0;
+      return GetFields().clearance[Id(idx)];
     }
 
     // Will return a path from the closest non-obstacle nodes at the start and end.
     template<typename CostT>
-    std::deque<GridPathNode<CostT>> AStar(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
-      return AStarStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost);
+    std::deque<GridPathNode<CostT>> AStar(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, units::unit_t<CostT> clearanceCost = units::unit_t<CostT>{0}, GridSearch search = GridSearch::kAStar) {
+      return AStarStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost, clearanceCost, search);
     }
 
-    // Will return a blank path if either the start or the end are in obstacles.
+    /**
+     * Will return a blank path if either the start or the end are in obstacles.
+     *
+     * If clearanceCost is given, entering a cell also costs clearanceCost divided
+     * by the cell's clearance (see GetClearance), which keeps paths away from
+     * obstacles where that's cheap to do.
+     *
+     * Either way, the path steps one cell at a time.
+     */
     template<typename CostT>
-    std::deque<GridPathNode<CostT>> AStarStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
-      using cost_t = units::unit_t<CostT>;
-      using node_t = std::shared_ptr<AStarNode<CostT>>;
-
-      std::vector<node_t> allNodes;
-      allNodes.push_back(std::make_shared<AStarNode<CostT>>(
-        start, nullptr, cost_t{0}, Cost<CostT>(start, end, dxCost, dyCost)
-      ));
-
-      std::vector<node_t> openSet;
-      openSet.push_back(allNodes[0]);
-
-      while (!openSet.empty()) {
-        auto currentIt = std::min_element(openSet.cbegin(), openSet.cend(), [](auto a, auto b) { return a->fScore < b->fScore; });
-        node_t current = *currentIt;
-        openSet.erase(currentIt);
-        if (current->position == end) {
-          std::deque<GridPathNode<CostT>> queue;
-          queue.push_front(GridPathNode<CostT> {
-            CenterOf(current->position),
-            current->gScore
-          });
-
-          while (current->parent) {
-            queue.push_front(GridPathNode<CostT> {
-              CenterOf(current->parent->position),
-              current->parent->gScore
-            });
-            current = current->parent;
-          }
+    std::deque<GridPathNode<CostT>> AStarStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, units::unit_t<CostT> clearanceCost = units::unit_t<CostT>{0}, GridSearch search = GridSearch::kAStar) {
+      if (Get(start) || Get(end))
+        return std::deque<GridPathNode<CostT>>{};
+
+      detail::StepCosts step = StepCostsOf<CostT>(dxCost, dyCost);
+      double penalty = clearanceCost.value();
+      if (search == GridSearch::kJumpPoint && penalty == 0)
+        return JumpPointSearch<CostT>(start, end, step);
+
+      const std::vector<float> *clearance = penalty > 0 ? &GetFields().clearance : nullptr;
+      int goal = Id(end);
+      int cols = _grid.Cols(), rows = _grid.Rows();
+
+      SearchState &s = BeginSearch();
+      int startId = Id(start);
+      Visit(startId, 0, -1);
+      s.open.Push(startId, OpenKey{ step.Octile(start, end), 0 });
+
+      while (!s.open.Empty()) {
+        int current = s.open.Pop();
+        if (current == goal) {
+          s.open.Clear();
+          return Path<CostT>(goal);
+        }
 
-          return queue;
-        } else {
+        s.closed[current] = s.generation;
+        s.expanded++;
+
+        int cx = current % cols, cy = current / cols;
+        double g = s.g[current];
+        for (int dy = -1; dy <= 1; dy++) {
           for (int dx = -1; dx <= 1; dx++) {
-            for (int dy = -1; dy <= 1; dy++) {
-              Idx_t newPos = current->position + Idx_t{ dx, dy };
-              // Find neighbour, or create if not exists.
-              auto neighbourIt = std::find_if(allNodes.cbegin(), allNodes.cend(), [newPos](auto node) { return node->position == newPos; });
-              if (neighbourIt == allNodes.cend()) {
-                allNodes.push_back(std::make_shared<AStarNode<CostT>>(
-                  newPos, nullptr, cost_t{1e9}, cost_t{1e9}
-                ));
-                neighbourIt = allNodes.cend() - 1;
-              }
-              node_t neighbour = *neighbourIt;
-
-              if (newPos != current->position && !Get(newPos)) {
-                cost_t tentative = current->gScore + Cost<CostT>(current->position, newPos, dxCost, dyCost);
-
-                if (tentative < neighbour->gScore) {
-                  neighbour->parent = current;
-                  neighbour->gScore = tentative;
-                  neighbour->fScore = tentative + Cost<CostT>(newPos, end, dxCost, dyCost);
-                  if (std::find(openSet.cbegin(), openSet.cend(), neighbour) == openSet.cend()) {
-                    openSet.push_back(neighbour);
-                  }
-                }
-              }
+            int nx = cx + dx, ny = cy + dy;
+            if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= cols || ny >= rows || _grid.Get(nx, ny))
+              continue;
+
+            int neighbour = ny * cols + nx;
+            if (s.closed[neighbour] == s.generation)
+              continue;
+
+            double tentative = g + step.Move(dx, dy);
+            if (clearance)
+              tentative += penalty / (*clearance)[neighbour];
+            if (s.visited[neighbour] != s.generation || tentative < s.g[neighbour]) {
+              Visit(neighbour, tentative, current);
+              s.open.Push(neighbour, OpenKey{ tentative + step.Octile(Idx_t{ nx, ny }, end), tentative });
             }
           }
         }
@@ -228,10 +490,18 @@ namespace wom {
       return std::deque<GridPathNode<CostT>>{};
     }
 
+    /**
+     * Number of cells expanded by the last search. For jump point search, only
+     * the jump points, not the cells jumped over.
+     */
+    size_t GetLastExpansions() const {
+      return _search.expanded;
+    }
+
     template<typename CostT>
     units::unit_t<CostT> Cost(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
-      auto x_per_grid = (_xmax - _xmin) / (float)_grid.cols();
-      auto y_per_grid = (_ymax - _ymin) / (float)_grid.rows();
+      auto x_per_grid = (_xmax - _xmin) / (float)_grid.Cols();
+      auto y_per_grid = (_ymax - _ymin) / (float)_grid.Rows();
 
       Idx_t rel = end - start;
       auto xcost = rel.x() * x_per_grid * dxCost;
@@ -242,6 +512,264 @@ namespace wom {
 
     X_t _xmin, _xmax;
     Y_t _ymin, _ymax;
-    Eigen::MatrixXi _grid;
+    BitGrid _grid;
+
+    /**
+     * The cost of a move of one cell in each direction, in CostT's units.
+     */
+    template<typename CostT>
+    detail::StepCosts StepCostsOf(converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) const {
+      double x = std::abs(units::unit_t<CostT>{(_xmax - _xmin) / (double)_grid.Cols() * dxCost}.value());
+      double y = std::abs(units::unit_t<CostT>{(_ymax - _ymin) / (double)_grid.Rows() * dyCost}.value());
+      return detail::StepCosts{ x, y, std::sqrt(x * x + y * y) };
+    }
+
+   private:
+    // Ordered by f, breaking ties towards the larger g (closer to the goal)
+    struct OpenKey {
+      double f, g;
+
+      bool operator<(const OpenKey &other) const {
+        return f < other.f || (f == other.f && g > other.g);
+      }
+    };
+
+    /**
+     * Scratch space for searches, indexed by cell id. Cells are only valid for
+     * the search whose generation they're stamped with, so nothing is cleared
+     * between searches.
+     */
+    struct SearchState {
+      std::vector<double> g;
+      std::vector<int> parent;
+      std::vector<uint32_t> visited;
+      std::vector<uint32_t> closed;
+      detail::IndexedHeap<OpenKey> open;
+      uint32_t generation = 0;
+      size_t expanded = 0;
+    };
+
+    /**
+     * Per-cell lookups derived from the occupancy, rebuilt lazily after any
+     * change made through this class.
+     */
+    struct DistanceFields {
+      std::vector<int> nearestFree;
+      std::vector<float> clearance;
+      bool dirty = true;
+    };
+
+    void Changed() {
+      _fields.dirty = true;
+      _version++;
+    }
+
+    const DistanceFields &GetFields() {
+      if (_fields.dirty) {
+        std::vector<int> nearestOccupied;
+        detail::NearestCells(_grid, false, _fields.nearestFree, _fields.clearance);
+        detail::NearestCells(_grid, true, nearestOccupied, _fields.clearance);
+
+        int cols = _grid.Cols(), rows = _grid.Rows();
+        for (int y = 0; y < rows; y++) {
+          for (int x = 0; x < cols; x++) {
+            float &c = _fields.clearance[(size_t)y * cols + x];
+            c = std::min(c, (float)std::min({ x + 1, y + 1, cols - x, rows - y }));
+          }
+        }
+        _fields.dirty = false;
+      }
+      return _fields;
+    }
+
+    std::vector<X_t> ColumnCenters() {
+      std::vector<X_t> xs;
+      xs.reserve(_grid.Cols());
+      for (int x = 0; x < _grid.Cols(); x++)
+        xs.push_back(CenterOf(Idx_t{ x, 0 }).x);
+      return xs;
+    }
+
+    int Id(Idx_t idx) const {
+      return idx.y() * _grid.Cols() + idx.x();
+    }
+
+    Idx_t IdxOf(int id) const {
+      return Idx_t{ id % _grid.Cols(), id / _grid.Cols() };
+    }
+
+    SearchState &BeginSearch() {
+      size_t n = _grid.Size();
+      if (_search.g.size() != n) {
+        _search.g.assign(n, 0);
+        _search.parent.assign(n, -1);
+        _search.visited.assign(n, 0);
+        _search.closed.assign(n, 0);
+        _search.open.Resize(n);
+        _search.generation = 0;
+      }
+      if (++_search.generation == 0) {
+        // Wrapped, forget every stamp
+        std::fill(_search.visited.begin(), _search.visited.end(), 0);
+        std::fill(_search.closed.begin(), _search.closed.end(), 0);
+        _search.generation = 1;
+      }
+      _search.expanded = 0;
+      return _search;
+    }
+
+    void Visit(int id, double g, int parent) {
+      _search.g[id] = g;
+      _search.parent[id] = parent;
+      _search.visited[id] = _search.generation;
+    }
+
+    bool Blocked(int x, int y) const {
+      return x < 0 || y < 0 || x >= _grid.Cols() || y >= _grid.Rows() || _grid.Get(x, y);
+    }
+
+    /**
+     * Step from (x, y) in direction (dx, dy) until reaching the goal or a cell with
+     * a forced neighbour, a cell only reached best through this one. Returns its
+     * id, or -1 on hitting an obstacle or the edge first. Diagonal jumps stop where
+     * a straight jump from them would find something.
+     */
+    int Jump(int x, int y, int dx, int dy, int goal) const {
+      int cols = _grid.Cols();
+      while (true) {
+        x += dx;
+        y += dy;
+        if (Blocked(x, y))
+          return -1;
+        int id = y * cols + x;
+        if (id == goal)
+          return id;
+
+        if (dx != 0 && dy != 0) {
+          if ((Blocked(x - dx, y) && !Blocked(x - dx, y + dy)) || (Blocked(x, y - dy) && !Blocked(x + dx, y - dy)))
+            return id;
+          if (Jump(x, y, dx, 0, goal) >= 0 || Jump(x, y, 0, dy, goal) >= 0)
+            return id;
+        } else if (dx != 0) {
+          if ((Blocked(x, y + 1) && !Blocked(x + dx, y + 1)) || (Blocked(x, y - 1) && !Blocked(x + dx, y - 1)))
+            return id;
+        } else {
+          if ((Blocked(x + 1, y) && !Blocked(x + 1, y + dy)) || (Blocked(x - 1, y) && !Blocked(x - 1, y + dy)))
+            return id;
+        }
+      }
+    }
+
+    /**
+     * A* over jump points (Harabor & Grastien), with the same moves as AStarStrict,
+     * including cutting diagonally between two obstacles. Expects start and end
+     * to be free.
+     */
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> JumpPointSearch(Idx_t start, Idx_t end, const detail::StepCosts &step) {
+      int goal = Id(end);
+      int cols = _grid.Cols();
+
+      SearchState &s = BeginSearch();
+      int startId = Id(start);
+      Visit(startId, 0, -1);
+      s.open.Push(startId, OpenKey{ step.Octile(start, end), 0 });
+
+      int directions[8][2];
+      while (!s.open.Empty()) {
+        int current = s.open.Pop();
+        if (current == goal) {
+          s.open.Clear();
+          return JumpPath<CostT>(goal, step);
+        }
+
+        s.closed[current] = s.generation;
+        s.expanded++;
+
+        int cx = current % cols, cy = current / cols;
+        int n = 0;
+        int parent = s.parent[current];
+        if (parent < 0) {
+          for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+              if (dx != 0 || dy != 0) {
+                directions[n][0] = dx;
+                directions[n++][1] = dy;
+              }
+        } else {
+          // Only the neighbours that can't be reached as well without this cell
+          int px = parent % cols, py = parent / cols;
+          int dx = (cx > px) - (cx < px), dy = (cy > py) - (cy < py);
+          auto add = [&](int ax, int ay) { directions[n][0] = ax; directions[n++][1] = ay; };
+          if (dx != 0 && dy != 0) {
+            add(dx, dy);
+            add(dx, 0);
+            add(0, dy);
+            if (Blocked(cx - dx, cy)) add(-dx, dy);
+            if (Blocked(cx, cy - dy)) add(dx, -dy);
+          } else if (dx != 0) {
+            add(dx, 0);
+            if (Blocked(cx, cy + 1)) add(dx, 1);
+            if (Blocked(cx, cy - 1)) add(dx, -1);
+          } else {
+            add(0, dy);
+            if (Blocked(cx + 1, cy)) add(1, dy);
+            if (Blocked(cx - 1, cy)) add(-1, dy);
+          }
+        }
+
+        double g = s.g[current];
+        for (int i = 0; i < n; i++) {
+          int next = Jump(cx, cy, directions[i][0], directions[i][1], goal);
+          if (next < 0 || s.closed[next] == s.generation)
+            continue;
+
+          // Jumps are straight, so the octile distance is their exact cost
+          Idx_t cell = IdxOf(next);
+          double tentative = g + step.Octile(Idx_t{ cx, cy }, cell);
+          if (s.visited[next] != s.generation || tentative < s.g[next]) {
+            Visit(next, tentative, current);
+            s.open.Push(next, OpenKey{ tentative + step.Octile(cell, end), tentative });
+          }
+        }
+      }
+
+      return std::deque<GridPathNode<CostT>>{};
+    }
+
+    // The path through the jump points to goal, filled in one cell at a time
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> JumpPath(int goal, const detail::StepCosts &step) {
+      std::vector<Idx_t> points;
+      for (int id = goal; id >= 0; id = _search.parent[id])
+        points.push_back(IdxOf(id));
+      std::reverse(points.begin(), points.end());
+
+      std::deque<GridPathNode<CostT>> path;
+      Idx_t cell = points.front();
+      double cost = 0;
+      path.push_back(GridPathNode<CostT>{ CenterOf(cell), units::unit_t<CostT>{0} });
+      for (size_t i = 1; i < points.size(); i++) {
+        Idx_t move{ (points[i].x() > cell.x()) - (points[i].x() < cell.x()), (points[i].y() > cell.y()) - (points[i].y() < cell.y()) };
+        while (cell != points[i]) {
+          cell += move;
+          cost += step.Move(move.x(), move.y());
+          path.push_back(GridPathNode<CostT>{ CenterOf(cell), units::unit_t<CostT>{cost} });
+        }
+      }
+      return path;
+    }
+
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> Path(int goal) {
+      std::deque<GridPathNode<CostT>> path;
+      for (int id = goal; id >= 0; id = _search.parent[id])
+        path.push_front(GridPathNode<CostT>{ CenterOf(IdxOf(id)), units::unit_t<CostT>{_search.g[id]} });
+      return path;
+    }
+
+    SearchState _search;
+    DistanceFields _fields;
+    uint64_t _version = 0;
   };
 }
\ No newline at end of file
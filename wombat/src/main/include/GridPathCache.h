@@ -0,0 +1,292 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace wom {
+  /**
+   * Shortest paths between every pair of a small set of preset cells on a
+   * DiscretisedOccupancyGrid, e.g. the scoring positions of a mechanism, so
+   * moving between presets needs no planning at all.
+   *
+   * Paths are planned with AStar (so presets inside obstacles snap to the
+   * nearest free cell) on a background thread, against a copy of the grid. They
+   * are stored as a start cell and one 4 bit move per step. When the grid or
+   * the presets change, the table is dropped and rebuilt, and lookups return
+   * nothing until it's ready. Lookups never block.
+   */
+  template<typename T_X, typename T_Y, typename CostT>
+  class GridPathCache {
+   public:
+    using grid_t = DiscretisedOccupancyGrid<T_X, T_Y>;
+    using Idx_t = typename grid_t::Idx_t;
+    using path_t = std::deque<typename grid_t::template GridPathNode<CostT>>;
+    using dx_cost_t = typename grid_t::template converting_unit<T_X, CostT>;
+    using dy_cost_t = typename grid_t::template converting_unit<T_Y, CostT>;
+
+    GridPathCache(dx_cost_t dxCost, dy_cost_t dyCost)
+      : _dxCost(dxCost), _dyCost(dyCost), _worker([this]() { Run(); }) { }
+
+    ~GridPathCache() {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+      }
+      _cv.notify_all();
+      _worker.join();
+    }
+
+    GridPathCache(const GridPathCache &) = delete;
+    GridPathCache &operator=(const GridPathCache &) = delete;
+
+    /**
+     * Register a preset, returning its index. Takes effect at the next Update.
+     */
+    int AddPreset(Idx_t cell) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _presets.push_back(cell);
+      _presetsChanged = true;
+      return (int)_presets.size() - 1;
+    }
+
+    /**
+     * The index of the preset at cell, or -1 if there isn't one.
+     */
+    int FindPreset(Idx_t cell) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (size_t i = 0; i < _presets.size(); i++)
+        if (_presets[i] == cell)
+          return (int)i;
+      return -1;
+    }
+
+    /**
+     * Call with the grid whenever it may have changed, e.g. every update. If it
+     * or the presets have changed since the last build, drops the table and
+     * queues a rebuild. Only copies the grid when it has changed.
+     */
+    void Update(const grid_t &grid) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_presetsChanged && _hasGrid && grid.GetVersion() == _gridVersion)
+        return;
+
+      _presetsChanged = false;
+      _hasGrid = true;
+      _gridVersion = grid.GetVersion();
+      _table.reset();
+      _pending = std::make_unique<grid_t>(grid);
+      _pendingPresets = _presets;
+      _generation++;
+      _cv.notify_one();
+    }
+
+    /**
+     * As Update, but builds on the calling thread, e.g. at startup.
+     */
+    void Build(const grid_t &grid) {
+      std::vector<Idx_t> presets;
+      uint64_t generation;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _presetsChanged = false;
+        _hasGrid = true;
+        _gridVersion = grid.GetVersion();
+        _table.reset();
+        _pending.reset();
+        presets = _presets;
+        generation = ++_generation;
+      }
+
+      auto table = BuildTable(std::make_unique<grid_t>(grid), presets);
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (generation == _generation)
+        _table = table;
+    }
+
+    bool IsReady() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _table != nullptr;
+    }
+
+    /**
+     * The path from preset from to preset to, as AStar would plan it, or nothing
+     * if the table is being rebuilt or there is no path.
+     */
+    std::optional<path_t> Get(int from, int to) {
+      std::shared_ptr<const Table> table = GetTable();
+      if (!table || from < 0 || to < 0 || from >= table->n || to >= table->n)
+        return std::nullopt;
+
+      const Entry &entry = table->entries[from * table->n + to];
+      if (!entry.found)
+        return std::nullopt;
+
+      path_t path;
+      Idx_t cell{ entry.x, entry.y };
+      double cost = 0;
+      path.push_back({ table->grid->CenterOf(cell), units::unit_t<CostT>{0} });
+      for (uint32_t i = 0; i < entry.moves; i++) {
+        uint32_t m = entry.offset + i;
+        Idx_t move = kMoves[(table->moves[m / 2] >> (4 * (m % 2))) & 0xF];
+        cell += move;
+        cost += table->step.Move(move.x(), move.y());
+        path.push_back({ table->grid->CenterOf(cell), units::unit_t<CostT>{cost} });
+      }
+      return path;
+    }
+
+    /**
+     * The cost of the path from preset from to preset to, in O(1), or nothing if
+     * the table is being rebuilt or there is no path.
+     */
+    std::optional<units::unit_t<CostT>> Cost(int from, int to) {
+      std::shared_ptr<const Table> table = GetTable();
+      if (!table || from < 0 || to < 0 || from >= table->n || to >= table->n)
+        return std::nullopt;
+
+      const Entry &entry = table->entries[from * table->n + to];
+      if (!entry.found)
+        return std::nullopt;
+      return units::unit_t<CostT>{entry.cost};
+    }
+
+    /**
+     * Bytes used by the encoded moves of the current table.
+     */
+    size_t GetEncodedSize() {
+      std::shared_ptr<const Table> table = GetTable();
+      return table ? table->moves.size() : 0;
+    }
+
+   private:
+    // Indexed by move code
+    inline static const Idx_t kMoves[8] = {
+      { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }
+    };
+
+    struct Entry {
+      double cost = 0;
+      uint32_t offset = 0, moves = 0;
+      int16_t x = 0, y = 0;
+      bool found = false;
+    };
+
+    struct Table {
+      int n;
+      std::vector<Entry> entries;
+      std::vector<uint8_t> moves;
+      detail::StepCosts step;
+      std::unique_ptr<grid_t> grid;
+    };
+
+    static uint8_t MoveCode(Idx_t move) {
+      for (uint8_t code = 0; code < 8; code++)
+        if (kMoves[code] == move)
+          return code;
+      throw std::invalid_argument("Path step is not a single move");
+    }
+
+    std::shared_ptr<const Table> GetTable() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _table;
+    }
+
+    std::shared_ptr<Table> BuildTable(std::unique_ptr<grid_t> grid, const std::vector<Idx_t> &presets) const {
+      auto table = std::make_shared<Table>();
+      int n = (int)presets.size();
+      table->n = n;
+      table->entries.resize((size_t)n * n);
+      table->step = grid->template StepCostsOf<CostT>(_dxCost, _dyCost);
+
+      std::vector<uint8_t> codes;
+      auto append = [&](Entry &entry, const std::vector<Idx_t> &cells) {
+        entry.found = true;
+        entry.x = (int16_t)cells.front().x();
+        entry.y = (int16_t)cells.front().y();
+        entry.offset = (uint32_t)codes.size();
+        entry.moves = (uint32_t)cells.size() - 1;
+        for (size_t i = 1; i < cells.size(); i++)
+          codes.push_back(MoveCode(cells[i] - cells[i - 1]));
+      };
+
+      for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+          auto path = grid->template AStar<CostT>(presets[i], presets[j], _dxCost, _dyCost);
+          if (path.empty())
+            continue;
+
+          // Moves cost the same both ways, so the way back is the same path reversed
+          std::vector<Idx_t> cells;
+          for (auto &node : path)
+            cells.push_back(grid->Discretise(node.position));
+          Entry &there = table->entries[i * n + j], &back = table->entries[j * n + i];
+          append(there, cells);
+          std::reverse(cells.begin(), cells.end());
+          append(back, cells);
+          there.cost = back.cost = path.back().cost.value();
+        }
+
+        // Preset to itself is a path of one cell
+        Idx_t cell = grid->GetClosestValidNode(presets[i]);
+        if (!grid->Get(cell))
+          append(table->entries[i * n + i], { cell });
+      }
+
+      table->moves.assign((codes.size() + 1) / 2, 0);
+      for (size_t i = 0; i < codes.size(); i++)
+        table->moves[i / 2] |= codes[i] << (4 * (i % 2));
+
+      table->grid = std::move(grid);
+      return table;
+    }
+
+    void Run() {
+      while (true) {
+        std::unique_ptr<grid_t> grid;
+        std::vector<Idx_t> presets;
+        uint64_t generation;
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          _cv.wait(lock, [this]() { return !_running || _pending; });
+          if (!_running)
+            return;
+          grid = std::move(_pending);
+          presets = _pendingPresets;
+          generation = _generation;
+        }
+
+        auto table = BuildTable(std::move(grid), presets);
+
+        // Only publish it if nothing was queued or built while we were building
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (generation == _generation)
+          _table = table;
+      }
+    }
+
+    dx_cost_t _dxCost;
+    dy_cost_t _dyCost;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::vector<Idx_t> _presets, _pendingPresets;
+    bool _presetsChanged = false, _hasGrid = false;
+    uint64_t _gridVersion = 0;
+    // Goes up with every build requested, so an outdated build is never published
+    uint64_t _generation = 0;
+    std::unique_ptr<grid_t> _pending;
+    std::shared_ptr<const Table> _table;
+    bool _running = true;
+
+    std::thread _worker;
+  };
+}
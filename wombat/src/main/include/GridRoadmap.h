@@ -0,0 +1,348 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace wom {
+  /**
+   * A sparse roadmap over a DiscretisedOccupancyGrid that doesn't change, with
+   * the shortest routes to a fixed set of targets worked out ahead of time, e.g.
+   * the scoring positions on a field.
+   *
+   * The roadmap's nodes are the targets, a lattice of cells spread over the free
+   * space, and the free cells at every convex corner of the obstacles. Nodes are
+   * joined wherever they're close and in line of sight. Every node's cost and next
+   * node towards each target is found when the roadmap is built.
+   *
+   * A route from anywhere is then the cheapest node in line of sight of the start,
+   * followed down to the target, with any corners that can be seen past cut out.
+   * The route's cells are the corners of straight lines, not single steps.
+   */
+  template<typename T_X, typename T_Y, typename CostT>
+  class GridRoadmap {
+   public:
+    using grid_t = DiscretisedOccupancyGrid<T_X, T_Y>;
+    using Idx_t = typename grid_t::Idx_t;
+    using dx_cost_t = typename grid_t::template converting_unit<T_X, CostT>;
+    using dy_cost_t = typename grid_t::template converting_unit<T_Y, CostT>;
+
+    /**
+     * Build the roadmap. Targets in obstacles are moved to the nearest free cell.
+     * @param spacing Cells between nodes of the lattice. Nodes within three times
+     * this of each other are joined.
+     */
+    GridRoadmap(grid_t grid, std::vector<Idx_t> targets, dx_cost_t dxCost, dy_cost_t dyCost, int spacing = 8)
+      : _grid(std::move(grid)), _dxCost(dxCost), _dyCost(dyCost), _targets(std::move(targets)), _spacing(std::max(spacing, 1)), _radius(3 * _spacing) {
+      _step = _grid.template StepCostsOf<CostT>(_dxCost, _dyCost);
+      BuildNodes();
+      BuildEdges();
+      BuildRoutes();
+    }
+
+    /**
+     * The index of the target at cell, or -1 if there isn't one.
+     */
+    int FindTarget(Idx_t cell) const {
+      for (size_t i = 0; i < _targets.size(); i++)
+        if (_targets[i] == cell || _nodes[i] == cell)
+          return (int)i;
+      return -1;
+    }
+
+    size_t GetNodeCount() const {
+      return _nodes.size();
+    }
+
+    size_t GetEdgeCount() const {
+      size_t edges = 0;
+      for (auto &adjacent : _edges)
+        edges += adjacent.size();
+      return edges / 2;
+    }
+
+    grid_t &GetGrid() {
+      return _grid;
+    }
+
+    /**
+     * The corners of the route from from to target, starting at from (or the
+     * nearest free cell to it) and ending at the target, or nothing if it can't be
+     * reached.
+     */
+    std::vector<Idx_t> Route(Idx_t from, int target) {
+      if (target < 0 || target >= (int)_targets.size())
+        return {};
+
+      Idx_t start = _grid.GetClosestValidNode(from);
+      Idx_t goal = _nodes[target];
+      if (_grid.Get(start) || !std::isfinite(Distance(target, target)))
+        return {};
+
+      double cost;
+      int node = Connect(start, target, cost);
+      if (node == kNone)
+        return Search(start, goal);
+
+      std::vector<Idx_t> cells{ start };
+      for (int n = node; n != kDirect; n = _next[Slot(target, n)])
+        cells.push_back(_nodes[n]);
+      if (cells.back() != goal)
+        cells.push_back(goal);
+      return Shortcut(cells);
+    }
+
+    /**
+     * As Route, to to if it's a target. Otherwise, searches the grid for it, in
+     * which case the route may cut diagonally past corners as AStar does.
+     */
+    std::vector<Idx_t> Route(Idx_t from, Idx_t to) {
+      int target = FindTarget(to);
+      if (target >= 0)
+        return Route(from, target);
+      return Search(_grid.GetClosestValidNode(from), _grid.GetClosestValidNode(to));
+    }
+
+    /**
+     * The cost of Route(from, target), or nothing if it can't be reached or would
+     * need a search.
+     */
+    std::optional<units::unit_t<CostT>> Cost(Idx_t from, int target) {
+      if (target < 0 || target >= (int)_targets.size())
+        return std::nullopt;
+
+      Idx_t start = _grid.GetClosestValidNode(from);
+      if (_grid.Get(start) || !std::isfinite(Distance(target, target)))
+        return std::nullopt;
+
+      double cost;
+      if (Connect(start, target, cost) == kNone)
+        return std::nullopt;
+      return units::unit_t<CostT>{cost};
+    }
+
+    /**
+     * The cost of a straight line between the centres of a and b.
+     */
+    double Straight(Idx_t a, Idx_t b) const {
+      double dx = (b.x() - a.x()) * _step.x, dy = (b.y() - a.y()) * _step.y;
+      return std::sqrt(dx * dx + dy * dy);
+    }
+
+   private:
+    static constexpr int kDirect = -1;
+    static constexpr int kNone = -2;
+
+    size_t Slot(int target, int node) const {
+      return (size_t)target * _nodes.size() + node;
+    }
+
+    double Distance(int target, int node) const {
+      return _distance[Slot(target, node)];
+    }
+
+    // Blocks of the lattice, for finding the nodes near a cell
+    int BlockOf(int v) const {
+      return v / _spacing;
+    }
+
+    template<typename F>
+    void ForNodesNear(Idx_t cell, F f) const {
+      int reach = (_radius + _spacing - 1) / _spacing;
+      int bx = BlockOf(cell.x()), by = BlockOf(cell.y());
+      for (int y = std::max(by - reach, 0); y <= std::min(by + reach, _blockRows - 1); y++)
+        for (int x = std::max(bx - reach, 0); x <= std::min(bx + reach, _blockCols - 1); x++)
+          for (int n : _blocks[(size_t)y * _blockCols + x])
+            if ((_nodes[n] - cell).squaredNorm() <= _radius * _radius)
+              f(n);
+    }
+
+    bool Blocked(Idx_t cell) {
+      return _grid.Get(cell);
+    }
+
+    void AddNode(Idx_t cell, std::vector<int> &nodeAt) {
+      int cols = _grid.GetBits().Cols();
+      int &id = nodeAt[(size_t)cell.y() * cols + cell.x()];
+      if (id >= 0)
+        return;
+      id = (int)_nodes.size();
+      _nodes.push_back(cell);
+    }
+
+    void BuildNodes() {
+      int cols = _grid.GetBits().Cols(), rows = _grid.GetBits().Rows();
+      std::vector<int> nodeAt((size_t)cols * rows, -1);
+
+      // Targets first, so a target's node is its index. They may share a cell.
+      for (Idx_t target : _targets) {
+        Idx_t cell = _grid.GetClosestValidNode(target);
+        _nodes.push_back(cell);
+        if (!Blocked(cell) && nodeAt[(size_t)cell.y() * cols + cell.x()] < 0)
+          nodeAt[(size_t)cell.y() * cols + cell.x()] = (int)_nodes.size() - 1;
+      }
+
+      // A lattice over the free space, moved off obstacles if there's somewhere
+      // free nearby
+      for (int y = _spacing / 2; y < rows; y += _spacing) {
+        for (int x = _spacing / 2; x < cols; x += _spacing) {
+          Idx_t cell = _grid.GetClosestValidNode({ x, y });
+          if (!Blocked(cell) && (cell - Idx_t{ x, y }).cwiseAbs().maxCoeff() <= _spacing / 2)
+            AddNode(cell, nodeAt);
+        }
+      }
+
+      // Convex corners, which shortest routes bend around
+      for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+          Idx_t cell{ x, y };
+          if (Blocked(cell))
+            continue;
+          for (int dy = -1; dy <= 1; dy += 2) {
+            for (int dx = -1; dx <= 1; dx += 2) {
+              if (Blocked(cell + Idx_t{ dx, dy }) && !Blocked(cell + Idx_t{ dx, 0 }) && !Blocked(cell + Idx_t{ 0, dy })
+                  && x + dx >= 0 && y + dy >= 0 && x + dx < cols && y + dy < rows)
+                AddNode(cell, nodeAt);
+            }
+          }
+        }
+      }
+
+      _blockCols = BlockOf(cols - 1) + 1;
+      _blockRows = BlockOf(rows - 1) + 1;
+      _blocks.assign((size_t)_blockCols * _blockRows, {});
+      for (int n = 0; n < (int)_nodes.size(); n++)
+        if (!Blocked(_nodes[n]))
+          _blocks[(size_t)BlockOf(_nodes[n].y()) * _blockCols + BlockOf(_nodes[n].x())].push_back(n);
+    }
+
+    void BuildEdges() {
+      _edges.assign(_nodes.size(), {});
+      for (auto &block : _blocks) {
+        for (int a : block) {
+          ForNodesNear(_nodes[a], [&](int b) {
+            if (b > a && _nodes[a] != _nodes[b] && _grid.LineOfSight(_nodes[a], _nodes[b])) {
+              double cost = Straight(_nodes[a], _nodes[b]);
+              _edges[a].push_back({ b, cost });
+              _edges[b].push_back({ a, cost });
+            }
+          });
+        }
+      }
+
+      // Targets sharing a cell with another node stand in for it
+      for (int t = 0; t < (int)_targets.size(); t++) {
+        for (int n = 0; n < (int)_nodes.size(); n++) {
+          if (n != t && _nodes[n] == _nodes[t] && !Blocked(_nodes[t])) {
+            _edges[t].push_back({ n, 0 });
+            _edges[n].push_back({ t, 0 });
+          }
+        }
+      }
+    }
+
+    // Dijkstra out from each target, recording each node's next node back towards it
+    void BuildRoutes() {
+      size_t n = _nodes.size();
+      _distance.assign(_targets.size() * n, std::numeric_limits<double>::infinity());
+      _next.assign(_targets.size() * n, kDirect);
+
+      using entry = std::pair<double, int>;
+      for (int t = 0; t < (int)_targets.size(); t++) {
+        if (Blocked(_nodes[t]))
+          continue;
+
+        std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open;
+        _distance[Slot(t, t)] = 0;
+        open.push({ 0, t });
+        while (!open.empty()) {
+          auto [d, node] = open.top();
+          open.pop();
+          if (d > Distance(t, node))
+            continue;
+          for (auto [other, cost] : _edges[node]) {
+            if (d + cost < Distance(t, other)) {
+              _distance[Slot(t, other)] = d + cost;
+              _next[Slot(t, other)] = node;
+              open.push({ d + cost, other });
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * The node to join the roadmap at on the way from start to target, kDirect if
+     * the target can be seen from start and that's cheapest, or kNone if no node
+     * near start can be seen from it. cost is the total cost of the route.
+     */
+    int Connect(Idx_t start, int target, double &cost) {
+      Idx_t goal = _nodes[target];
+      std::vector<std::pair<double, int>> candidates;
+      candidates.push_back({ Straight(start, goal), kDirect });
+      ForNodesNear(start, [&](int n) {
+        double d = Distance(target, n);
+        if (std::isfinite(d))
+          candidates.push_back({ Straight(start, _nodes[n]) + d, n });
+      });
+
+      // Only the cheapest visible one matters, so check sight in order of cost
+      std::sort(candidates.begin(), candidates.end());
+      for (auto [c, n] : candidates) {
+        if (_grid.LineOfSight(start, n == kDirect ? goal : _nodes[n])) {
+          cost = c;
+          return n;
+        }
+      }
+      return kNone;
+    }
+
+    // Falls back to a search of the grid, for when the roadmap can't be reached
+    std::vector<Idx_t> Search(Idx_t start, Idx_t goal) {
+      auto path = _grid.template AStarStrict<CostT>(start, goal, _dxCost, _dyCost, units::unit_t<CostT>{0}, GridSearch::kJumpPoint);
+      std::vector<Idx_t> cells;
+      for (auto &node : path)
+        cells.push_back(_grid.Discretise(node.position));
+      return Shortcut(cells);
+    }
+
+    std::vector<Idx_t> Shortcut(const std::vector<Idx_t> &cells) {
+      if (cells.size() <= 2)
+        return cells;
+
+      std::vector<Idx_t> kept{ cells.front() };
+      size_t i = 0;
+      while (i + 1 < cells.size()) {
+        size_t j = cells.size() - 1;
+        while (j > i + 1 && !_grid.LineOfSight(cells[i], cells[j]))
+          j--;
+        kept.push_back(cells[j]);
+        i = j;
+      }
+      return kept;
+    }
+
+    grid_t _grid;
+    dx_cost_t _dxCost;
+    dy_cost_t _dyCost;
+    detail::StepCosts _step;
+
+    std::vector<Idx_t> _targets;
+    int _spacing, _radius;
+
+    std::vector<Idx_t> _nodes;
+    std::vector<std::vector<std::pair<int, double>>> _edges;
+    std::vector<std::vector<int>> _blocks;
+    int _blockCols = 0, _blockRows = 0;
+
+    // Indexed by Slot(target, node)
+    std::vector<double> _distance;
+    std::vector<int> _next;
+  };
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <units/time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+
+namespace wom {
+  /**
+   * A time parameterised motion through a DiscretisedOccupancyGrid, made from a
+   * grid path so a mechanism can follow it in one smooth movement instead of
+   * stepping from cell to cell.
+   *
+   * The path is first shortcut wherever there is line of sight, then the corners
+   * that are left are rounded off with quadratic blends that stay clear of
+   * obstacles, and finally the curve is timed as fast as the speed and
+   * acceleration limits of each axis allow.
+   */
+  template<typename T_X, typename T_Y>
+  class GridTrajectory {
+   public:
+    using grid_t = DiscretisedOccupancyGrid<T_X, T_Y>;
+    using Idx_t = typename grid_t::Idx_t;
+    using X_t = typename grid_t::X_t;
+    using Y_t = typename grid_t::Y_t;
+    using x_speed_t = units::unit_t<units::compound_unit<T_X, units::inverse<units::second>>>;
+    using y_speed_t = units::unit_t<units::compound_unit<T_Y, units::inverse<units::second>>>;
+    using x_accel_t = units::unit_t<units::compound_unit<T_X, units::inverse<units::squared<units::second>>>>;
+    using y_accel_t = units::unit_t<units::compound_unit<T_Y, units::inverse<units::squared<units::second>>>>;
+
+    struct Limits {
+      x_speed_t xSpeed;
+      y_speed_t ySpeed;
+      x_accel_t xAccel;
+      y_accel_t yAccel;
+
+      // How much of each straight a corner may use to round off, up to 0.5
+      double cornerFraction = 0.4;
+      // Samples per cell along the curve
+      int samplesPerCell = 4;
+    };
+
+    struct State {
+      units::second_t time;
+      X_t x;
+      Y_t y;
+      x_speed_t xSpeed;
+      y_speed_t ySpeed;
+    };
+
+    GridTrajectory() = default;
+
+    /**
+     * Build a trajectory along path, which should come from a search on grid.
+     * An empty path gives an empty trajectory.
+     */
+    template<typename CostT>
+    static GridTrajectory FromPath(grid_t &grid, const std::deque<typename grid_t::template GridPathNode<CostT>> &path, Limits limits) {
+      std::vector<Idx_t> cells;
+      for (auto &node : path)
+        cells.push_back(grid.Discretise(node.position));
+      return FromCells(grid, cells, limits);
+    }
+
+    static GridTrajectory FromCells(grid_t &grid, const std::vector<Idx_t> &cells, Limits limits) {
+      GridTrajectory trajectory;
+      if (cells.empty())
+        return trajectory;
+
+      // Work in seconds at full speed along each axis, so a step of 1 in either
+      // direction takes the same time and the speed limit is the same on both
+      Scale scale{
+        units::second_t{1 / limits.xSpeed * X_t{1}}.value(),
+        units::second_t{1 / limits.ySpeed * Y_t{1}}.value()
+      };
+      std::vector<Point> corners;
+      for (Idx_t cell : Shortcut(grid, cells)) {
+        auto center = grid.CenterOf(cell);
+        corners.push_back(Point{ center.x.value() * scale.x, center.y.value() * scale.y });
+      }
+
+      // Cell size in those units, for how finely to sample and check the curve
+      auto c0 = grid.CenterOf(Idx_t{ 0, 0 }), c1 = grid.CenterOf(Idx_t{ 1, 1 });
+      double cell = std::min(std::abs((c1.x - c0.x).value()) * scale.x, std::abs((c1.y - c0.y).value()) * scale.y);
+      double ds = cell / std::max(limits.samplesPerCell, 1);
+
+      std::vector<Point> curve = Round(grid, corners, scale, std::clamp(limits.cornerFraction, 0.0, 0.5), cell, ds);
+      trajectory.Time(curve, scale, limits, ds);
+      return trajectory;
+    }
+
+    /**
+     * The cells of path that are kept when every run of cells in line of sight
+     * of each other is cut down to its ends. Always keeps the first and last.
+     */
+    static std::vector<Idx_t> Shortcut(grid_t &grid, const std::vector<Idx_t> &cells) {
+      std::vector<Idx_t> kept;
+      if (cells.empty())
+        return kept;
+
+      size_t i = 0;
+      kept.push_back(cells[0]);
+      while (i + 1 < cells.size()) {
+        // The next cell is always reachable, it's the next step of the path
+        size_t j = cells.size() - 1;
+        while (j > i + 1 && !grid.LineOfSight(cells[i], cells[j]))
+          j--;
+        kept.push_back(cells[j]);
+        i = j;
+      }
+      return kept;
+    }
+
+    units::second_t Duration() const {
+      return _states.empty() ? units::second_t{0} : _states.back().time;
+    }
+
+    bool Empty() const {
+      return _states.empty();
+    }
+
+    const std::vector<State> &GetStates() const {
+      return _states;
+    }
+
+    /**
+     * Where the trajectory is at time t, held at the ends outside of it.
+     */
+    State Sample(units::second_t t) const {
+      if (_states.empty())
+        return State{ t, X_t{0}, Y_t{0}, x_speed_t{0}, y_speed_t{0} };
+      if (t <= _states.front().time)
+        return _states.front();
+      if (t >= _states.back().time)
+        return _states.back();
+
+      auto after = std::upper_bound(_states.begin(), _states.end(), t, [](units::second_t t, const State &s) { return t < s.time; });
+      const State &b = *after, &a = *(after - 1);
+      double f = ((t - a.time) / (b.time - a.time)).value();
+      return State{
+        t,
+        a.x + (b.x - a.x) * f,
+        a.y + (b.y - a.y) * f,
+        a.xSpeed + (b.xSpeed - a.xSpeed) * f,
+        a.ySpeed + (b.ySpeed - a.ySpeed) * f
+      };
+    }
+
+   private:
+    struct Point {
+      double x, y;
+
+      Point operator+(Point o) const { return { x + o.x, y + o.y }; }
+      Point operator-(Point o) const { return { x - o.x, y - o.y }; }
+      Point operator*(double k) const { return { x * k, y * k }; }
+      double Norm() const { return std::hypot(x, y); }
+    };
+
+    // Seconds per unit of X_t and Y_t at full speed
+    struct Scale {
+      double x, y;
+    };
+
+    static bool Clear(grid_t &grid, Point p, Scale scale) {
+      return !grid.Get(grid.Discretise({ X_t{p.x / scale.x}, Y_t{p.y / scale.y} }));
+    }
+
+    static void AppendLine(std::vector<Point> &curve, Point a, Point b, double ds) {
+      int n = std::max(1, (int)std::ceil((b - a).Norm() / ds));
+      for (int i = 1; i <= n; i++)
+        curve.push_back(a + (b - a) * ((double)i / n));
+    }
+
+    static Point Bezier(Point a, Point corner, Point b, double u) {
+      return a * ((1 - u) * (1 - u)) + corner * (2 * u * (1 - u)) + b * (u * u);
+    }
+
+    /**
+     * Dense points along the corners with each inside corner replaced by a
+     * quadratic blend, shrunk until it misses every obstacle (or to nothing).
+     */
+    static std::vector<Point> Round(grid_t &grid, const std::vector<Point> &corners, Scale scale, double fraction, double cell, double ds) {
+      std::vector<Point> curve{ corners.front() };
+      Point from = corners.front();
+      for (size_t k = 1; k + 1 < corners.size(); k++) {
+        Point in = corners[k] - corners[k - 1], out = corners[k + 1] - corners[k];
+        double r = fraction * std::min(in.Norm(), out.Norm());
+
+        for (; r > cell / 4; r /= 2) {
+          Point a = corners[k] - in * (r / in.Norm()), b = corners[k] + out * (r / out.Norm());
+          int n = std::max(2, (int)std::ceil(2 * r / ds));
+          bool clear = true;
+          for (int i = 0; i <= n && clear; i++)
+            clear = Clear(grid, Bezier(a, corners[k], b, (double)i / n), scale);
+          if (!clear)
+            continue;
+
+          AppendLine(curve, from, a, ds);
+          for (int i = 1; i <= n; i++)
+            curve.push_back(Bezier(a, corners[k], b, (double)i / n));
+          from = b;
+          break;
+        }
+
+        if (!(r > cell / 4)) {
+          // No room to round it, stop at the corner
+          AppendLine(curve, from, corners[k], ds);
+          from = corners[k];
+        }
+      }
+      if (corners.size() > 1)
+        AppendLine(curve, from, corners.back(), ds);
+      return curve;
+    }
+
+    /**
+     * Time the curve with a forward and backward pass over its points: the speed
+     * at each point is capped by both axes' speed limits along the tangent, and
+     * by their acceleration limits around the bend. Between points, the speed
+     * changes no faster than the axes' acceleration limits along the tangent.
+     * It starts and ends at rest.
+     */
+    void Time(const std::vector<Point> &curve, Scale scale, Limits limits, double ds) {
+      // Accelerations, in the scaled units: seconds per second squared
+      double ax = std::abs(units::unit_t<units::inverse<units::second>>{limits.xAccel / limits.xSpeed}.value());
+      double ay = std::abs(units::unit_t<units::inverse<units::second>>{limits.yAccel / limits.ySpeed}.value());
+
+      size_t n = curve.size();
+      std::vector<Point> tangent(n);
+      std::vector<double> length(n, 0), vmax(n), along(n);
+      for (size_t i = 0; i < n; i++) {
+        Point d = curve[std::min(i + 1, n - 1)] - curve[i > 0 ? i - 1 : 0];
+        tangent[i] = d.Norm() > 0 ? d * (1 / d.Norm()) : Point{ 0, 0 };
+        if (i > 0)
+          length[i] = (curve[i] - curve[i - 1]).Norm();
+
+        double tx = std::abs(tangent[i].x), ty = std::abs(tangent[i].y);
+        vmax[i] = 1 / std::max({ tx, ty, 1e-9 });
+        along[i] = std::min(tx > 1e-9 ? ax / tx : std::numeric_limits<double>::infinity(), ty > 1e-9 ? ay / ty : std::numeric_limits<double>::infinity());
+        if (!std::isfinite(along[i]))
+          along[i] = std::min(ax, ay);
+      }
+
+      // Centripetal acceleration is speed squared times the change in tangent per
+      // distance. Around bends, half of each axis' acceleration goes to turning
+      // and half to speeding up or slowing down.
+      for (size_t i = 1; i + 1 < n; i++) {
+        double step = std::max(length[i] + length[i + 1], ds * 1e-6);
+        Point bend = (tangent[i + 1] - tangent[i - 1]) * (1 / step);
+        if (std::abs(bend.x) > 1e-9 || std::abs(bend.y) > 1e-9)
+          along[i] /= 2;
+        if (std::abs(bend.x) > 1e-9)
+          vmax[i] = std::min(vmax[i], std::sqrt(ax / 2 / std::abs(bend.x)));
+        if (std::abs(bend.y) > 1e-9)
+          vmax[i] = std::min(vmax[i], std::sqrt(ay / 2 / std::abs(bend.y)));
+      }
+
+      std::vector<double> v(n);
+      v[0] = 0;
+      for (size_t i = 1; i < n; i++)
+        v[i] = std::min(vmax[i], std::sqrt(v[i - 1] * v[i - 1] + 2 * along[i - 1] * length[i]));
+      v[n - 1] = 0;
+      for (size_t i = n - 1; i-- > 0;)
+        v[i] = std::min(v[i], std::sqrt(v[i + 1] * v[i + 1] + 2 * along[i + 1] * length[i + 1]));
+
+      _states.clear();
+      _states.reserve(n);
+      double t = 0;
+      for (size_t i = 0; i < n; i++) {
+        if (i > 0 && length[i] > 0)
+          t += 2 * length[i] / std::max(v[i - 1] + v[i], 1e-9);
+        _states.push_back(State{
+          units::second_t{t},
+          X_t{curve[i].x / scale.x},
+          Y_t{curve[i].y / scale.y},
+          x_speed_t{v[i] * tangent[i].x / scale.x},
+          y_speed_t{v[i] * tangent[i].y / scale.y}
+        });
+      }
+    }
+
+    std::vector<State> _states;
+  };
+}
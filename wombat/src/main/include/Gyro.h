@@ -1,17 +1,51 @@
 #pragma once
 
 #include "sim/SimGyro.h"
+#include "Util.h"
 #include <frc/interfaces/Gyro.h>
+#include <units/frequency.h>
 
 namespace wom {
+  struct GyroSample {
+    double angle = 0;   // deg, CW+ as per frc::Gyro
+    double rate = 0;    // deg/s
+    units::radian_t pitch{0};
+    units::radian_t roll{0};
+    units::second_t timestamp{0};
+  };
+
   class Gyro : public frc::Gyro {
    public:
+    /**
+     * Read the hardware once and hold the reading, which is then returned by the
+     * getters until the next Sample. Usually called by a SensorFrame.
+     */
+    virtual void Sample(units::second_t timestamp) = 0;
+
+    /**
+     * Read the angle (deg, CW+) from the hardware, bypassing any sample.
+     */
+    virtual double ReadAngle() const = 0;
+
+    /**
+     * As GetRotation2d, but read from the hardware, bypassing any sample.
+     */
+    frc::Rotation2d ReadRotation2d() const {
+      return units::degree_t{-ReadAngle()};
+    }
+
     virtual std::shared_ptr<sim::SimCapableGyro> MakeSimGyro() = 0;
   };
 
+  class NavXSimGyro;
+
   class NavX : public Gyro {
    public:
-    NavX();
+    /**
+     * The gyro reports at the given rate, up to 200Hz. Raise it to match anything
+     * reading it faster than the robot loop, such as the odometry thread.
+     */
+    NavX(units::hertz_t updateRate = 60_Hz);
     ~NavX();
     /* From frc::Gyro */
     void Calibrate() override;
@@ -24,9 +58,18 @@ namespace wom {
 
     void SetAngle(units::radian_t angle);
 
+    void Sample(units::second_t timestamp) override;
+    GyroSample GetSample() const;
+    double ReadAngle() const override;
+
     std::shared_ptr<sim::SimCapableGyro> MakeSimGyro() override;
    private:
+    friend class NavXSimGyro;
+
     class Impl;
     Impl *impl;
+
+    SeqLocked<GyroSample> _sample;
+    std::atomic<bool> _sampled{false};
   };
 }
\ No newline at end of file
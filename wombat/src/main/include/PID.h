@@ -28,6 +28,26 @@ namespace wom {
       RegisterNT();
     }
 
+    // Copies bind to the same NT path, so a gain written to NT (by hand or by
+    // PIDAutotune) reaches every controller holding a copy of this config.
+    PIDConfig(const PIDConfig &other)
+      : path(other.path), kp(other.kp), ki(other.ki), kd(other.kd), stableThresh(other.stableThresh), stableDerivThresh(other.stableDerivThresh), izone(other.izone) {
+      RegisterNT();
+    }
+
+    PIDConfig &operator=(const PIDConfig &other) {
+      path = other.path;
+      kp = other.kp;
+      ki = other.ki;
+      kd = other.kd;
+      stableThresh = other.stableThresh;
+      stableDerivThresh = other.stableDerivThresh;
+      izone = other.izone;
+      _nt_bindings.clear();
+      RegisterNT();
+      return *this;
+    }
+
     std::string path;
 
     kp_t kp;
@@ -0,0 +1,286 @@
+#pragma once
+
+#include "PID.h"
+#include "behaviour/Behaviour.h"
+
+#include <units/base.h>
+#include <units/math.h>
+#include <units/time.h>
+
+#include <networktables/NetworkTableInstance.h>
+
+#include <cmath>
+#include <functional>
+#include <numbers>
+#include <optional>
+#include <vector>
+
+namespace wom {
+  /**
+   * The rule used to turn the ultimate gain (Ku) and ultimate period (Tu) measured
+   * by the relay experiment into PID gains.
+   */
+  enum class PIDAutotuneRule {
+    kZieglerNichols,      // Kp = 0.6Ku,  Ti = Tu/2,   Td = Tu/8
+    kZieglerNicholsPI,    // Kp = 0.45Ku, Ti = Tu/1.2, Td = 0
+    kPessenIntegral,      // Kp = 0.7Ku,  Ti = 0.4Tu,  Td = 0.15Tu
+    kSomeOvershoot,       // Kp = 0.33Ku, Ti = Tu/2,   Td = Tu/3
+    kNoOvershoot          // Kp = 0.2Ku,  Ti = Tu/2,   Td = Tu/3
+  };
+
+  enum class PIDAutotuneState {
+    kRelay,
+    kDone,
+    kFailed
+  };
+
+  template<typename IN, typename OUT>
+  struct PIDAutotuneConfig {
+    using in_t = units::unit_t<IN>;
+    using out_t = units::unit_t<OUT>;
+
+    /**
+     * The process value the relay oscillates around.
+     */
+    in_t setpoint;
+    /**
+     * The relay output amplitude, applied as bias +/- relayAmplitude.
+     */
+    out_t relayAmplitude;
+    /**
+     * Constant output added to the relay, e.g. to hold an arm against gravity.
+     */
+    out_t bias{0};
+    /**
+     * Error band the relay must cross before switching. Stops sensor noise from
+     * chattering the relay.
+     */
+    in_t hysteresis{0};
+    /**
+     * Number of full oscillations to average over, after the first (transient)
+     * cycle is thrown away.
+     */
+    int cycles = 4;
+    /**
+     * Maximum spread of measured periods, as a fraction of the mean, before the
+     * result is trusted.
+     */
+    double periodTolerance = 0.15;
+    /**
+     * Wrap range of the process value, as in PIDController::SetWrap.
+     */
+    std::optional<in_t> wrap;
+
+    PIDAutotuneRule rule = PIDAutotuneRule::kZieglerNichols;
+  };
+
+  /**
+   * Relay feedback (Astrom-Hagglund) autotuner. Replaces the PID loop with a relay,
+   * which drives the plant into a limit cycle at its ultimate period. The ultimate
+   * gain is recovered from the oscillation amplitude, and gains are proposed from
+   * the tuning rule.
+   *
+   * The plant is reached only through the sensor and output functions, so the same
+   * behaviour runs against real hardware or any of the simulators. On completion
+   * the gains are written to the PIDConfig and published on its NT path, which
+   * updates every PIDConfig bound to that path.
+   */
+  template<typename IN, typename OUT>
+  class PIDAutotune : public behaviour::Behaviour {
+   public:
+    using config_t = PIDConfig<IN, OUT>;
+    using tune_config_t = PIDAutotuneConfig<IN, OUT>;
+    using in_t = units::unit_t<IN>;
+    using out_t = units::unit_t<OUT>;
+
+    using sensor_fn_t = std::function<in_t()>;
+    using output_fn_t = std::function<void(out_t)>;
+
+    PIDAutotune(std::string path, config_t &pid, tune_config_t tuneConfig, sensor_fn_t sensor, output_fn_t output, behaviour::HasBehaviour *system = nullptr)
+      : behaviour::Behaviour("PIDAutotune " + pid.path),
+        _pid(pid), _tuneConfig(tuneConfig), _sensor(sensor), _output(output),
+        _table(nt::NetworkTableInstance::GetDefault().GetTable(path)) {
+      Controls(system);
+    }
+
+    void OnStart() override {
+      _state = PIDAutotuneState::kRelay;
+      _time = 0_s;
+      _relayHigh = GetError(_sensor()) > in_t{0};
+      _lastRise.reset();
+      _periods.clear();
+      _amplitudes.clear();
+      ResetPeaks();
+    }
+
+    void OnTick(units::second_t dt) override {
+      _time += dt;
+
+      in_t pv = _sensor();
+      in_t error = GetError(pv);
+
+      _max = units::math::max(_max, error);
+      _min = units::math::min(_min, error);
+
+      if (_relayHigh && error < -_tuneConfig.hysteresis) {
+        _relayHigh = false;
+      } else if (!_relayHigh && error > _tuneConfig.hysteresis) {
+        _relayHigh = true;
+        OnRisingSwitch();
+      }
+
+      _output(_tuneConfig.bias + (_relayHigh ? _tuneConfig.relayAmplitude : -_tuneConfig.relayAmplitude));
+
+      _table->GetEntry("pv").SetDouble(pv.value());
+      _table->GetEntry("error").SetDouble(error.value());
+      _table->GetEntry("relayHigh").SetBoolean(_relayHigh);
+      _table->GetEntry("cycles").SetDouble(_periods.size());
+
+      if (_state != PIDAutotuneState::kRelay)
+        SetDone();
+    }
+
+    void OnStop() override {
+      _output(out_t{0});
+      if (_state == PIDAutotuneState::kRelay)
+        _table->GetEntry("state").SetString("interrupted");
+    }
+
+    PIDAutotuneState GetState() const {
+      return _state;
+    }
+
+    /**
+     * The ultimate gain, valid once the state is kDone.
+     */
+    typename config_t::kp_t GetUltimateGain() const {
+      return _ku;
+    }
+
+    /**
+     * The ultimate (oscillation) period, valid once the state is kDone.
+     */
+    units::second_t GetUltimatePeriod() const {
+      return _tu;
+    }
+
+   private:
+    in_t GetError(in_t pv) const {
+      in_t error = _tuneConfig.setpoint - pv;
+      if (_tuneConfig.wrap.has_value()) {
+        double wr = _tuneConfig.wrap.value().value();
+        double v = std::fmod(error.value(), wr);
+        if (std::abs(v) > wr / 2.0)
+          v += (v > 0) ? -wr : wr;
+        error = in_t{v};
+      }
+      return error;
+    }
+
+    void ResetPeaks() {
+      _max = in_t{-1e9};
+      _min = in_t{1e9};
+    }
+
+    void OnRisingSwitch() {
+      if (_lastRise.has_value()) {
+        _periods.push_back(_time - _lastRise.value());
+        _amplitudes.push_back((_max - _min) / 2.0);
+      }
+      _lastRise = _time;
+      ResetPeaks();
+
+      // The first cycle starts from rest and is not representative.
+      if ((int)_periods.size() >= _tuneConfig.cycles + 1)
+        Finish();
+    }
+
+    void Finish() {
+      units::second_t period{0};
+      in_t amplitude{0};
+      for (size_t i = 1; i < _periods.size(); i++) {
+        period += _periods[i];
+        amplitude += _amplitudes[i];
+      }
+      period = period / (double)(_periods.size() - 1);
+      amplitude = amplitude / (double)(_amplitudes.size() - 1);
+
+      for (size_t i = 1; i < _periods.size(); i++) {
+        if (units::math::abs(_periods[i] - period) > _tuneConfig.periodTolerance * period) {
+          _state = PIDAutotuneState::kFailed;
+          _table->GetEntry("state").SetString("failed: inconsistent period");
+          return;
+        }
+      }
+
+      // Describing function of a relay with hysteresis, d the relay amplitude and
+      // e the hysteresis: Ku = 4d / (pi * sqrt(a^2 - e^2))
+      double a = amplitude.value();
+      double e = _tuneConfig.hysteresis.value();
+      if (a <= e) {
+        _state = PIDAutotuneState::kFailed;
+        _table->GetEntry("state").SetString("failed: no oscillation");
+        return;
+      }
+      double ku = 4.0 * _tuneConfig.relayAmplitude.value() / (std::numbers::pi * std::sqrt(a * a - e * e));
+
+      _ku = typename config_t::kp_t{ku};
+      _tu = period;
+
+      double kp = 0, ti = 0, td = 0;
+      double tu = period.value();
+      switch (_tuneConfig.rule) {
+        case PIDAutotuneRule::kZieglerNichols:
+          kp = 0.6 * ku; ti = tu / 2.0; td = tu / 8.0;
+          break;
+        case PIDAutotuneRule::kZieglerNicholsPI:
+          kp = 0.45 * ku; ti = tu / 1.2; td = 0;
+          break;
+        case PIDAutotuneRule::kPessenIntegral:
+          kp = 0.7 * ku; ti = 0.4 * tu; td = 0.15 * tu;
+          break;
+        case PIDAutotuneRule::kSomeOvershoot:
+          kp = 0.33 * ku; ti = tu / 2.0; td = tu / 3.0;
+          break;
+        case PIDAutotuneRule::kNoOvershoot:
+          kp = 0.2 * ku; ti = tu / 2.0; td = tu / 3.0;
+          break;
+      }
+
+      _pid.kp = typename config_t::kp_t{kp};
+      _pid.ki = typename config_t::ki_t{kp / ti};
+      _pid.kd = typename config_t::kd_t{kp * td};
+
+      auto pidTable = nt::NetworkTableInstance::GetDefault().GetTable(_pid.path);
+      pidTable->GetEntry("kP").SetDouble(_pid.kp.value());
+      pidTable->GetEntry("kI").SetDouble(_pid.ki.value());
+      pidTable->GetEntry("kD").SetDouble(_pid.kd.value());
+
+      _table->GetEntry("ku").SetDouble(ku);
+      _table->GetEntry("tu").SetDouble(tu);
+      _table->GetEntry("amplitude").SetDouble(a);
+      _table->GetEntry("state").SetString("done");
+
+      _state = PIDAutotuneState::kDone;
+    }
+
+    config_t &_pid;
+    tune_config_t _tuneConfig;
+    sensor_fn_t _sensor;
+    output_fn_t _output;
+
+    std::shared_ptr<nt::NetworkTable> _table;
+
+    PIDAutotuneState _state = PIDAutotuneState::kRelay;
+    units::second_t _time{0};
+    bool _relayHigh = false;
+
+    std::optional<units::second_t> _lastRise;
+    std::vector<units::second_t> _periods;
+    std::vector<in_t> _amplitudes;
+    in_t _max{0}, _min{0};
+
+    typename config_t::kp_t _ku{0};
+    units::second_t _tu{0};
+  };
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+namespace wom {
+  /**
+   * A fixed size ring buffer with one writer and any number of lock-free readers.
+   * Each slot is guarded by a sequence counter (a seqlock), so a reader that races
+   * the writer retries rather than returning a half written value. Writers must be
+   * serialised by the owner, e.g. by only pushing from one thread or under a mutex.
+   *
+   * @tparam T A trivially copyable value type
+   * @tparam N The number of values retained
+   */
+  template<typename T, size_t N>
+  class RingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "RingBuffer values must be trivially copyable");
+
+   public:
+    void Push(const T &value) {
+      uint64_t n = _count.load(std::memory_order_relaxed);
+      Slot &slot = _slots[n % N];
+
+      uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+      slot.seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.value = value;
+      slot.seq.store(seq + 2, std::memory_order_release);
+
+      _count.store(n + 1, std::memory_order_release);
+    }
+
+    /**
+     * @return The most recently pushed value, if any.
+     */
+    std::optional<T> Latest() const {
+      return Get(0);
+    }
+
+    /**
+     * @param age 0 for the newest value, 1 for the one before it, etc.
+     * @return The value, or nothing if it has not been pushed or was overwritten.
+     */
+    std::optional<T> Get(size_t age) const {
+      while (true) {
+        uint64_t n = _count.load(std::memory_order_acquire);
+        if (age >= n || age >= N)
+          return {};
+
+        const Slot &slot = _slots[(n - 1 - age) % N];
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1)
+          continue;
+
+        T value = slot.value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t after = slot.seq.load(std::memory_order_relaxed);
+
+        if (before == after && _count.load(std::memory_order_relaxed) - n < N - age)
+          return value;
+      }
+    }
+
+    /**
+     * @return The number of values currently held, at most N.
+     */
+    size_t Size() const {
+      uint64_t n = _count.load(std::memory_order_acquire);
+      return n < N ? n : N;
+    }
+
+    static constexpr size_t Capacity() {
+      return N;
+    }
+
+   private:
+    struct Slot {
+      std::atomic<uint32_t> seq{0};
+      T value{};
+    };
+
+    std::array<Slot, N> _slots;
+    std::atomic<uint64_t> _count{0};
+  };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Encoder.h"
+#include "Gyro.h"
+
+#include <units/time.h>
+
+#include <vector>
+
+namespace wom {
+  /**
+   * A SensorFrame samples every registered encoder and gyro once per robot loop.
+   * Call Sample() at the top of RobotPeriodic; for the rest of the cycle every
+   * consumer reads the same timestamped reading, rather than each call going back to
+   * the hardware (a CAN status frame lookup for the CTRE and REV controllers).
+   */
+  class SensorFrame {
+   public:
+    void Register(Encoder *encoder);
+    void Register(Gyro *gyro);
+
+    /**
+     * Sample all registered sensors, stamped with the current FPGA time.
+     */
+    void Sample();
+
+    /**
+     * @return units::second_t The timestamp of the latest Sample()
+     */
+    units::second_t GetTimestamp() const;
+
+   private:
+    std::vector<Encoder *> _encoders;
+    std::vector<Gyro *> _gyros;
+
+    units::second_t _timestamp{0};
+  };
+}
@@ -2,6 +2,13 @@
 
 #include <frc/RobotController.h>
 #include <units/time.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
 namespace wom {
   template<typename T>
   T&& invert(T &&system) {
@@ -10,4 +17,54 @@ namespace wom {
   }
 
   units::second_t now();
-}
\ No newline at end of file
+
+  /**
+   * Call f(std::integral_constant<size_t, I>{}) for each I in [0, N), unrolled at
+   * compile time. The index is usable as a constant expression inside f.
+   */
+  template<size_t N, typename F>
+  constexpr void unroll(F &&f) {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (f(std::integral_constant<size_t, I>{}), ...);
+    }(std::make_index_sequence<N>{});
+  }
+
+  /**
+   * A value written periodically by one thread and read by any other, without
+   * locks. The value is guarded by a sequence counter (a seqlock, as in RingBuffer),
+   * so a reader that races the writer retries rather than returning a half
+   * written value. Writers must be serialised by the owner.
+   *
+   * @tparam T A trivially copyable value type
+   */
+  template<typename T>
+  class SeqLocked {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLocked values must be trivially copyable");
+
+   public:
+    void Write(const T &value) {
+      uint32_t seq = _seq.load(std::memory_order_relaxed);
+      _seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      _value = value;
+      _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    T Read() const {
+      while (true) {
+        uint32_t before = _seq.load(std::memory_order_acquire);
+        if (before & 1)
+          continue;
+
+        T value = _value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_seq.load(std::memory_order_relaxed) == before)
+          return value;
+      }
+    }
+
+   private:
+    T _value{};
+    std::atomic<uint32_t> _seq{0};
+  };
+}
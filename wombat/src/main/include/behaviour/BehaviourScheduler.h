@@ -48,9 +48,20 @@ class BehaviourScheduler {
    */
   void InterruptAll();
 
+  /**
+   * Tick scheduled behaviours from Tick() on the calling thread, instead of each
+   * on its own thread at its own period. Used where time is stepped manually,
+   * such as the headless simulator, so behaviours run in lockstep with it.
+   * Must be set before anything is scheduled.
+   */
+  void SetStepped(bool stepped);
+
  private:
   std::vector<HasBehaviour *> _systems;
   std::recursive_mutex        _active_mtx;
   std::vector<std::thread>    _threads;
+
+  bool                        _stepped = false;
+  std::vector<Behaviour::ptr> _steppedBehaviours;
 };
 }  // namespace behaviour
\ No newline at end of file
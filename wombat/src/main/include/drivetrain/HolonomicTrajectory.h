@@ -0,0 +1,92 @@
+#pragma once
+
+#include "drivetrain/SwerveDrive.h"
+
+#include <frc/geometry/Pose2d.h>
+#include <units/acceleration.h>
+#include <units/angular_acceleration.h>
+#include <units/time.h>
+#include <wpi/MappedFileRegion.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wom {
+  struct HolonomicTrajectorySample {
+    units::second_t time{0};
+    frc::Pose2d pose;
+    /**
+     * Field relative velocity, used as the feedforward when following
+     */
+    FieldRelativeSpeeds velocity;
+    units::meters_per_second_squared_t ax{0};
+    units::meters_per_second_squared_t ay{0};
+    units::radians_per_second_squared_t alpha{0};
+  };
+
+  /**
+   * A holonomic (swerve) trajectory, sampled at a fixed time step so any sample is
+   * found in O(1). Trajectories are generated offline by scripts/trajectory_gen.py
+   * and deployed as binary .traj files, which are memory mapped rather than parsed.
+   *
+   * File layout (little endian):
+   *   char[4] magic "WTRJ", uint32 version, uint32 count, float32 dt
+   *   count * float32[9] { x, y, heading, vx, vy, omega, ax, ay, alpha }
+   * in metres, radians and seconds, field relative. Heading is continuous (not
+   * wrapped) so it can be interpolated directly.
+   *
+   * Trajectories generated on the robot hold the same samples in memory instead.
+   */
+  class HolonomicTrajectory {
+   public:
+    struct FileHeader {
+      char magic[4];
+      uint32_t version;
+      uint32_t count;
+      float dt;
+    };
+
+    struct FileSample {
+      float x, y, heading;
+      float vx, vy, omega;
+      float ax, ay, alpha;
+    };
+
+    static constexpr uint32_t kVersion = 1;
+
+    /**
+     * Map a trajectory file.
+     * @return The trajectory, or nullptr if the file is missing or malformed.
+     */
+    static std::shared_ptr<HolonomicTrajectory> Load(std::string path);
+
+    /**
+     * Create a trajectory from samples in memory, spaced dt seconds apart.
+     */
+    static std::shared_ptr<HolonomicTrajectory> FromSamples(std::vector<FileSample> samples, float dt);
+
+    /**
+     * Sample the trajectory, interpolating between the two nearest samples. Times
+     * outside the trajectory are clamped to its ends.
+     */
+    HolonomicTrajectorySample Sample(units::second_t time) const;
+
+    units::second_t GetDuration() const;
+    frc::Pose2d GetInitialPose() const;
+    frc::Pose2d GetFinalPose() const;
+    size_t Size() const { return _count; }
+
+   private:
+    HolonomicTrajectory(wpi::MappedFileRegion region, const FileSample *samples, uint32_t count, float dt);
+    HolonomicTrajectory(std::vector<FileSample> samples, float dt);
+
+    wpi::MappedFileRegion _region;
+    std::vector<FileSample> _owned;
+    // Points into either _region or _owned
+    const FileSample *_samples;
+    uint32_t _count;
+    float _dt;
+  };
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "drivetrain/HolonomicTrajectory.h"
+
+#include <frc/geometry/Pose2d.h>
+#include <frc/trajectory/Trajectory.h>
+#include <units/acceleration.h>
+#include <units/angle.h>
+#include <units/angular_acceleration.h>
+#include <units/angular_velocity.h>
+#include <units/length.h>
+#include <units/velocity.h>
+
+#include <array>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace wom {
+  struct HolonomicTrajectoryPlannerConfig {
+    units::meters_per_second_t maxVelocity = 1.5_mps;
+    units::meters_per_second_squared_t maxAcceleration = 2_mps_sq;
+    units::meters_per_second_squared_t maxCentripetalAcceleration = 2_mps_sq;
+    units::radians_per_second_t maxAngularVelocity = 3_rad_per_s;
+    units::radians_per_second_squared_t maxAngularAcceleration = 6_rad_per_s_sq;
+
+    /**
+     * Distance from the centre of the robot to its furthest module. Turning moves
+     * the modules at this radius, and that speed is taken out of maxVelocity so
+     * no module is asked for more than maxVelocity. Zero leaves it all to
+     * translation.
+     */
+    units::meter_t moduleRadius = 0_m;
+    units::second_t dt = 20_ms;
+
+    /**
+     * Start poses within the same cell share a trajectory, which starts at the
+     * centre of the cell. The pose PID loops absorb the difference. Targets are
+     * never rounded, the trajectory always ends exactly on them.
+     */
+    units::meter_t positionQuantum = 10_cm;
+    units::radian_t angleQuantum = 5_deg;
+
+    /**
+     * Number of trajectories kept before the oldest are evicted.
+     */
+    size_t cacheSize = 64;
+
+    /**
+     * Points to pass through on the way from start to target, e.g. to get around
+     * obstacles. Called on the planner's thread. None if not set.
+     */
+    std::function<std::vector<frc::Translation2d>(frc::Pose2d start, frc::Pose2d target)> route = nullptr;
+  };
+
+  /**
+   * Generates quintic spline trajectories between two poses on a background thread.
+   * Translation follows a quintic hermite spline limited by velocity, acceleration
+   * and centripetal acceleration; heading is eased independently from the start
+   * heading to the target heading over the same time, which is stretched if the
+   * turn needs longer within the angular limits. If the config has a route, the
+   * translation is a cubic spline through its points instead.
+   *
+   * Results are cached by quantised start pose and exact target, so requesting the same
+   * alignment again is free, and generating a new one never blocks the caller.
+   */
+  class HolonomicTrajectoryPlanner {
+   public:
+    HolonomicTrajectoryPlanner(HolonomicTrajectoryPlannerConfig config = {});
+    ~HolonomicTrajectoryPlanner();
+
+    /**
+     * Get the trajectory from start to target. Never blocks.
+     * @return The trajectory if it is cached, otherwise nullptr, in which case it is
+     * queued for generation and a later call will return it.
+     */
+    std::shared_ptr<HolonomicTrajectory> Request(frc::Pose2d start, frc::Pose2d target);
+
+    /**
+     * Generate a trajectory on the calling thread, bypassing the cache.
+     */
+    std::shared_ptr<HolonomicTrajectory> Generate(frc::Pose2d start, frc::Pose2d target) const;
+
+    size_t GetCacheSize();
+
+    /**
+     * Drop every cached and queued trajectory, e.g. when the route to a target has
+     * changed. One being generated when this is called is thrown away.
+     */
+    void ClearCache();
+
+   private:
+    struct key_t {
+      std::array<int, 3> start;
+      std::array<double, 3> target;
+
+      bool operator<(const key_t &other) const {
+        return std::tie(start, target) < std::tie(other.start, other.target);
+      }
+    };
+
+    frc::Trajectory Path(frc::Pose2d start, frc::Pose2d target, const std::vector<frc::Translation2d> &interior, units::meters_per_second_t maxVelocity) const;
+    key_t Quantise(frc::Pose2d start, frc::Pose2d target) const;
+    frc::Pose2d Dequantise(int x, int y, int theta) const;
+    void Run();
+
+    HolonomicTrajectoryPlannerConfig _config;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::map<key_t, std::shared_ptr<HolonomicTrajectory>> _cache;
+    std::deque<key_t> _cacheOrder;
+    std::deque<key_t> _queue;
+    std::set<key_t> _pending;
+    // Bumped by ClearCache, so Run can tell its result was planned before it
+    uint64_t _generation = 0;
+    bool _running = true;
+
+    std::thread _worker;
+  };
+}
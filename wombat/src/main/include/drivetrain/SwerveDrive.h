@@ -7,13 +7,27 @@
 #include "VoltageController.h"
 #include <frc/interfaces/Gyro.h>
 #include "PID.h"
+#include "RingBuffer.h"
+#include "drivetrain/SwerveSetpointGenerator.h"
+#include "sim/Integrator.h"
 
 #include <units/angular_velocity.h>
 #include <units/charge.h>
+#include <units/current.h>
+#include <units/frequency.h>
 #include <units/moment_of_inertia.h>
+#include <units/voltage.h>
 
 #include <frc/kinematics/SwerveDriveKinematics.h>
-#include <frc/estimator/SwerveDrivePoseEstimator.h>
+#include <frc/kinematics/SwerveDriveOdometry.h>
+#include <networktables/NetworkTableEntry.h>
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 namespace wom {
   enum class SwerveModuleState {
@@ -29,6 +43,18 @@ namespace wom {
 
     units::meter_t wheelRadius;
 
+    /**
+     * Most voltage the drive motor is given either way. The setpoint generator
+     * keeps the module speeds under what this reaches.
+     */
+    units::volt_t maxDriveVoltage = 4_V;
+
+    /**
+     * Most current the drive motor is let draw, whatever the setpoint generator
+     * asks for.
+     */
+    units::ampere_t driveCurrentLimit = 75_A;
+
     void WriteNT(std::shared_ptr<nt::NetworkTable> table) const;
   };
 
@@ -44,11 +70,21 @@ namespace wom {
     void SetIdle();
     void SetPID(units::radian_t angle, units::meters_per_second_t speed, units::second_t dt);
   
-    void SetAccelerationLimit(units::meters_per_second_squared_t limit);
-
+    /**
+     * Fastest the module can be driven within maxDriveVoltage, unloaded.
+     */
+    units::meters_per_second_t MaxSpeed() const;
 
     // frc::SwerveModuleState GetState();
     frc::SwerveModulePosition GetPosition() const;
+    /**
+     * As GetPosition, but read from the hardware, bypassing the sensor sample.
+     */
+    frc::SwerveModulePosition ReadPosition() const;
+    /**
+     * The speed and angle the module is currently being driven towards.
+     */
+    frc::SwerveModuleState GetSetpoint() const;
 
     units::meters_per_second_t GetSpeed() const;
     units::meter_t GetDistance() const;
@@ -63,10 +99,9 @@ namespace wom {
     PIDController<units::meters_per_second, units::volt> _velocityPIDController;
 
     std::shared_ptr<nt::NetworkTable> _table;
-
-    units::meters_per_second_squared_t _currentAccelerationLimit = 6_mps / 1_s;
   };
 
+  template<size_t N>
   struct SwerveDriveConfig {
     using pose_angle_conf_t = PIDConfig<units::radian, units::radians_per_second>;
     using pose_position_conf_t = PIDConfig<units::meter, units::meters_per_second>;
@@ -76,7 +111,7 @@ namespace wom {
     SwerveModule::angle_pid_conf_t anglePID;
     SwerveModule::velocity_pid_conf_t velocityPID;
 
-    wpi::array<SwerveModuleConfig, 4> modules;
+    wpi::array<SwerveModuleConfig, N> modules;
 
     wom::Gyro *gyro;
 
@@ -88,6 +123,8 @@ namespace wom {
     wpi::array<double, 3> stateStdDevs{0.0, 0.0, 0.0};
     wpi::array<double, 3> visionMeasurementStdDevs{0.0, 0.0, 0.0};
 
+    SwerveSetpointConfig setpoint;
+
     void WriteNT(std::shared_ptr<nt::NetworkTable> table);
   };
 
@@ -119,9 +156,31 @@ namespace wom {
     frc::ChassisSpeeds ToChassisSpeeds(const units::radian_t robotHeading);
   };
 
+  struct TimestampedPose {
+    units::second_t timestamp{0};
+    /**
+     * The fused estimate, in the field frame
+     */
+    frc::Pose2d pose;
+    /**
+     * Raw wheel odometry, in the (drifting) odometry frame
+     */
+    frc::Pose2d odometry;
+  };
+
+  /**
+   * A swerve drivebase of N modules. Modules are held inline and per-module loops
+   * are unrolled at compile time.
+   *
+   * Implemented in SwerveDrive.cpp and instantiated there for N = 3 and N = 4.
+   */
+  template<size_t N>
   class SwerveDrive : public behaviour::HasBehaviour {
    public:
-    SwerveDrive(SwerveDriveConfig config, frc::Pose2d initialPose);
+    using config_t = SwerveDriveConfig<N>;
+
+    SwerveDrive(config_t config, frc::Pose2d initialPose);
+    ~SwerveDrive();
 
     void OnUpdate(units::second_t dt);
     void OnStart();
@@ -129,7 +188,11 @@ namespace wom {
     void SetIdle();
     void SetVelocity(frc::ChassisSpeeds speeds);
     void SetFieldRelativeVelocity(FieldRelativeSpeeds speeds);
-    void SetPose(frc::Pose2d pose);
+    /**
+     * Drive to a pose. The feedforward is added to the output of the pose PID
+     * loops, e.g. the velocity of a trajectory being followed.
+     */
+    void SetPose(frc::Pose2d pose, FieldRelativeSpeeds feedforward = {});
     bool IsAtSetPose();
     void SetIndividualTuning(int mod, units::radian_t angle, units::meters_per_second_t speed);
     void SetTuning(units::radian_t angle, units::meters_per_second_t speed);
@@ -140,23 +203,86 @@ namespace wom {
 
     void ResetPose(frc::Pose2d pose);
 
+    /**
+     * Get the latest pose estimate. Lock-free, so safe to call from any behaviour
+     * thread while the odometry thread is running.
+     */
     frc::Pose2d GetPose();
+    /**
+     * Get the estimated pose at a past time, interpolated between odometry updates.
+     * Vision corrections apply retroactively. Empty if the time is older than the
+     * pose history or the last ResetPose.
+     */
+    std::optional<frc::Pose2d> GetPoseAt(units::second_t timestamp);
+
+    /**
+     * Fuse a vision pose measured at the given (FPGA) timestamp. The correction is
+     * applied to the estimate as it was at that time, and odometry since then is
+     * replayed on top of it, so camera latency doesn't drag the estimate back.
+     * The pose must be in the same frame as ResetPose's, and measurements from
+     * before the last ResetPose are dropped.
+     */
     void AddVisionMeasurement(frc::Pose2d pose, units::second_t timestamp);
 
-    SwerveDriveConfig &GetConfig() { return _config; }
+    /**
+     * Update odometry from its own thread at the given rate rather than once per
+     * OnUpdate. The thread reads the encoders and gyro directly from the hardware
+     * at a real-time priority, so the estimate does not alias against the robot
+     * loop or stall when the loop overruns.
+     *
+     * The module encoders are asked to report at the same rate. The gyro's rate
+     * is set when it is constructed, and should match. Readings are stamped when
+     * they are read and repeated ones are skipped, so each pose is within a period
+     * of when it was measured.
+     */
+    void StartOdometryThread(units::hertz_t rate = 200_Hz);
+    void StopOdometryThread();
+    bool IsOdometryThreadRunning() const { return _odometryRunning; }
+
+    config_t &GetConfig() { return _config; }
 
    protected:
 
    private:
-    SwerveDriveConfig _config;
+    static std::array<SwerveModule, N> MakeModules(const config_t &config);
+    wpi::array<frc::SwerveModuleState, N> GetModuleSetpoints() const;
+    wpi::array<frc::SwerveModulePosition, N> GetModulePositions(bool live) const;
+    void UpdateOdometry(bool live);
+    // Both require _estimatorMutex to be held
+    std::optional<frc::Pose2d> GetOdometryAt(units::second_t timestamp);
+    void PushPose(units::second_t timestamp, frc::Pose2d odometry);
+
+    config_t _config;
     SwerveDriveState _state = SwerveDriveState::kIdle;
-    std::vector<SwerveModule> _modules;
+    std::array<SwerveModule, N> _modules;
 
     frc::ChassisSpeeds _target_speed;
     FieldRelativeSpeeds _target_fr_speeds;
-
-    frc::SwerveDriveKinematics<4> _kinematics;
-    frc::SwerveDrivePoseEstimator<4> _poseEstimator;
+    FieldRelativeSpeeds _pose_feedforward;
+
+    frc::SwerveDriveKinematics<N> _kinematics;
+    SwerveSetpointGenerator<N> _setpointGenerator;
+    frc::SwerveDriveOdometry<N> _odometry;
+    // Pose of the odometry frame in the field. Vision and ResetPose move this
+    // rather than the odometry, so the odometry history stays continuous.
+    frc::Pose2d _odometryOrigin;
+    // When ResetPose last moved the origin. Vision and history from before it are
+    // in the old frame, so are ignored.
+    units::second_t _resetTime{-std::numeric_limits<double>::infinity()};
+    // Per axis (x, y, theta) gain applied to vision corrections
+    std::array<double, 3> _visionK{0, 0, 0};
+
+    // Guards the odometry and its origin, which the odometry thread and robot loop share.
+    std::mutex _estimatorMutex;
+    // Written under _estimatorMutex, read lock-free by GetPose. Holds ~2.5s of
+    // history at the odometry thread rate, or ~10s at the robot loop rate.
+    RingBuffer<TimestampedPose, 512> _poseHistory;
+
+    std::thread _odometryThread;
+    std::atomic<bool> _odometryRunning{false};
+    // The last readings the odometry was updated with, under _estimatorMutex
+    frc::Rotation2d _lastHeading;
+    wpi::array<frc::SwerveModulePosition, N> _lastPositions{wpi::empty_array};
 
     PIDController<units::radian, units::radians_per_second> _anglePIDController;
     PIDController<units::meter, units::meters_per_second> _xPIDController;
@@ -169,36 +295,134 @@ namespace wom {
     units::meters_per_second_t _speed;
   };
 
+  extern template struct SwerveDriveConfig<3>;
+  extern template struct SwerveDriveConfig<4>;
+  extern template class SwerveDrive<3>;
+  extern template class SwerveDrive<4>;
+
   namespace sim {
+    struct SwerveDriveSimConfig {
+      Integrator integrator = Integrator::kRK4;
+
+      /**
+       * How far inside the integrator's stability limit each substep is kept.
+       * Larger values take more, smaller substeps.
+       */
+      double stiffnessSafety = 2;
+
+      /**
+       * Upper bound on the substep length regardless of stiffness, which bounds the
+       * error from the robot turning during a step.
+       */
+      units::second_t maxSubstep = 5_ms;
+
+      int maxSubsteps = 200;
+
+      /**
+       * Publish the simulated state to NetworkTables every Update. Turn off for
+       * batch runs where nobody is watching.
+       */
+      bool publishNT = true;
+
+      // Errors of the gyro's readings
+      SimGyroConfig gyro;
+    };
+
+    /**
+     * Simulates the drivetrain from the voltages applied to each module. Motor
+     * voltages are held over each call to Update, which is split into substeps
+     * from the stiffness of the motors so large steps stay stable.
+     */
+    template<size_t N>
     class SwerveDriveSim {
      public:
-      SwerveDriveSim(SwerveDriveConfig config, units::kilogram_square_meter_t moduleJ);
+      SwerveDriveSim(SwerveDriveConfig<N> config, units::kilogram_square_meter_t moduleJ, SwerveDriveSimConfig simConfig = {});
 
       void Update(units::second_t dt);
 
-      SwerveDriveConfig config;
-      frc::SwerveDriveKinematics<4> kinematics;
+      SwerveDriveConfig<N> config;
+      SwerveDriveSimConfig simConfig;
+      frc::SwerveDriveKinematics<N> kinematics;
       units::kilogram_square_meter_t moduleJ;
       std::shared_ptr<nt::NetworkTable> table;
 
-      std::vector<std::shared_ptr<SimCapableEncoder>> driveEncoders;
-      std::vector<std::shared_ptr<SimCapableEncoder>> turnEncoders;
+      std::array<std::shared_ptr<SimCapableEncoder>, N> driveEncoders;
+      std::array<std::shared_ptr<SimCapableEncoder>, N> turnEncoders;
       std::shared_ptr<SimCapableGyro> gyro;
 
+      /**
+       * Per module state, one entry per module, in SI units (m, rad, s, A).
+       */
+      using vector_t = Eigen::Matrix<double, N, 1>;
+
       units::ampere_t totalCurrent = 0_A;
-      wpi::array<units::ampere_t, 4> driveCurrents { 0_A, 0_A, 0_A, 0_A };
-      wpi::array<units::ampere_t, 4> turnCurrents { 0_A, 0_A, 0_A, 0_A };
-      wpi::array<units::radians_per_second_t, 4> turnSpeeds { 0_rad / 1_s, 0_rad / 1_s, 0_rad / 1_s, 0_rad / 1_s };
-      wpi::array<units::radians_per_second_t, 4> driveSpeeds { 0_rad / 1_s, 0_rad / 1_s, 0_rad / 1_s, 0_rad / 1_s };
-      wpi::array<units::meters_per_second_t, 4> driveVelocity { 0_mps, 0_mps, 0_mps, 0_mps };
-      wpi::array<units::radian_t, 4> turnAngles { 0_rad, 0_rad, 0_rad, 0_rad };
-      wpi::array<units::radian_t, 4> driveEncoderAngles { 0_rad, 0_rad, 0_rad, 0_rad };
+      vector_t driveCurrents = vector_t::Zero();
+      vector_t turnCurrents = vector_t::Zero();
+      vector_t turnSpeeds = vector_t::Zero();
+      vector_t driveSpeeds = vector_t::Zero();
+      vector_t driveVelocity = vector_t::Zero();
+      vector_t turnAngles = vector_t::Zero();
+      vector_t driveEncoderAngles = vector_t::Zero();
 
       units::radian_t angle{0};
       units::radians_per_second_t angularVelocity{0};
       units::meter_t x{0}, y{0};
       units::meters_per_second_t vx{0}, vy{0};
+
+      /**
+       * Tilt of the robot, as SimCapableGyro::SetPitch and SetRoll take it. Set from
+       * outside, e.g. by a model of what the robot is driving over.
+       */
+      units::radian_t pitch{0}, roll{0};
+
+      /**
+       * Force on the robot from outside the drivetrain, in N and the world frame,
+       * e.g. gravity on a slope. Held over each Update and shared between the
+       * modules along the direction each wheel rolls.
+       */
+      Eigen::Vector2d externalForce = Eigen::Vector2d::Zero();
+
+      /**
+       * The fastest decay rate of the module motors, in 1/s, used to pick the
+       * number of substeps.
+       */
+      double stiffness = 0;
+      int substeps = 1;
+
+     private:
+      // [ drive velocity, turn speed, drive angle, turn angle ] per module, then [ x, y, angle ]
+      using state_t = Eigen::Matrix<double, 4 * N + 3, 1>;
+
+      /**
+       * Motor constants of one motor per module, so currents and torques are
+       * computed for all modules at once.
+       */
+      struct MotorConstants {
+        vector_t invR;   // 1 / R
+        vector_t invKv;  // 1 / Kv
+        vector_t Kt;
+      };
+
+      state_t Derivative(const state_t &state, const vector_t &driveVoltages, const vector_t &turnVoltages) const;
+      Eigen::Vector3d ChassisSpeeds(const vector_t &velocity, const vector_t &turnAngle) const;
+      void Publish();
+
+      MotorConstants _drive, _turn;
+      SimGyroModel _gyroModel;
+      vector_t _wheelRadius;
+      units::kilogram_t _moduleMass;
+
+      // Least squares solution of module velocities -> [ vx, vy, omega ]
+      Eigen::Matrix<double, 3, 2 * N> _forwardKinematics;
+
+      struct {
+        nt::NetworkTableEntry vx, vy, angle, angularVelocity, x, y, totalCurrent, substeps;
+        std::array<nt::NetworkTableEntry, N> turnTorque;
+      } _entries;
     };
+
+    extern template class SwerveDriveSim<3>;
+    extern template class SwerveDriveSim<4>;
   }
 }
 
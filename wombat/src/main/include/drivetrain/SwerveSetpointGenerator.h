@@ -0,0 +1,182 @@
+#pragma once
+
+#include <frc/kinematics/ChassisSpeeds.h>
+#include <frc/kinematics/SwerveDriveKinematics.h>
+#include <frc/kinematics/SwerveModuleState.h>
+#include <units/acceleration.h>
+#include <units/angular_acceleration.h>
+#include <units/angular_velocity.h>
+#include <units/math.h>
+#include <units/time.h>
+#include <units/velocity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+namespace wom {
+  struct SwerveSetpointConfig {
+    /**
+     * Fastest any one module can be driven. Faster commands are scaled down across
+     * all modules together, preserving the direction of travel. SwerveDrive lowers
+     * this to what its modules can reach (SwerveModule::MaxSpeed).
+     */
+    units::meters_per_second_t maxModuleSpeed = 4.5_mps;
+    /**
+     * Maximum chassis linear acceleration.
+     */
+    units::meters_per_second_squared_t maxAcceleration = 6_mps_sq;
+    /**
+     * Maximum chassis angular acceleration.
+     */
+    units::radians_per_second_squared_t maxAngularAcceleration = 12_rad_per_s_sq;
+    /**
+     * Maximum rate any module can be steered.
+     */
+    units::radians_per_second_t maxSteeringRate = 720_deg_per_s;
+  };
+
+  /**
+   * Turns a desired chassis speed into module setpoints the drivebase can actually
+   * follow from its previous setpoints. Rather than limiting each module on its own,
+   * the whole chassis moves a fraction of the way from the previous speeds to the
+   * desired speeds, chosen as the largest fraction that keeps chassis acceleration
+   * and every module's steering rate within limits. Modules therefore stay consistent
+   * with each other (and with the kinematics) while limited.
+   *
+   * Each module takes whichever of its two equivalent headings (forwards, or reversed
+   * and driving backwards) is closer to its previous heading. Returned angles are
+   * continuous with the previous ones rather than wrapped, so they are never more
+   * than 90 degrees from the previous setpoint.
+   */
+  template<size_t N>
+  class SwerveSetpointGenerator {
+   public:
+    using states_t = wpi::array<frc::SwerveModuleState, N>;
+
+    SwerveSetpointGenerator(const frc::SwerveDriveKinematics<N> &kinematics, SwerveSetpointConfig config)
+      : _kinematics(kinematics), _config(config) { }
+
+    SwerveSetpointConfig &GetConfig() { return _config; }
+
+    /**
+     * @param previous The module setpoints last commanded
+     * @param desired The chassis speeds to move towards
+     * @param dt The time until the next call
+     */
+    states_t Generate(const states_t &previous, frc::ChassisSpeeds desired, units::second_t dt) const {
+      // Desaturate by scaling the whole chassis, then work back to the speeds that
+      // are actually achievable.
+      states_t desiredStates = _kinematics.ToSwerveModuleStates(desired);
+      frc::SwerveDriveKinematics<N>::DesaturateWheelSpeeds(&desiredStates, _config.maxModuleSpeed);
+      desired = _kinematics.ToChassisSpeeds(desiredStates);
+
+      frc::ChassisSpeeds from = _kinematics.ToChassisSpeeds(previous);
+
+      // Chassis acceleration limits the fraction directly
+      double s = 1.0;
+      auto dvx = desired.vx - from.vx, dvy = desired.vy - from.vy;
+      units::meters_per_second_t dv = units::math::sqrt(dvx * dvx + dvy * dvy);
+      if (dv > _config.maxAcceleration * dt)
+        s = std::min(s, (_config.maxAcceleration * dt / dv).value());
+
+      auto domega = units::math::abs(desired.omega - from.omega);
+      if (domega > _config.maxAngularAcceleration * dt)
+        s = std::min(s, (_config.maxAngularAcceleration * dt / domega).value());
+
+      // Steering rate isn't linear in the fraction, so bisect for it. A module that
+      // is already off its heading (e.g. after starting from rest) may need to steer
+      // further than the limit even if the chassis holds its speed, so that isn't
+      // held against the fraction.
+      wpi::array<units::radian_t, N> allowance = SteeringAllowance(previous, from, dt);
+      if (!IsSteerable(previous, allowance, Lerp(from, desired, s))) {
+        double lo = 0, hi = s;
+        for (int i = 0; i < 10; i++) {
+          double mid = (lo + hi) / 2.0;
+          if (IsSteerable(previous, allowance, Lerp(from, desired, mid)))
+            lo = mid;
+          else
+            hi = mid;
+        }
+        s = lo;
+      }
+
+      states_t target = _kinematics.ToSwerveModuleStates(Lerp(from, desired, s));
+      units::radian_t maxSteer = _config.maxSteeringRate * dt;
+
+      for (size_t i = 0; i < N; i++) {
+        units::radian_t prevAngle = previous[i].angle.Radians();
+
+        if (units::math::abs(target[i].speed) < kStoppedSpeed) {
+          // Nowhere to go, so don't steer
+          target[i] = frc::SwerveModuleState{ 0_mps, frc::Rotation2d{prevAngle} };
+          continue;
+        }
+
+        auto [speed, steer] = Optimise(target[i], prevAngle);
+        units::radian_t limited = units::math::max(units::math::min(steer, maxSteer), -maxSteer);
+
+        // Only a module that was stopped can still be off its heading here. Drive
+        // it by the component along its current heading while it turns.
+        speed *= units::math::cos(steer - limited).value();
+        target[i] = frc::SwerveModuleState{ speed, frc::Rotation2d{prevAngle + limited} };
+      }
+
+      return target;
+    }
+
+   private:
+    static constexpr units::meters_per_second_t kStoppedSpeed = 0.01_mps;
+
+    static frc::ChassisSpeeds Lerp(const frc::ChassisSpeeds &a, const frc::ChassisSpeeds &b, double s) {
+      return frc::ChassisSpeeds{
+        a.vx + (b.vx - a.vx) * s,
+        a.vy + (b.vy - a.vy) * s,
+        a.omega + (b.omega - a.omega) * s
+      };
+    }
+
+    /**
+     * Pick the heading (state's, or opposite with reversed speed) closest to the
+     * previous angle.
+     * @return The speed to drive at, and the steering change from the previous angle.
+     */
+    static std::pair<units::meters_per_second_t, units::radian_t> Optimise(const frc::SwerveModuleState &state, units::radian_t prevAngle) {
+      double steer = std::remainder((state.angle.Radians() - prevAngle).value(), 2 * std::numbers::pi);
+      units::meters_per_second_t speed = state.speed;
+      if (std::abs(steer) > std::numbers::pi / 2) {
+        steer = std::remainder(steer + std::numbers::pi, 2 * std::numbers::pi);
+        speed = -speed;
+      }
+      return { speed, units::radian_t{steer} };
+    }
+
+    units::radian_t GetSteer(const frc::SwerveModuleState &previous, const frc::SwerveModuleState &state) const {
+      // Stopped modules are free to turn to any heading
+      if (units::math::abs(previous.speed) < kStoppedSpeed || units::math::abs(state.speed) < kStoppedSpeed)
+        return 0_rad;
+      return units::math::abs(Optimise(state, previous.angle.Radians()).second);
+    }
+
+    wpi::array<units::radian_t, N> SteeringAllowance(const states_t &previous, const frc::ChassisSpeeds &from, units::second_t dt) const {
+      states_t states = _kinematics.ToSwerveModuleStates(from);
+      wpi::array<units::radian_t, N> allowance(wpi::empty_array);
+      for (size_t i = 0; i < N; i++)
+        allowance[i] = units::math::max(_config.maxSteeringRate * dt, GetSteer(previous[i], states[i]));
+      return allowance;
+    }
+
+    bool IsSteerable(const states_t &previous, const wpi::array<units::radian_t, N> &allowance, const frc::ChassisSpeeds &speeds) const {
+      states_t states = _kinematics.ToSwerveModuleStates(speeds);
+      for (size_t i = 0; i < N; i++) {
+        if (GetSteer(previous[i], states[i]) > allowance[i])
+          return false;
+      }
+      return true;
+    }
+
+    const frc::SwerveDriveKinematics<N> &_kinematics;
+    SwerveSetpointConfig _config;
+  };
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <cmath>
+
+namespace wom {
+namespace sim {
+  enum class Integrator {
+    /**
+     * Forward Euler. First order and the cheapest, but the least stable.
+     */
+    kEuler,
+    /**
+     * Semi-implicit (symplectic) Euler. Velocities are stepped first and the
+     * positions are stepped with the new velocities. First order, but does not
+     * gain energy on oscillators like forward Euler does.
+     */
+    kSemiImplicitEuler,
+    /**
+     * Classic fourth order Runge-Kutta. Four evaluations per step.
+     */
+    kRK4
+  };
+
+  /**
+   * The largest h * lambda for which the integrator is stable on x' = -lambda x.
+   */
+  constexpr double StabilityLimit(Integrator integrator) {
+    switch (integrator) {
+      case Integrator::kRK4:
+        return 2.785;
+      default:
+        return 2.0;
+    }
+  }
+
+  /**
+   * The number of equal substeps to split dt into so that each substep stays
+   * within 1 / safety of the integrator's stability limit, given the fastest
+   * decay rate (stiffness, in 1/s) of the system.
+   */
+  inline int Substeps(Integrator integrator, double stiffness, double dt, double safety, int maxSubsteps) {
+    double n = std::ceil(dt * stiffness * safety / StabilityLimit(integrator));
+    return std::clamp((int)n, 1, std::max(maxSubsteps, 1));
+  }
+
+  /**
+   * Advance x' = f(x) by one step of h. The state is laid out as
+   * [ velocities, positions ], with the first `velocities` entries being
+   * velocities. Only kSemiImplicitEuler uses the split.
+   */
+  template<int Rows, typename F>
+  Eigen::Matrix<double, Rows, 1> Step(Integrator integrator, F &&f, const Eigen::Matrix<double, Rows, 1> &x, double h, Eigen::Index velocities) {
+    using state_t = Eigen::Matrix<double, Rows, 1>;
+
+    switch (integrator) {
+      case Integrator::kEuler:
+        return x + h * f(x);
+
+      case Integrator::kSemiImplicitEuler: {
+        state_t next = x;
+        next.head(velocities) += h * f(x).head(velocities);
+        next.tail(x.size() - velocities) += h * f(next).tail(x.size() - velocities);
+        return next;
+      }
+
+      case Integrator::kRK4:
+      default: {
+        state_t k1 = f(x);
+        state_t k2 = f(state_t(x + h / 2 * k1));
+        state_t k3 = f(state_t(x + h / 2 * k2));
+        state_t k4 = f(state_t(x + h * k3));
+        return x + h / 6 * (k1 + 2 * k2 + 2 * k3 + k4);
+      }
+    }
+  }
+}
+}
@@ -1,12 +1,103 @@
 #pragma once
 
 #include <units/angle.h>
+#include <units/angular_velocity.h>
+#include <units/time.h>
+
+#include <cmath>
+#include <deque>
+#include <random>
 
 namespace wom {
 namespace sim {
   class SimCapableGyro {
    public:
     virtual void SetAngle(units::radian_t angle) = 0;
+    virtual void SetRate(units::radians_per_second_t rate) = 0;
+
+    /**
+     * Tilt of the robot, as the gyro reads it when mounted on the robot. Pitch is
+     * positive with the front down, roll positive with the left side up.
+     */
+    virtual void SetPitch(units::radian_t pitch) = 0;
+    virtual void SetRoll(units::radian_t roll) = 0;
+  };
+
+  /**
+   * Everything a gyro reads, in the gyro's convention (angle and rate CW+).
+   */
+  struct SimGyroReading {
+    units::radian_t angle{0};
+    units::radians_per_second_t rate{0};
+    units::radian_t pitch{0};
+    units::radian_t roll{0};
+  };
+
+  struct SimGyroConfig {
+    // Standard deviation of the white noise on each reading
+    units::degree_t angleNoise{0};
+    units::degrees_per_second_t rateNoise{0};
+    units::degree_t tiltNoise{0};
+
+    // Bias on the rate at startup, which integrates into the angle
+    units::degrees_per_second_t bias{0};
+    // Random walk of the bias, in deg/s per sqrt(s)
+    double biasDrift = 0;
+
+    // How old each reading is by the time the robot sees it
+    units::second_t latency{0};
+
+    unsigned int seed = 0;
+  };
+
+  /**
+   * Turns the true motion of the robot into what a real gyro reads: a drifting
+   * bias on the rate that accumulates in the angle, noise on every reading, and
+   * readings that arrive late. All zero (the default) is a perfect gyro.
+   */
+  class SimGyroModel {
+   public:
+    SimGyroModel(SimGyroConfig config = {}) : _config(config), _rng(config.seed), _bias(config.bias) {}
+
+    SimGyroReading Update(units::second_t dt, const SimGyroReading &truth) {
+      _time += dt;
+
+      _bias += units::degrees_per_second_t{Normal(_config.biasDrift * std::sqrt(dt.value()))};
+      _biasAngle += _bias * dt;
+
+      _history.push_back({ _time, SimGyroReading{
+        truth.angle + _biasAngle + units::degree_t{Normal(_config.angleNoise.value())},
+        truth.rate + _bias + units::degrees_per_second_t{Normal(_config.rateNoise.value())},
+        truth.pitch + units::degree_t{Normal(_config.tiltNoise.value())},
+        truth.roll + units::degree_t{Normal(_config.tiltNoise.value())}
+      }});
+
+      // The newest reading that is at least the latency old, or the oldest we have.
+      // Allow for rounding in the summed time, so a latency of whole steps is exact.
+      while (_history.size() > 1 && _history[1].time <= _time - _config.latency + 1_us)
+        _history.pop_front();
+      return _history.front().reading;
+    }
+
+    units::degrees_per_second_t GetBias() const { return _bias; }
+
+   private:
+    double Normal(double stddev) {
+      return stddev > 0 ? std::normal_distribution<double>{0, stddev}(_rng) : 0;
+    }
+
+    struct TimedReading {
+      units::second_t time;
+      SimGyroReading reading;
+    };
+
+    SimGyroConfig _config;
+    std::mt19937 _rng;
+
+    units::second_t _time{0};
+    units::degrees_per_second_t _bias;
+    units::degree_t _biasAngle{0};
+    std::deque<TimedReading> _history;
   };
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "Gyro.h"
+#include "sim/SimGyro.h"
+
+using namespace wom;
+using namespace wom::sim;
+
+TEST(GyroSim, NavXReadsSimChannels) {
+  NavX gyro;
+  auto sim = gyro.MakeSimGyro();
+  sim->SetAngle(90_deg);
+  sim->SetRate(45_deg / 1_s);
+  sim->SetPitch(5_deg);
+  sim->SetRoll(-3_deg);
+
+  EXPECT_NEAR(gyro.GetAngle(), 90, 0.01);
+  EXPECT_NEAR(gyro.GetRate(), 45, 0.01);
+  EXPECT_NEAR(gyro.GetPitch().convert<units::degree>().value(), 5, 0.01);
+  EXPECT_NEAR(gyro.GetRoll().convert<units::degree>().value(), -3, 0.01);
+}
+
+TEST(GyroSim, PerfectByDefault) {
+  SimGyroModel model;
+  SimGyroReading truth{ 1_rad, 2_rad / 1_s, 0.1_rad, -0.1_rad };
+  SimGyroReading reading = model.Update(20_ms, truth);
+
+  EXPECT_DOUBLE_EQ(reading.angle.value(), 1);
+  EXPECT_DOUBLE_EQ(reading.rate.value(), 2);
+  EXPECT_DOUBLE_EQ(reading.pitch.value(), 0.1);
+  EXPECT_DOUBLE_EQ(reading.roll.value(), -0.1);
+}
+
+TEST(GyroSim, Latency) {
+  SimGyroConfig config;
+  config.latency = 40_ms;
+  SimGyroModel model{config};
+
+  for (int i = 0; i < 10; i++) {
+    SimGyroReading reading = model.Update(20_ms, SimGyroReading{ units::radian_t{(double)i} });
+    // Two steps behind, once there's enough history
+    EXPECT_DOUBLE_EQ(reading.angle.value(), std::max(i - 2, 0));
+  }
+}
+
+TEST(GyroSim, BiasIntegratesIntoAngle) {
+  SimGyroConfig config;
+  config.bias = 1_deg / 1_s;
+  SimGyroModel model{config};
+
+  SimGyroReading reading;
+  for (int i = 0; i < 500; i++)
+    reading = model.Update(20_ms, SimGyroReading{});
+
+  EXPECT_NEAR(reading.rate.convert<units::degrees_per_second>().value(), 1, 1e-9);
+  EXPECT_NEAR(reading.angle.convert<units::degree>().value(), 10, 1e-6);
+}
+
+TEST(GyroSim, NoiseIsSeeded) {
+  SimGyroConfig config;
+  config.angleNoise = 1_deg;
+  config.biasDrift = 0.1;
+  config.seed = 42;
+  SimGyroModel a{config}, b{config};
+
+  double spread = 0;
+  for (int i = 0; i < 100; i++) {
+    SimGyroReading ra = a.Update(20_ms, SimGyroReading{});
+    SimGyroReading rb = b.Update(20_ms, SimGyroReading{});
+    EXPECT_DOUBLE_EQ(ra.angle.value(), rb.angle.value());
+    spread += std::abs(ra.angle.value());
+  }
+  EXPECT_GT(spread, 0);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "sim/Integrator.h"
+
+#include <cmath>
+
+using namespace wom::sim;
+
+using state_t = Eigen::Matrix<double, 2, 1>;
+
+// Undamped spring, [ velocity, position ]
+static state_t Spring(const state_t &x) {
+  return state_t{ -x(1), x(0) };
+}
+
+static double Energy(const state_t &x) {
+  return 0.5 * (x(0) * x(0) + x(1) * x(1));
+}
+
+static state_t Simulate(Integrator integrator, double h, int steps) {
+  state_t x{ 0, 1 };
+  for (int i = 0; i < steps; i++)
+    x = Step(integrator, Spring, x, h, 1);
+  return x;
+}
+
+TEST(Integrator, RK4Accurate) {
+  state_t x = Simulate(Integrator::kRK4, 0.1, 100);
+  EXPECT_NEAR(x(1), std::cos(10.0), 1e-4);
+  EXPECT_NEAR(x(0), -std::sin(10.0), 1e-4);
+}
+
+TEST(Integrator, EulerGainsEnergy) {
+  state_t x = Simulate(Integrator::kEuler, 0.1, 100);
+  EXPECT_GT(Energy(x), 1.5 * Energy(state_t{ 0, 1 }));
+}
+
+TEST(Integrator, SemiImplicitBounded) {
+  state_t x = Simulate(Integrator::kSemiImplicitEuler, 0.1, 1000);
+  EXPECT_NEAR(Energy(x), Energy(state_t{ 0, 1 }), 0.05);
+}
+
+TEST(Integrator, Substeps) {
+  // Decay of 100/s over 20ms is h * lambda = 2, right at the Euler limit
+  EXPECT_EQ(Substeps(Integrator::kEuler, 100, 0.02, 1, 64), 1);
+  EXPECT_EQ(Substeps(Integrator::kEuler, 100, 0.02, 2, 64), 2);
+  EXPECT_EQ(Substeps(Integrator::kRK4, 100, 0.02, 2, 64), 2);
+  EXPECT_EQ(Substeps(Integrator::kEuler, 1e6, 0.02, 2, 64), 64);
+  EXPECT_EQ(Substeps(Integrator::kEuler, 0, 0.02, 2, 64), 1);
+}
+
+TEST(Integrator, SubstepsStabiliseStiffDecay) {
+  auto decay = [](const Eigen::Matrix<double, 1, 1> &x) { return Eigen::Matrix<double, 1, 1>{ -500 * x(0) }; };
+  double dt = 0.1;
+
+  Eigen::Matrix<double, 1, 1> single{ 1 };
+  single = Step(Integrator::kEuler, decay, single, dt, 1);
+  EXPECT_GT(std::abs(single(0)), 1);
+
+  Eigen::Matrix<double, 1, 1> stepped{ 1 };
+  int n = Substeps(Integrator::kEuler, 500, dt, 2, 1000);
+  for (int i = 0; i < n; i++)
+    stepped = Step(Integrator::kEuler, decay, stepped, dt / n, 1);
+  EXPECT_LT(std::abs(stepped(0)), 1e-6);
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "ArmElevatorCSpace.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+using cspace_t = wom::ArmElevatorCSpace;
+
+static wom::ArmElevatorGeometry Geometry() {
+  wom::ArmElevatorGeometry geometry{
+    1_m, 0.03_m,
+    -90_deg, 270_deg,
+    0_m, 1.33_m
+  };
+  geometry.floor = 0.1_m;
+  geometry.ceiling = 1.83_m;
+  geometry.shapes.push_back(wom::CollisionShape::Box("bumpers", -0.45_m, 0.02_m, 0.45_m, 0.18_m));
+  geometry.shapes.push_back(wom::CollisionShape::Box("intake", 0.3_m, 0.18_m, 0.6_m, 0.5_m));
+  return geometry;
+}
+
+TEST(ArmElevatorCSpace, Collides) {
+  auto geometry = Geometry();
+  // Forward, clear of everything
+  EXPECT_FALSE(cspace_t::Collides(geometry, 0_deg, 1_m));
+  // Straight up past the ceiling
+  EXPECT_TRUE(cspace_t::Collides(geometry, 90_deg, 1_m));
+  // Down into the intake
+  EXPECT_TRUE(cspace_t::Collides(geometry, -60_deg, 1_m));
+  // Back and down, over the bumpers, until it's thickened into them
+  EXPECT_FALSE(cspace_t::Collides(geometry, 235_deg, 1_m));
+  EXPECT_TRUE(cspace_t::Collides(geometry, 235_deg, 1_m, 0.15_m));
+}
+
+TEST(ArmElevatorCSpace, PivotAboveFloor) {
+  // Measured from the floor: the floor and bumpers are, and the pivot is above
+  // them with the elevator at 0
+  wom::ArmElevatorGeometry geometry{
+    1_m, 0.03_m,
+    -90_deg, 270_deg,
+    0_m, 1.33_m,
+    0_m, 0.3_m
+  };
+  geometry.floor = 0.1_m;
+  geometry.ceiling = 1.83_m;
+  geometry.shapes.push_back(wom::CollisionShape::Box("bumpers", -0.45_m, 0_m, 0.45_m, 0.17_m));
+
+  // Low and level is fine, low and pointing down isn't
+  EXPECT_FALSE(cspace_t::Collides(geometry, 0_deg, 0.2_m));
+  EXPECT_TRUE(cspace_t::Collides(geometry, -90_deg, 0.2_m));
+
+  auto grid = cspace_t::Generate(geometry, 50, 50);
+  EXPECT_FALSE(grid.Get(grid.Discretise({ 0_deg, 0.2_m })));
+  // No row is blocked at every angle, so the whole elevator range is reachable
+  for (int y = 0; y < 50; y++) {
+    bool free = false;
+    for (int x = 0; x < 50; x++)
+      free |= !grid.Get({ x, y });
+    EXPECT_TRUE(free) << y;
+  }
+}
+
+TEST(ArmElevatorCSpace, ReproducesHandWrittenFill) {
+  // The robot's geometry until it is measured: the hand-written fill it replaced
+  // only kept the end of the arm between 0.1m and 6ft, with the pivot on the carriage
+  wom::ArmElevatorGeometry geometry{
+    1_m, 0_m,
+    -90_deg, 270_deg,
+    0_m, 1.33_m
+  };
+  geometry.floor = 0.1_m;
+  geometry.ceiling = 6_ft;
+
+  auto grid = cspace_t::Generate(geometry, 50, 50);
+
+  double dAngle = (geometry.maxAngle - geometry.minAngle).value() / 50;
+  double dHeight = (geometry.maxHeight - geometry.minHeight).value() / 50;
+  double margin = (2 * geometry.tolerance + 0.02_m).value();
+  double floor = geometry.floor->value(), ceiling = geometry.ceiling->value();
+  for (int y = 0; y < 50; y++) {
+    bool rowFree = false;
+    for (int x = 0; x < 50; x++) {
+      // Anywhere the old fill was occupied is occupied, and anywhere it was free
+      // with some room is free
+      bool occupied = false, clear = true;
+      for (int j = 0; j <= 10; j++) {
+        for (int i = 0; i <= 10; i++) {
+          double angle = geometry.minAngle.value() + dAngle * (x + i / 10.0);
+          double height = geometry.minHeight.value() + dHeight * (y + j / 10.0);
+          double tip = height + geometry.armLength.value() * std::sin(angle);
+          occupied |= !(tip >= floor && tip <= ceiling);
+          clear &= tip >= floor + margin && tip <= ceiling - margin;
+        }
+      }
+      if (occupied) {
+        EXPECT_TRUE(grid.Get({ x, y })) << x << ", " << y;
+      }
+      if (clear) {
+        EXPECT_FALSE(grid.Get({ x, y })) << x << ", " << y;
+      }
+      rowFree |= !grid.Get({ x, y });
+    }
+    // Including the bottom of the elevator's travel
+    EXPECT_TRUE(rowFree) << y;
+  }
+}
+
+TEST(ArmElevatorCSpace, ConservativeAndTight) {
+  auto geometry = Geometry();
+  auto grid = cspace_t::Generate(geometry, 60, 40);
+
+  double dAngle = (geometry.maxAngle - geometry.minAngle).value() / 60;
+  double dHeight = (geometry.maxHeight - geometry.minHeight).value() / 40;
+  size_t occupied = 0;
+  for (int y = 0; y < 40; y++) {
+    for (int x = 0; x < 60; x++) {
+      // Densely sample the cell: any collision must mark it occupied, and if
+      // everything is well clear it must be free
+      bool hit = false, near = false;
+      for (int j = 0; j <= 10; j++) {
+        for (int i = 0; i <= 10; i++) {
+          units::radian_t angle = geometry.minAngle + units::radian_t{dAngle * (x + i / 10.0)};
+          units::meter_t height = geometry.minHeight + units::meter_t{dHeight * (y + j / 10.0)};
+          hit |= cspace_t::Collides(geometry, angle, height);
+          near |= cspace_t::Collides(geometry, angle, height, 2 * geometry.tolerance + 0.02_m);
+        }
+      }
+      if (hit) {
+        EXPECT_TRUE(grid.Get({ x, y })) << x << ", " << y;
+      }
+      if (!near) {
+        EXPECT_FALSE(grid.Get({ x, y })) << x << ", " << y;
+      }
+      occupied += grid.Get({ x, y });
+    }
+  }
+  EXPECT_GT(occupied, 0);
+  EXPECT_LT(occupied, 60 * 40);
+}
+
+TEST(ArmElevatorCSpace, ThreadsAgree) {
+  auto geometry = Geometry();
+  auto one = cspace_t::Generate(geometry, 90, 70, 1);
+  auto many = cspace_t::Generate(geometry, 90, 70, 5);
+  EXPECT_TRUE(one.GetBits() == many.GetBits());
+}
+
+TEST(ArmElevatorCSpace, DiskCache) {
+  auto dir = std::filesystem::temp_directory_path() / "wombat_cspace_test";
+  std::filesystem::remove_all(dir);
+
+  auto geometry = Geometry();
+  std::string path = cspace_t::CachePath(geometry, 50, 50, dir.string());
+  EXPECT_FALSE(std::filesystem::exists(path));
+
+  auto generated = cspace_t::LoadOrGenerate(geometry, 50, 50, dir.string());
+  ASSERT_TRUE(std::filesystem::exists(path));
+  auto loaded = cspace_t::LoadOrGenerate(geometry, 50, 50, dir.string());
+  EXPECT_TRUE(generated.GetBits() == loaded.GetBits());
+  EXPECT_TRUE(cspace_t::Generate(geometry, 50, 50).GetBits() == loaded.GetBits());
+
+  // Any change to the geometry or resolution is a different file, names aren't
+  auto moved = geometry;
+  moved.shapes[1].vertices[0].x() += 0.01;
+  EXPECT_NE(cspace_t::Hash(moved, 50, 50), cspace_t::Hash(geometry, 50, 50));
+  EXPECT_NE(cspace_t::Hash(geometry, 50, 51), cspace_t::Hash(geometry, 50, 50));
+  auto renamed = geometry;
+  renamed.shapes[0].name = "frame";
+  EXPECT_EQ(cspace_t::Hash(renamed, 50, 50), cspace_t::Hash(geometry, 50, 50));
+
+  // A damaged file is regenerated
+  std::filesystem::resize_file(path, 10);
+  auto regenerated = cspace_t::LoadOrGenerate(geometry, 50, 50, dir.string());
+  EXPECT_TRUE(generated.GetBits() == regenerated.GetBits());
+  EXPECT_GT(std::filesystem::file_size(path), 10);
+
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "BitGrid.h"
+
+#include <random>
+
+using namespace wom;
+
+static BitGrid RandomBits(int cols, int rows, double density, unsigned int seed) {
+  std::mt19937 rng{seed};
+  std::bernoulli_distribution set{density};
+  BitGrid grid{cols, rows};
+  for (int y = 0; y < rows; y++)
+    for (int x = 0; x < cols; x++)
+      grid.Set(x, y, set(rng));
+  return grid;
+}
+
+TEST(BitGrid, GetSet) {
+  BitGrid grid{130, 3};
+  EXPECT_EQ(grid.Stride(), 3);
+
+  grid.Set(0, 0, true);
+  grid.Set(63, 1, true);
+  grid.Set(64, 1, true);
+  grid.Set(129, 2, true);
+  EXPECT_TRUE(grid.Get(0, 0));
+  EXPECT_TRUE(grid.Get(63, 1));
+  EXPECT_TRUE(grid.Get(64, 1));
+  EXPECT_TRUE(grid.Get(129, 2));
+  EXPECT_FALSE(grid.Get(1, 0));
+  EXPECT_EQ(grid.Count(), 4);
+
+  grid.Set(64, 1, false);
+  EXPECT_FALSE(grid.Get(64, 1));
+  EXPECT_EQ(grid.Count(), 3);
+}
+
+TEST(BitGrid, FillKeepsPaddingClear) {
+  BitGrid grid{70, 5};
+  grid.Fill(true);
+  EXPECT_EQ(grid.Count(), 70 * 5);
+
+  grid.Invert();
+  EXPECT_EQ(grid.Count(), 0);
+  grid.Invert();
+  EXPECT_EQ(grid.Count(), 70 * 5);
+}
+
+TEST(BitGrid, MatrixRoundTrip) {
+  Eigen::MatrixXi matrix{
+    { 1, 0, 0 },
+    { 0, 1, 1 },
+  };
+  BitGrid grid{matrix};
+  EXPECT_EQ(grid.Cols(), 3);
+  EXPECT_EQ(grid.Rows(), 2);
+  EXPECT_TRUE(grid.Get(0, 0));
+  EXPECT_TRUE(grid.Get(2, 1));
+  EXPECT_EQ(grid.ToMatrix(), matrix);
+}
+
+TEST(BitGrid, Scan) {
+  BitGrid grid{200, 1};
+  grid.Set(5, 0, true);
+  grid.Set(150, 0, true);
+
+  EXPECT_EQ(grid.NextSet(0, 0), 5);
+  EXPECT_EQ(grid.NextSet(0, 5), 5);
+  EXPECT_EQ(grid.NextSet(0, 6), 150);
+  EXPECT_EQ(grid.NextSet(0, 151), 200);
+
+  EXPECT_EQ(grid.NextClear(0, 5), 6);
+  grid.Fill(true);
+  EXPECT_EQ(grid.NextClear(0, 0), 200);
+}
+
+TEST(BitGrid, Union) {
+  BitGrid a = RandomBits(70, 20, 0.2, 1), b = RandomBits(70, 20, 0.2, 2);
+  BitGrid both = a;
+  both |= b;
+  for (int y = 0; y < 20; y++)
+    for (int x = 0; x < 70; x++)
+      EXPECT_EQ(both.Get(x, y), a.Get(x, y) || b.Get(x, y));
+
+  EXPECT_THROW(a |= BitGrid(10, 10), std::invalid_argument);
+}
+
+TEST(BitGrid, DilateMatchesBruteForce) {
+  for (auto [rx, ry] : { std::pair{ 0, 0 }, { 1, 0 }, { 0, 2 }, { 3, 2 }, { 7, 5 }, { 70, 1 } }) {
+    BitGrid grid = RandomBits(150, 40, 0.02, rx * 10 + ry);
+    BitGrid dilated = grid;
+    dilated.Dilate(rx, ry);
+
+    for (int y = 0; y < 40; y++) {
+      for (int x = 0; x < 150; x++) {
+        bool expected = false;
+        for (int dy = -ry; dy <= ry && !expected; dy++)
+          for (int dx = -rx; dx <= rx && !expected; dx++)
+            expected = x + dx >= 0 && x + dx < 150 && y + dy >= 0 && y + dy < 40 && grid.Get(x + dx, y + dy);
+        ASSERT_EQ(dilated.Get(x, y), expected) << "rx " << rx << " ry " << ry << " at " << x << ", " << y;
+      }
+    }
+  }
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
+#include "DStarLite.h"
+
+#include <random>
+
+using grid_t = wom::DiscretisedOccupancyGrid<units::radian, units::meter>;
+using planner_t = wom::DStarLite<units::radian, units::meter, units::second>;
+
+TEST(DStarLite, MatchesAStar) {
+  for (unsigned int seed = 0; seed < 5; seed++) {
+    grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, 30, 30 };
+    planner_t planner{ grid, 1_s / 180_deg, 1_s / 1_m };
+    planner.SetGoal({ 29, 29 });
+
+    std::mt19937 rng{ seed };
+    std::uniform_int_distribution<int> cell{ 0, 29 };
+    Eigen::Vector2i start{ 0, 0 };
+
+    for (int i = 0; i < 300; i++) {
+      // Toggle a few cells and move the start a little, keeping both ends clear
+      for (int t = 0; t < 5; t++) {
+        Eigen::Vector2i idx{ cell(rng), cell(rng) };
+        grid.Set(idx, !grid.Get(idx));
+      }
+      if (i % 10 == 0 && start.x() < 28)
+        start += Eigen::Vector2i{ 1, 1 };
+      grid.Set(start, false);
+      grid.Set({ 29, 29 }, false);
+
+      auto expected = grid.AStarStrict<units::second>(start, { 29, 29 }, 1_s / 180_deg, 1_s / 1_m);
+      auto path = planner.Plan(start);
+
+      ASSERT_EQ(path.empty(), expected.empty()) << "seed " << seed << " step " << i;
+      if (!path.empty()) {
+        EXPECT_EQ(grid.Discretise(path.front().position), start);
+        EXPECT_EQ(grid.Discretise(path.back().position), (Eigen::Vector2i{ 29, 29 }));
+        EXPECT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-9) << "seed " << seed << " step " << i;
+        for (auto &node : path)
+          EXPECT_FALSE(grid.Get(grid.Discretise(node.position)));
+      }
+    }
+  }
+}
+
+TEST(DStarLite, ReplanIsIncremental) {
+  std::mt19937 rng{ 3 };
+  std::bernoulli_distribution occupied{ 0.25 };
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, 100, 100 };
+  for (int y = 0; y < 100; y++)
+    for (int x = 0; x < 100; x++)
+      grid.Set({ x, y }, occupied(rng));
+  grid.Set({ 0, 0 }, false);
+  grid.Set({ 99, 99 }, false);
+
+  planner_t planner{ grid, 1_s / 180_deg, 1_s / 1_m };
+  planner.SetGoal({ 99, 99 });
+  ASSERT_FALSE(planner.Plan({ 0, 0 }).empty());
+
+  // Nothing changed, nothing to do
+  ASSERT_FALSE(planner.Plan({ 0, 0 }).empty());
+  EXPECT_EQ(planner.GetLastExpansions(), 0);
+
+  // Clear one cell at a time, and compare with planning from scratch each time
+  std::uniform_int_distribution<int> cell{ 0, 99 };
+  size_t incremental = 0, scratch = 0;
+  for (int i = 0; i < 50; i++) {
+    grid.Set({ cell(rng), cell(rng) }, false);
+    auto path = planner.Plan({ 0, 0 });
+    incremental += planner.GetLastExpansions();
+
+    auto expected = grid.AStarStrict<units::second>({ 0, 0 }, { 99, 99 }, 1_s / 180_deg, 1_s / 1_m);
+    scratch += grid.GetLastExpansions();
+    ASSERT_EQ(path.empty(), expected.empty());
+  }
+  EXPECT_LT(incremental, scratch / 4);
+}
+
+TEST(DStarLite, Blocked) {
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, 10, 10 };
+  planner_t planner{ grid, 1_s / 180_deg, 1_s / 1_m };
+
+  // No goal yet
+  EXPECT_TRUE(planner.Plan({ 0, 0 }).empty());
+
+  planner.SetGoal({ 9, 9 });
+  EXPECT_FALSE(planner.Plan({ 0, 0 }).empty());
+
+  for (int y = 0; y < 10; y++)
+    grid.Set({ 5, y }, true);
+  EXPECT_TRUE(planner.Plan({ 0, 0 }).empty());
+
+  grid.Set({ 5, 3 }, false);
+  EXPECT_FALSE(planner.Plan({ 0, 0 }).empty());
+
+  // Start in an obstacle
+  grid.Set({ 0, 0 }, true);
+  EXPECT_TRUE(planner.Plan({ 0, 0 }).empty());
+}
@@ -7,32 +7,330 @@
 #include "Grid.h"
 
 #include <iostream>
+#include <random>
+#include <string>
 
-// TEST(Grid, AStar) {
-//   Eigen::MatrixXi matrix{
-//     { 1, 1, 1, 1, 1, 1, 1 },
-//     { 1, 0, 1, 1, 0, 0, 0 },
-//     { 1, 0, 1, 1, 0, 1, 0 },
-//     { 1, 0, 1, 0, 0, 0, 0 },
-//     { 1, 0, 0, 0, 1, 0, 1 },
-//     { 1, 1, 1, 0, 0, 0, 1 },
-//     { 1, 1, 1, 1, 1, 1, 1 },
-//   };
-
-//   wom::DiscretisedOccupancyGrid<units::radian, units::meter> grid{ 180_deg, 1_m};
-//   grid.Load(matrix);
-
-//   auto q = grid.AStar<units::second>(
-//     { 1, 1 }, { 5, 1 },
-//     1_s / 180_deg, 1_s / 1_m
-//   );
-
-//   ASSERT_EQ(q.size(), 7);
-//   ASSERT_EQ(q.front(), (Eigen::Vector2i{1, 1})); q.pop_front();
-//   ASSERT_EQ(q.front(), (Eigen::Vector2i{1, 2})); q.pop_front();
-//   ASSERT_EQ(q.front(), (Eigen::Vector2i{1, 3})); q.pop_front();
-//   ASSERT_EQ(q.front(), (Eigen::Vector2i{2, 4})); q.pop_front();
-//   ASSERT_EQ(q.front(), (Eigen::Vector2i{3, 3})); q.pop_front();
-//   ASSERT_EQ(q.front(), (Eigen::Vector2i{4, 2})); q.pop_front();
-//   ASSERT_EQ(q.front(), (Eigen::Vector2i{5, 1}));
-// }
\ No newline at end of file
+using grid_t = wom::DiscretisedOccupancyGrid<units::radian, units::meter>;
+
+static Eigen::MatrixXi Maze() {
+  return Eigen::MatrixXi{
+    { 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 0, 1, 1, 0, 0, 0 },
+    { 1, 0, 1, 1, 0, 1, 0 },
+    { 1, 0, 1, 0, 0, 0, 0 },
+    { 1, 0, 0, 0, 1, 0, 1 },
+    { 1, 1, 1, 0, 0, 0, 1 },
+    { 1, 1, 1, 1, 1, 1, 1 },
+  };
+}
+
+static Eigen::MatrixXi RandomMatrix(int size, double density, unsigned int seed) {
+  std::mt19937 rng{seed};
+  std::bernoulli_distribution occupied{density};
+  Eigen::MatrixXi matrix(size, size);
+  for (int y = 0; y < size; y++)
+    for (int x = 0; x < size; x++)
+      matrix(y, x) = occupied(rng);
+  return matrix;
+}
+
+// Plain Dijkstra over the same 8-connected moves, to check A* against
+static double ReferenceCost(const Eigen::MatrixXi &matrix, Eigen::Vector2i start, Eigen::Vector2i end, double cx, double cy) {
+  int cols = matrix.cols(), rows = matrix.rows();
+  std::vector<double> dist(cols * rows, 1e18);
+  using entry = std::pair<double, int>;
+  std::priority_queue<entry, std::vector<entry>, std::greater<entry>> q;
+  dist[start.y() * cols + start.x()] = 0;
+  q.push({ 0, start.y() * cols + start.x() });
+  while (!q.empty()) {
+    auto [d, id] = q.top();
+    q.pop();
+    if (d > dist[id])
+      continue;
+    int x = id % cols, y = id / cols;
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        int nx = x + dx, ny = y + dy;
+        if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= cols || ny >= rows || matrix(ny, nx))
+          continue;
+        double nd = d + std::sqrt(dx * dx * cx * cx + dy * dy * cy * cy);
+        if (nd < dist[ny * cols + nx]) {
+          dist[ny * cols + nx] = nd;
+          q.push({ nd, ny * cols + nx });
+        }
+      }
+    }
+  }
+  return dist[end.y() * cols + end.x()];
+}
+
+TEST(Grid, AStar) {
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, Maze() };
+
+  auto q = grid.AStar<units::second>(
+    { 1, 1 }, { 5, 1 },
+    1_s / 180_deg, 1_s / 1_m
+  );
+
+  ASSERT_EQ(q.size(), 7);
+  ASSERT_EQ(grid.Discretise(q.front().position), (Eigen::Vector2i{1, 1})); q.pop_front();
+  ASSERT_EQ(grid.Discretise(q.front().position), (Eigen::Vector2i{1, 2})); q.pop_front();
+  ASSERT_EQ(grid.Discretise(q.front().position), (Eigen::Vector2i{1, 3})); q.pop_front();
+  ASSERT_EQ(grid.Discretise(q.front().position), (Eigen::Vector2i{2, 4})); q.pop_front();
+  ASSERT_EQ(grid.Discretise(q.front().position), (Eigen::Vector2i{3, 3})); q.pop_front();
+  ASSERT_EQ(grid.Discretise(q.front().position), (Eigen::Vector2i{4, 2})); q.pop_front();
+  ASSERT_EQ(grid.Discretise(q.front().position), (Eigen::Vector2i{5, 1}));
+}
+
+TEST(Grid, AStarStrictBlocked) {
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, Maze() };
+
+  // Start in an obstacle
+  EXPECT_TRUE(grid.AStarStrict<units::second>({ 0, 0 }, { 5, 1 }, 1_s / 180_deg, 1_s / 1_m).empty());
+
+  // No way through
+  Eigen::MatrixXi wall = Eigen::MatrixXi::Zero(5, 5);
+  wall.col(2).setOnes();
+  grid_t walled{ 0_deg, 180_deg, 0_m, 1_m, wall };
+  EXPECT_TRUE(walled.AStarStrict<units::second>({ 0, 0 }, { 4, 4 }, 1_s / 180_deg, 1_s / 1_m).empty());
+}
+
+TEST(Grid, AStarOptimal) {
+  for (unsigned int seed = 0; seed < 20; seed++) {
+    Eigen::MatrixXi matrix = RandomMatrix(40, 0.3, seed);
+    matrix(0, 0) = 0;
+    matrix(39, 39) = 0;
+    grid_t grid{ 0_deg, 180_deg, 0_m, 2_m, matrix };
+
+    auto path = grid.AStarStrict<units::second>({ 0, 0 }, { 39, 39 }, 1_s / 90_deg, 1_s / 1_m);
+    double reference = ReferenceCost(matrix, { 0, 0 }, { 39, 39 }, 2.0 / 40, 2.0 / 40);
+
+    if (reference > 1e17) {
+      EXPECT_TRUE(path.empty());
+    } else {
+      ASSERT_FALSE(path.empty());
+      EXPECT_NEAR(path.back().cost.value(), reference, 1e-9);
+    }
+  }
+}
+
+TEST(Grid, FillRowsFMatchesFillF) {
+  grid_t a{ 0_deg, 180_deg, 0_m, 2_m, 100, 70 }, b{ 0_deg, 180_deg, 0_m, 2_m, 100, 70 };
+
+  a.FillF([](units::radian_t x, units::meter_t y) { return x.value() + y.value() > 2.5; });
+  b.FillRowsF([](units::meter_t y, const Eigen::ArrayXd &xs) -> Eigen::Array<bool, Eigen::Dynamic, 1> {
+    return xs + y.value() > 2.5;
+  });
+
+  EXPECT_GT(a.GetBits().Count(), 0);
+  EXPECT_EQ(a.GetBits(), b.GetBits());
+}
+
+TEST(Grid, Dilate) {
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, 9, 9 };
+  grid.Set({ 4, 4 }, true);
+  grid.Dilate(1, 2);
+
+  EXPECT_EQ(grid.GetBits().Count(), 3 * 5);
+  EXPECT_TRUE(grid.Get({ 3, 2 }));
+  EXPECT_TRUE(grid.Get({ 5, 6 }));
+  EXPECT_FALSE(grid.Get({ 2, 4 }));
+  EXPECT_FALSE(grid.Get({ 4, 7 }));
+}
+
+TEST(Grid, ClosestValidNode) {
+  for (unsigned int seed = 0; seed < 10; seed++) {
+    Eigen::MatrixXi matrix = RandomMatrix(30, 0.6, seed);
+    grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, matrix };
+
+    for (int y = -3; y < 33; y++) {
+      for (int x = -3; x < 33; x++) {
+        Eigen::Vector2i clamped{ std::clamp(x, 0, 29), std::clamp(y, 0, 29) };
+        double best = 1e18;
+        for (int fy = 0; fy < 30; fy++)
+          for (int fx = 0; fx < 30; fx++)
+            if (!matrix(fy, fx))
+              best = std::min(best, (Eigen::Vector2i{ fx, fy } - clamped).cast<double>().norm());
+
+        Eigen::Vector2i closest = grid.GetClosestValidNode({ x, y });
+        ASSERT_FALSE(grid.Get(closest));
+        ASSERT_NEAR((closest - clamped).cast<double>().norm(), best, 1e-6) << x << ", " << y;
+      }
+    }
+  }
+}
+
+TEST(Grid, ClosestValidNodeTracksChanges) {
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, 10, 10 };
+  EXPECT_EQ(grid.GetClosestValidNode({ 5, 5 }), (Eigen::Vector2i{ 5, 5 }));
+
+  grid.Set({ 5, 5 }, true);
+  Eigen::Vector2i closest = grid.GetClosestValidNode({ 5, 5 });
+  EXPECT_EQ((closest - Eigen::Vector2i{ 5, 5 }).squaredNorm(), 1);
+
+  grid.Fill(true);
+  EXPECT_EQ(grid.GetClosestValidNode({ 12, -1 }), (Eigen::Vector2i{ 9, 0 }));
+}
+
+TEST(Grid, Clearance) {
+  Eigen::MatrixXi matrix = RandomMatrix(25, 0.1, 3);
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, matrix };
+
+  for (int y = 0; y < 25; y++) {
+    for (int x = 0; x < 25; x++) {
+      double expected = 0;
+      if (!matrix(y, x)) {
+        expected = std::min({ x + 1, y + 1, 25 - x, 25 - y });
+        for (int oy = 0; oy < 25; oy++)
+          for (int ox = 0; ox < 25; ox++)
+            if (matrix(oy, ox))
+              expected = std::min(expected, std::hypot(ox - x, oy - y));
+      }
+      ASSERT_NEAR(grid.GetClearance({ x, y }), expected, 1e-5) << x << ", " << y;
+    }
+  }
+}
+
+TEST(Grid, AStarClearanceCost) {
+  // A room with a pillar; the straight path hugs it, a clearance cost should push it away
+  Eigen::MatrixXi matrix = Eigen::MatrixXi::Zero(21, 21);
+  matrix.block(9, 9, 3, 3).setOnes();
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, matrix };
+
+  // Clearance where the path passes the pillar
+  auto passing = [&](auto path) {
+    for (auto &node : path)
+      if (grid.Discretise(node.position).x() == 10)
+        return grid.GetClearance(grid.Discretise(node.position));
+    return 0.0;
+  };
+
+  auto direct = grid.AStarStrict<units::second>({ 0, 10 }, { 20, 10 }, 1_s / 180_deg, 1_s / 1_m);
+  auto wide = grid.AStarStrict<units::second>({ 0, 10 }, { 20, 10 }, 1_s / 180_deg, 1_s / 1_m, 0.5_s);
+  ASSERT_FALSE(direct.empty());
+  ASSERT_FALSE(wide.empty());
+  EXPECT_DOUBLE_EQ(passing(direct), 1);
+  EXPECT_GT(passing(wide), 1);
+}
+
+TEST(Grid, LineOfSight) {
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, Maze() };
+
+  EXPECT_TRUE(grid.LineOfSight({ 1, 1 }, { 1, 3 }));
+  EXPECT_TRUE(grid.LineOfSight({ 3, 3 }, { 5, 3 }));
+  EXPECT_TRUE(grid.LineOfSight({ 4, 1 }, { 4, 1 }));
+  // Through the wall at x = 2
+  EXPECT_FALSE(grid.LineOfSight({ 1, 1 }, { 3, 3 }));
+  // Exactly through the corner between (4, 2) and (5, 3), and (5, 2) is a wall
+  EXPECT_FALSE(grid.LineOfSight({ 4, 3 }, { 6, 1 }));
+  // From an obstacle
+  EXPECT_FALSE(grid.LineOfSight({ 0, 0 }, { 1, 1 }));
+
+  // Agrees both ways round
+  Eigen::MatrixXi matrix = RandomMatrix(20, 0.2, 5);
+  grid_t random{ 0_deg, 180_deg, 0_m, 1_m, matrix };
+  for (int i = 0; i < 400; i++) {
+    Eigen::Vector2i a{ i % 20, (i * 7) % 20 }, b{ (i * 3) % 20, (i * 11) % 20 };
+    EXPECT_EQ(random.LineOfSight(a, b), random.LineOfSight(b, a));
+  }
+}
+
+TEST(Grid, JumpPointOptimal) {
+  for (unsigned int seed = 0; seed < 30; seed++) {
+    Eigen::MatrixXi matrix = RandomMatrix(40, 0.05 + 0.01 * seed, seed);
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<int> cell{ 0, 39 };
+    Eigen::Vector2i start{ cell(rng), cell(rng) }, end{ cell(rng), cell(rng) };
+    matrix(start.y(), start.x()) = 0;
+    matrix(end.y(), end.x()) = 0;
+    grid_t grid{ 0_deg, 180_deg, 0_m, 2_m, matrix };
+
+    auto path = grid.AStarStrict<units::second>(start, end, 1_s / 90_deg, 1_s / 1_m, 0_s, wom::GridSearch::kJumpPoint);
+    double reference = ReferenceCost(matrix, start, end, 2.0 / 40, 2.0 / 40);
+
+    if (reference > 1e17) {
+      EXPECT_TRUE(path.empty());
+      continue;
+    }
+    ASSERT_FALSE(path.empty());
+    EXPECT_NEAR(path.back().cost.value(), reference, 1e-9) << "seed " << seed;
+
+    // Filled in to single steps through free cells, like AStar's
+    EXPECT_EQ(grid.Discretise(path.front().position), start);
+    EXPECT_EQ(grid.Discretise(path.back().position), end);
+    for (size_t i = 0; i < path.size(); i++) {
+      Eigen::Vector2i idx = grid.Discretise(path[i].position);
+      EXPECT_FALSE(grid.Get(idx));
+      if (i > 0) {
+        Eigen::Vector2i move = idx - grid.Discretise(path[i - 1].position);
+        EXPECT_LE(move.cwiseAbs().maxCoeff(), 1);
+        EXPECT_GT(move.cwiseAbs().maxCoeff(), 0);
+      }
+    }
+  }
+}
+
+TEST(Grid, JumpPointFallsBack) {
+  Eigen::MatrixXi matrix = RandomMatrix(30, 0.2, 4);
+  matrix(0, 0) = 0;
+  matrix(29, 29) = 0;
+  grid_t grid{ 0_deg, 180_deg, 0_m, 1_m, matrix };
+
+  // Blocked ends and start == end behave as AStarStrict
+  EXPECT_TRUE(grid.AStarStrict<units::second>({ -1, 0 }, { 29, 29 }, 1_s / 180_deg, 1_s / 1_m, 0_s, wom::GridSearch::kJumpPoint).empty());
+  EXPECT_EQ(grid.AStarStrict<units::second>({ 0, 0 }, { 0, 0 }, 1_s / 180_deg, 1_s / 1_m, 0_s, wom::GridSearch::kJumpPoint).size(), 1);
+
+  // A clearance cost makes cells cost different amounts, so it's plain A*
+  auto astar = grid.AStarStrict<units::second>({ 0, 0 }, { 29, 29 }, 1_s / 180_deg, 1_s / 1_m, 0.1_s);
+  size_t expansions = grid.GetLastExpansions();
+  auto jps = grid.AStarStrict<units::second>({ 0, 0 }, { 29, 29 }, 1_s / 180_deg, 1_s / 1_m, 0.1_s, wom::GridSearch::kJumpPoint);
+  EXPECT_EQ(grid.GetLastExpansions(), expansions);
+  ASSERT_EQ(jps.size(), astar.size());
+  EXPECT_DOUBLE_EQ(jps.back().cost.value(), astar.back().cost.value());
+}
+
+// Both searches find the same cost on field and armavator shaped grids, jump point
+// search expanding fewer cells. Timings are in gridBenchmark.
+TEST(Grid, JumpPointExpandsLess) {
+  struct Case {
+    std::string name;
+    grid_t grid;
+    Eigen::Vector2i start, end;
+  };
+  std::vector<Case> cases;
+
+  // Half a field at 5 cm, with the charge station and grids to drive around
+  grid_t field{ 0_deg, 180_deg, 0_m, 8_m, 330, 160 };
+  for (int y = 40; y < 118; y++)
+    for (int x = 58; x < 98; x++)
+      field.Set({ x, y }, true);
+  for (int y = 0; y < 110; y++)
+    for (int x = 0; x < 28; x++)
+      field.Set({ x, y }, true);
+  cases.push_back({ "field", field, { 40, 20 }, { 300, 140 } });
+
+  // Armavator c-space with a band of blocked angles below the floor, at two resolutions
+  for (int cells : { 50, 200 }) {
+    grid_t armavator{ -90_deg, 270_deg, 0_m, 1.33_m, (size_t)cells, (size_t)cells };
+    armavator.FillF([](units::radian_t angle, units::meter_t height) {
+      double y = height.value() + std::sin(angle.value());
+      return !(y >= 0.1 && y <= 1.83);
+    });
+    cases.push_back({ "armavator " + std::to_string(cells), armavator, armavator.GetClosestValidNode({ cells / 8, cells / 2 }), armavator.GetClosestValidNode({ cells * 5 / 8, cells / 2 }) });
+  }
+
+  for (auto &c : cases) {
+    size_t expansions[2];
+    double costs[2];
+    int i = 0;
+    for (auto search : { wom::GridSearch::kAStar, wom::GridSearch::kJumpPoint }) {
+      auto path = c.grid.AStarStrict<units::second>(c.start, c.end, 1_s / 180_deg, 1_s / 1_m, 0_s, search);
+      expansions[i] = c.grid.GetLastExpansions();
+      ASSERT_FALSE(path.empty()) << c.name;
+      costs[i++] = path.back().cost.value();
+    }
+
+    EXPECT_NEAR(costs[1], costs[0], 1e-9) << c.name;
+    EXPECT_LT(expansions[1], expansions[0]) << c.name;
+  }
+}
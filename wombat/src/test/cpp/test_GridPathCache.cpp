@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
+#include "GridPathCache.h"
+
+#include <chrono>
+#include <thread>
+
+using grid_t = wom::DiscretisedOccupancyGrid<units::radian, units::meter>;
+using cache_t = wom::GridPathCache<units::radian, units::meter, units::second>;
+
+static grid_t Walled() {
+  grid_t grid{ 0_deg, 180_deg, 0_m, 2_m, 40, 40 };
+  for (int y = 5; y < 40; y++)
+    grid.Set({ 20, y }, true);
+  return grid;
+}
+
+static bool WaitReady(cache_t &cache) {
+  for (int i = 0; i < 500 && !cache.IsReady(); i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  return cache.IsReady();
+}
+
+TEST(GridPathCache, MatchesAStar) {
+  grid_t grid = Walled();
+  std::vector<Eigen::Vector2i> presets{ { 2, 30 }, { 35, 35 }, { 10, 2 }, { 30, 10 }, { 20, 20 } };
+
+  cache_t cache{ 1_s / 180_deg, 1_s / 1_m };
+  for (auto &preset : presets)
+    cache.AddPreset(preset);
+  cache.Build(grid);
+  ASSERT_TRUE(cache.IsReady());
+
+  size_t moves = 0;
+  for (int i = 0; i < (int)presets.size(); i++) {
+    for (int j = 0; j < (int)presets.size(); j++) {
+      auto expected = grid.AStar<units::second>(presets[i], presets[j], 1_s / 180_deg, 1_s / 1_m);
+      auto path = cache.Get(i, j);
+      ASSERT_TRUE(path.has_value()) << i << " -> " << j;
+      ASSERT_EQ(path->size(), expected.size());
+      moves += path->size() - 1;
+      EXPECT_EQ(grid.Discretise(path->front().position), grid.Discretise(expected.front().position));
+      EXPECT_EQ(grid.Discretise(path->back().position), grid.Discretise(expected.back().position));
+      EXPECT_NEAR(path->back().cost.value(), expected.back().cost.value(), 1e-9);
+      EXPECT_NEAR(cache.Cost(i, j)->value(), expected.back().cost.value(), 1e-9);
+      for (auto &node : *path)
+        EXPECT_FALSE(grid.Get(grid.Discretise(node.position)));
+    }
+  }
+
+  // Two moves to a byte
+  EXPECT_EQ(cache.GetEncodedSize(), (moves + 1) / 2);
+  EXPECT_EQ(cache.FindPreset({ 30, 10 }), 3);
+  EXPECT_EQ(cache.FindPreset({ 0, 0 }), -1);
+  EXPECT_FALSE(cache.Get(0, 5).has_value());
+}
+
+TEST(GridPathCache, RebuildsWhenGridChanges) {
+  grid_t grid = Walled();
+  cache_t cache{ 1_s / 180_deg, 1_s / 1_m };
+  int a = cache.AddPreset({ 2, 30 }), b = cache.AddPreset({ 35, 35 });
+
+  cache.Update(grid);
+  ASSERT_TRUE(WaitReady(cache));
+  auto before = cache.Cost(a, b);
+  ASSERT_TRUE(before.has_value());
+
+  // Nothing changed, the table stays
+  cache.Update(grid);
+  EXPECT_TRUE(cache.IsReady());
+
+  // Close the gap in the wall
+  for (int y = 0; y < 5; y++)
+    grid.Set({ 20, y }, true);
+  cache.Update(grid);
+  ASSERT_TRUE(WaitReady(cache));
+  EXPECT_FALSE(cache.Get(a, b).has_value());
+
+  // Open it elsewhere, shorter
+  grid.Set({ 20, 33 }, false);
+  cache.Update(grid);
+  ASSERT_TRUE(WaitReady(cache));
+  ASSERT_TRUE(cache.Cost(a, b).has_value());
+  EXPECT_LT(cache.Cost(a, b)->value(), before->value());
+}
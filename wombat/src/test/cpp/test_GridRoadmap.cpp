@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <units/length.h>
+#include <units/time.h>
+
+#include "GridRoadmap.h"
+
+#include <random>
+
+using grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter>;
+using roadmap_t = wom::GridRoadmap<units::meter, units::meter, units::second>;
+
+// Half a field at 5 cm, with boxes to drive around, already inflated
+static grid_t Field() {
+  grid_t grid{ 0_m, 16.5_m, 0_m, 8_m, 330, 160 };
+  auto box = [&](int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++)
+      for (int x = x0; x < x1; x++)
+        grid.Set({ x, y }, true);
+  };
+  box(0, 0, 38, 120);
+  box(50, 20, 108, 88);
+  box(0, 100, 78, 112);
+  box(210, 40, 240, 160);
+  box(150, 0, 170, 100);
+  return grid;
+}
+
+static std::vector<Eigen::Vector2i> Targets() {
+  return { { 40, 10 }, { 40, 50 }, { 40, 90 }, { 45, 130 }, { 300, 20 }, { 60, 60 } };
+}
+
+static double RouteCost(roadmap_t &roadmap, const std::vector<Eigen::Vector2i> &route) {
+  double cost = 0;
+  for (size_t i = 1; i < route.size(); i++)
+    cost += roadmap.Straight(route[i - 1], route[i]);
+  return cost;
+}
+
+TEST(GridRoadmap, RoutesAreClear) {
+  grid_t grid = Field();
+  auto targets = Targets();
+  roadmap_t roadmap{ grid, targets, 0.5_s / 1_m, 0.5_s / 1_m };
+  EXPECT_GT(roadmap.GetNodeCount(), targets.size());
+  EXPECT_GT(roadmap.GetEdgeCount(), roadmap.GetNodeCount());
+
+  std::mt19937 rng{ 2 };
+  std::uniform_int_distribution<int> x{ 0, 329 }, y{ 0, 159 };
+  for (int i = 0; i < 300; i++) {
+    Eigen::Vector2i from{ x(rng), y(rng) };
+    for (int t = 0; t < (int)targets.size(); t++) {
+      auto route = roadmap.Route(from, t);
+      Eigen::Vector2i start = grid.GetClosestValidNode(from), goal = grid.GetClosestValidNode(targets[t]);
+      auto path = grid.AStarStrict<units::second>(start, goal, 0.5_s / 1_m, 0.5_s / 1_m);
+
+      ASSERT_EQ(route.empty(), path.empty()) << from.transpose() << " -> " << t;
+      if (route.empty())
+        continue;
+      EXPECT_EQ(route.front(), start);
+      EXPECT_EQ(route.back(), goal);
+      for (size_t j = 1; j < route.size(); j++)
+        EXPECT_TRUE(grid.LineOfSight(route[j - 1], route[j]));
+
+      // Straight lines between corners do at least as well as stepping cell to cell,
+      // give or take the spacing of the roadmap
+      EXPECT_LT(RouteCost(roadmap, route), path.back().cost.value() * 1.05 + 0.1);
+
+      auto cost = roadmap.Cost(from, t);
+      if (cost.has_value()) {
+        EXPECT_GE(cost->value(), RouteCost(roadmap, route) - 1e-9);
+      }
+    }
+  }
+}
+
+TEST(GridRoadmap, Unreachable) {
+  grid_t grid = Field();
+  // Wall off the top right
+  for (int y = 0; y < 160; y++)
+    grid.Set({ 280, y }, true);
+  roadmap_t roadmap{ grid, Targets(), 0.5_s / 1_m, 0.5_s / 1_m };
+
+  EXPECT_TRUE(roadmap.Route({ 100, 150 }, 4).empty());
+  EXPECT_FALSE(roadmap.Cost({ 100, 150 }, 4).has_value());
+  EXPECT_FALSE(roadmap.Route({ 320, 150 }, 4).empty());
+  EXPECT_TRUE(roadmap.Route({ 100, 150 }, 10).empty());
+
+  // From inside an obstacle, starts from the nearest free cell
+  auto route = roadmap.Route({ 60, 50 }, 1);
+  ASSERT_FALSE(route.empty());
+  EXPECT_FALSE(grid.Get(route.front()));
+}
+
+TEST(GridRoadmap, NotATarget) {
+  grid_t grid = Field();
+  roadmap_t roadmap{ grid, Targets(), 0.5_s / 1_m, 0.5_s / 1_m };
+  EXPECT_EQ(roadmap.FindTarget({ 300, 20 }), 4);
+  EXPECT_EQ(roadmap.FindTarget({ 301, 20 }), -1);
+
+  // Searches the grid instead
+  auto route = roadmap.Route(Eigen::Vector2i{ 200, 20 }, Eigen::Vector2i{ 250, 150 });
+  ASSERT_GE(route.size(), 2);
+  EXPECT_EQ(route.front(), (Eigen::Vector2i{ 200, 20 }));
+  EXPECT_EQ(route.back(), (Eigen::Vector2i{ 250, 150 }));
+  // Where the search cut a corner diagonally, that step stays
+  for (size_t j = 1; j < route.size(); j++)
+    EXPECT_TRUE(grid.LineOfSight(route[j - 1], route[j]) || (route[j] - route[j - 1]).cwiseAbs().maxCoeff() == 1);
+}
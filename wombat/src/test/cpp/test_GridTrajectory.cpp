@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <units/angle.h>
+#include <units/angular_velocity.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <units/velocity.h>
+
+#include "GridTrajectory.h"
+
+using grid_t = wom::DiscretisedOccupancyGrid<units::radian, units::meter>;
+using trajectory_t = wom::GridTrajectory<units::radian, units::meter>;
+
+static trajectory_t::Limits Limits() {
+  return trajectory_t::Limits{
+    trajectory_t::x_speed_t{2},  // rad/s
+    trajectory_t::y_speed_t{1},  // m/s
+    trajectory_t::x_accel_t{8},  // rad/s^2
+    trajectory_t::y_accel_t{4}   // m/s^2
+  };
+}
+
+// A wall across the middle with a gap at the top
+static grid_t Walled() {
+  grid_t grid{ 0_rad, 4_rad, 0_m, 2_m, 40, 40 };
+  for (int y = 0; y < 32; y++)
+    for (int x = 18; x < 22; x++)
+      grid.Set({ x, y }, true);
+  return grid;
+}
+
+TEST(GridTrajectory, ShortcutOpenGrid) {
+  grid_t grid{ 0_rad, 4_rad, 0_m, 2_m, 40, 40 };
+  auto path = grid.AStar<units::second>({ 2, 5 }, { 35, 30 }, 1_s / 1_rad, 1_s / 1_m);
+  ASSERT_GT(path.size(), 2);
+
+  std::vector<Eigen::Vector2i> cells;
+  for (auto &node : path)
+    cells.push_back(grid.Discretise(node.position));
+  auto kept = trajectory_t::Shortcut(grid, cells);
+  ASSERT_EQ(kept.size(), 2);
+  EXPECT_EQ(kept.front(), (Eigen::Vector2i{ 2, 5 }));
+  EXPECT_EQ(kept.back(), (Eigen::Vector2i{ 35, 30 }));
+}
+
+TEST(GridTrajectory, StraightLineTime) {
+  // 3 rad along x only: accelerate at 8 rad/s^2 to 2 rad/s, cruise, decelerate
+  grid_t grid{ 0_rad, 4_rad, 0_m, 2_m, 40, 40 };
+  auto trajectory = trajectory_t::FromCells(grid, { { 5, 10 }, { 35, 10 } }, Limits());
+
+  double distance = 3, v = 2, a = 8;
+  double expected = distance / v + v / a;
+  EXPECT_NEAR(trajectory.Duration().value(), expected, expected * 0.03);
+
+  EXPECT_NEAR(trajectory.Sample(0_s).x.value(), 0.55, 1e-9);
+  EXPECT_NEAR(trajectory.Sample(trajectory.Duration()).x.value(), 3.55, 1e-9);
+  EXPECT_NEAR(trajectory.Sample(trajectory.Duration() / 2).xSpeed.value(), 2, 1e-6);
+  EXPECT_NEAR(trajectory.Sample(trajectory.Duration() / 2).ySpeed.value(), 0, 1e-6);
+}
+
+TEST(GridTrajectory, AroundWall) {
+  grid_t grid = Walled();
+  auto path = grid.AStar<units::second>({ 5, 5 }, { 35, 5 }, 1_s / 2_rad, 1_s / 1_m);
+  ASSERT_FALSE(path.empty());
+
+  trajectory_t::Limits limits = Limits();
+  auto trajectory = trajectory_t::FromPath<units::second>(grid, path, limits);
+  ASSERT_FALSE(trajectory.Empty());
+
+  // The A* cost is the time to step cell to cell at full speed with no time to
+  // accelerate, the shortcuts should make up for most of that
+  EXPECT_LT(trajectory.Duration().value(), path.back().cost.value() * 1.1);
+
+  const auto &states = trajectory.GetStates();
+  EXPECT_EQ(states.front().xSpeed.value(), 0);
+  EXPECT_EQ(states.back().xSpeed.value(), 0);
+  for (size_t i = 0; i < states.size(); i++) {
+    EXPECT_FALSE(grid.Get(grid.Discretise({ states[i].x, states[i].y })));
+    EXPECT_LE(std::abs(states[i].xSpeed.value()), limits.xSpeed.value() + 1e-9);
+    EXPECT_LE(std::abs(states[i].ySpeed.value()), limits.ySpeed.value() + 1e-9);
+
+    if (i > 0) {
+      // Sampled motion is continuous
+      double dt = (states[i].time - states[i - 1].time).value();
+      ASSERT_GT(dt, 0);
+      EXPECT_LE(std::abs((states[i].x - states[i - 1].x).value()), limits.xSpeed.value() * dt * 1.01 + 1e-9);
+      EXPECT_LE(std::abs((states[i].y - states[i - 1].y).value()), limits.ySpeed.value() * dt * 1.01 + 1e-9);
+      EXPECT_LE(std::abs((states[i].xSpeed - states[i - 1].xSpeed).value()), limits.xAccel.value() * dt * 1.01 + 1e-9);
+      EXPECT_LE(std::abs((states[i].ySpeed - states[i - 1].ySpeed).value()), limits.yAccel.value() * dt * 1.01 + 1e-9);
+    }
+  }
+
+  EXPECT_EQ(grid.Discretise({ states.back().x, states.back().y }), (Eigen::Vector2i{ 35, 5 }));
+}
+
+TEST(GridTrajectory, Empty) {
+  grid_t grid = Walled();
+  auto trajectory = trajectory_t::FromCells(grid, {}, Limits());
+  EXPECT_TRUE(trajectory.Empty());
+  EXPECT_EQ(trajectory.Duration().value(), 0);
+
+  auto single = trajectory_t::FromCells(grid, { { 3, 3 } }, Limits());
+  EXPECT_EQ(single.GetStates().size(), 1);
+  EXPECT_EQ(single.Duration().value(), 0);
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "drivetrain/HolonomicTrajectory.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace wom;
+
+static std::string WriteTrajectory(std::string name, std::vector<HolonomicTrajectory::FileSample> samples, float dt) {
+  std::string path = name + ".traj";
+  std::ofstream out{path, std::ios::binary};
+  HolonomicTrajectory::FileHeader header{ {'W', 'T', 'R', 'J'}, HolonomicTrajectory::kVersion, (uint32_t)samples.size(), dt };
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(samples.data()), samples.size() * sizeof(HolonomicTrajectory::FileSample));
+  return path;
+}
+
+TEST(HolonomicTrajectory, SamplesAndInterpolates) {
+  std::string path = WriteTrajectory("test_traj_line", {
+    { 0, 0, 0, 0, 0, 0, 1, 0, 0 },
+    { 0.5, 0, 0.1, 1, 0, 1, 1, 0, 0 },
+    { 2, 0, 0.2, 2, 0, 1, 0, 0, 0 }
+  }, 0.5);
+
+  auto traj = HolonomicTrajectory::Load(path);
+  ASSERT_NE(traj, nullptr);
+  EXPECT_EQ(traj->Size(), 3);
+  EXPECT_DOUBLE_EQ(traj->GetDuration().value(), 1.0);
+
+  auto sample = traj->Sample(0.25_s);
+  EXPECT_NEAR(sample.pose.X().value(), 0.25, 1e-6);
+  EXPECT_NEAR(sample.pose.Rotation().Radians().value(), 0.05, 1e-6);
+  EXPECT_NEAR(sample.velocity.vx.value(), 0.5, 1e-6);
+  EXPECT_NEAR(sample.velocity.omega.value(), 0.5, 1e-6);
+
+  // Clamped to the ends
+  EXPECT_NEAR(traj->Sample(-1_s).pose.X().value(), 0, 1e-6);
+  EXPECT_NEAR(traj->Sample(10_s).pose.X().value(), 2, 1e-6);
+  EXPECT_NEAR(traj->GetFinalPose().X().value(), 2, 1e-6);
+
+  std::remove(path.c_str());
+}
+
+TEST(HolonomicTrajectory, RejectsMalformed) {
+  EXPECT_EQ(HolonomicTrajectory::Load("does_not_exist.traj"), nullptr);
+
+  std::string path = "test_traj_truncated.traj";
+  {
+    std::ofstream out{path, std::ios::binary};
+    HolonomicTrajectory::FileHeader header{ {'W', 'T', 'R', 'J'}, HolonomicTrajectory::kVersion, 100, 0.02f };
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+  EXPECT_EQ(HolonomicTrajectory::Load(path), nullptr);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "drivetrain/HolonomicTrajectoryPlanner.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace wom;
+
+TEST(HolonomicTrajectoryPlanner, GeneratesBetweenPoses) {
+  HolonomicTrajectoryPlanner planner;
+  auto traj = planner.Generate(frc::Pose2d{0_m, 0_m, 0_deg}, frc::Pose2d{2_m, 1_m, 90_deg});
+
+  EXPECT_NEAR(traj->GetInitialPose().X().value(), 0, 1e-3);
+  EXPECT_NEAR(traj->GetFinalPose().X().value(), 2, 1e-3);
+  EXPECT_NEAR(traj->GetFinalPose().Y().value(), 1, 1e-3);
+  EXPECT_NEAR(traj->GetFinalPose().Rotation().Degrees().value(), 90, 1e-3);
+
+  for (units::second_t t = 0_s; t < traj->GetDuration(); t += 20_ms) {
+    auto sample = traj->Sample(t);
+    EXPECT_LE(units::math::hypot(sample.velocity.vx, sample.velocity.vy).value(), 1.5 + 1e-3);
+  }
+}
+
+TEST(HolonomicTrajectoryPlanner, CachesQuantisedRequests) {
+  HolonomicTrajectoryPlanner planner;
+  frc::Pose2d target{3_m, 0_m, 0_deg};
+
+  std::shared_ptr<HolonomicTrajectory> traj;
+  for (int i = 0; i < 200 && traj == nullptr; i++) {
+    traj = planner.Request(frc::Pose2d{0_m, 0_m, 0_deg}, target);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_NE(traj, nullptr);
+
+  // Within the same cell, so served from the cache straight away
+  EXPECT_EQ(planner.Request(frc::Pose2d{2_cm, -1_cm, 1_deg}, target), traj);
+  EXPECT_EQ(planner.GetCacheSize(), 1);
+
+  // A different cell is queued
+  EXPECT_EQ(planner.Request(frc::Pose2d{1_m, 0_m, 0_deg}, target), nullptr);
+}
+
+TEST(HolonomicTrajectoryPlanner, EndsOnExactTarget) {
+  HolonomicTrajectoryPlanner planner;
+  // Off the quantum grid in every axis
+  frc::Pose2d target{2.03_m, 0.47_m, 216_deg};
+
+  std::shared_ptr<HolonomicTrajectory> traj;
+  for (int i = 0; i < 200 && traj == nullptr; i++) {
+    traj = planner.Request(frc::Pose2d{0_m, 0_m, 0_deg}, target);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_NE(traj, nullptr);
+
+  EXPECT_NEAR(traj->GetFinalPose().X().value(), 2.03, 1e-3);
+  EXPECT_NEAR(traj->GetFinalPose().Y().value(), 0.47, 1e-3);
+  EXPECT_NEAR(traj->GetFinalPose().Rotation().Degrees().value(), -144, 1e-3);
+}
+
+TEST(HolonomicTrajectoryPlanner, ClearCacheDropsQueued) {
+  HolonomicTrajectoryPlanner planner;
+  frc::Pose2d target{3_m, 0_m, 0_deg};
+  for (int i = 0; i < 20; i++)
+    planner.Request(frc::Pose2d{units::meter_t{i * 0.5}, 1_m, 0_deg}, target);
+  planner.ClearCache();
+
+  // Whatever was queued or in flight never lands in the cache
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  EXPECT_EQ(planner.GetCacheSize(), 0);
+}
+
+TEST(HolonomicTrajectoryPlanner, LimitsRotation) {
+  HolonomicTrajectoryPlannerConfig config;
+  config.moduleRadius = 0.7_m;
+  HolonomicTrajectoryPlanner planner{config};
+
+  // A short drive with a half turn, so turning sets the duration
+  for (frc::Translation2d end : { frc::Translation2d{0.5_m, 0_m}, frc::Translation2d{0_m, 0_m} }) {
+    auto traj = planner.Generate(frc::Pose2d{0_m, 0_m, 0_deg}, frc::Pose2d{end, 180_deg});
+    EXPECT_NEAR(std::abs(traj->GetFinalPose().Rotation().Degrees().value()), 180, 1e-3);
+
+    for (units::second_t t = 0_s; t <= traj->GetDuration(); t += 20_ms) {
+      auto sample = traj->Sample(t);
+      double omega = std::abs(sample.velocity.omega.value());
+      EXPECT_LE(omega, config.maxAngularVelocity.value() + 1e-3);
+      EXPECT_LE(std::abs(sample.alpha.value()), config.maxAngularAcceleration.value() + 1e-3);
+
+      // No module faster than the limit, with translation and turning together
+      double speed = units::math::hypot(sample.velocity.vx, sample.velocity.vy).value();
+      EXPECT_LE(speed + omega * config.moduleRadius.value(), config.maxVelocity.value() + 1e-3);
+    }
+  }
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "PIDAutotune.h"
+
+#include <units/angle.h>
+#include <units/voltage.h>
+
+#include <cmath>
+
+using namespace wom;
+
+// Three cascaded unit lags, G(s) = 1 / (s + 1)^3. Analytically Ku = 8 and
+// Tu = 2pi / sqrt(3).
+struct ThirdOrderPlant {
+  double x1 = 0, x2 = 0, x3 = 0;
+
+  void Update(double u, double dt) {
+    x1 += (u - x1) * dt;
+    x2 += (x1 - x2) * dt;
+    x3 += (x2 - x3) * dt;
+  }
+};
+
+TEST(PIDAutotune, ThirdOrderLag) {
+  ThirdOrderPlant plant;
+  units::volt_t output{0};
+
+  PIDConfig<units::radian, units::volt> pid{"/test/autotune/pid"};
+  PIDAutotuneConfig<units::radian, units::volt> tuneConfig{0.5_rad, 1_V};
+  tuneConfig.cycles = 3;
+
+  PIDAutotune<units::radian, units::volt> autotune{
+    "/test/autotune", pid, tuneConfig,
+    [&plant]() { return units::radian_t{plant.x3}; },
+    [&output](units::volt_t v) { output = v; }
+  };
+
+  autotune.OnStart();
+  for (int i = 0; i < 100000 && autotune.GetState() == PIDAutotuneState::kRelay; i++) {
+    autotune.OnTick(1_ms);
+    plant.Update(output.value(), 0.001);
+  }
+
+  ASSERT_EQ(autotune.GetState(), PIDAutotuneState::kDone);
+  // The describing function is a first harmonic approximation, so allow some slack
+  EXPECT_NEAR(autotune.GetUltimateGain().value(), 8.0, 1.0);
+  EXPECT_NEAR(autotune.GetUltimatePeriod().value(), 2 * 3.14159 / std::sqrt(3), 0.35);
+
+  EXPECT_NEAR(pid.kp.value(), 0.6 * autotune.GetUltimateGain().value(), 1e-6);
+  EXPECT_GT(pid.ki.value(), 0);
+  EXPECT_GT(pid.kd.value(), 0);
+}
@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+
+#include "RingBuffer.h"
+
+#include <thread>
+
+using namespace wom;
+
+TEST(RingBuffer, Empty) {
+  RingBuffer<int, 4> buf;
+  EXPECT_EQ(buf.Size(), 0);
+  EXPECT_FALSE(buf.Latest().has_value());
+  EXPECT_FALSE(buf.Get(0).has_value());
+}
+
+TEST(RingBuffer, Wraps) {
+  RingBuffer<int, 4> buf;
+  for (int i = 0; i < 6; i++)
+    buf.Push(i);
+
+  EXPECT_EQ(buf.Size(), 4);
+  EXPECT_EQ(buf.Latest().value(), 5);
+  EXPECT_EQ(buf.Get(1).value(), 4);
+  EXPECT_EQ(buf.Get(3).value(), 2);
+  EXPECT_FALSE(buf.Get(4).has_value());
+}
+
+struct Pair {
+  int a, b;
+};
+
+TEST(RingBuffer, ConcurrentReadsAreConsistent) {
+  RingBuffer<Pair, 8> buf;
+  std::atomic<bool> done{false};
+
+  std::thread writer([&]() {
+    for (int i = 0; i < 100000; i++)
+      buf.Push(Pair{i, -i});
+    done = true;
+  });
+
+  int last = -1;
+  while (!done) {
+    auto p = buf.Latest();
+    if (p.has_value()) {
+      ASSERT_EQ(p.value().a, -p.value().b);
+      ASSERT_GE(p.value().a, last);
+      last = p.value().a;
+    }
+  }
+  writer.join();
+}
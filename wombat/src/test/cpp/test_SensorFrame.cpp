@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+
+#include "SensorFrame.h"
+
+using namespace wom;
+
+TEST(SensorFrame, EncoderHoldsSample) {
+  DigitalEncoder encoder{3, 4, 2048};
+  auto sim = encoder.MakeSimEncoder();
+  sim->SetEncoderTurns(12_rad);
+  sim->SetEncoderTurnVelocity(24_rad / 1_s);
+
+  SensorFrame frame;
+  frame.Register(&encoder);
+  frame.Sample();
+
+  EXPECT_TRUE(encoder.IsSampled());
+  EXPECT_EQ(encoder.GetSample().timestamp, frame.GetTimestamp());
+
+  sim->SetEncoderTurns(20_rad);
+  sim->SetEncoderTurnVelocity(0_rad / 1_s);
+
+  // Still reading the sample
+  EXPECT_NEAR(encoder.GetEncoderPosition().value(), 12, 0.01);
+  EXPECT_NEAR(encoder.GetEncoderAngularVelocity().value(), 24, 0.01);
+
+  frame.Sample();
+
+  EXPECT_NEAR(encoder.GetEncoderPosition().value(), 20, 0.01);
+  EXPECT_NEAR(encoder.GetEncoderAngularVelocity().value(), 0, 0.01);
+
+  encoder.ClearSample();
+  sim->SetEncoderTurns(4_rad);
+  EXPECT_NEAR(encoder.GetEncoderPosition().value(), 4, 0.01);
+}
+
+TEST(SensorFrame, GyroHoldsSample) {
+  NavX gyro;
+  auto sim = gyro.MakeSimGyro();
+
+  SensorFrame frame;
+  frame.Register(&gyro);
+
+  sim->SetAngle(90_deg);
+  frame.Sample();
+  EXPECT_NEAR(gyro.GetAngle(), 90, 0.01);
+}
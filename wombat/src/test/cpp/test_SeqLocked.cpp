@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+
+#include "Util.h"
+
+#include <thread>
+
+using namespace wom;
+
+struct Triple {
+  int a, b, c;
+};
+
+TEST(SeqLocked, ReadsLatest) {
+  SeqLocked<Triple> value;
+  EXPECT_EQ(value.Read().a, 0);
+  value.Write(Triple{1, 2, 3});
+  value.Write(Triple{4, 5, 6});
+  EXPECT_EQ(value.Read().b, 5);
+}
+
+TEST(SeqLocked, ConcurrentReadsAreConsistent) {
+  SeqLocked<Triple> value;
+  std::atomic<bool> done{false};
+
+  // Writes back to back, faster than a reader can copy, which is what a double
+  // buffer gets wrong
+  std::thread writer([&]() {
+    for (int i = 0; i < 200000; i++)
+      value.Write(Triple{i, -i, 2 * i});
+    done = true;
+  });
+
+  int last = 0;
+  while (!done) {
+    Triple t = value.Read();
+    ASSERT_EQ(t.a, -t.b);
+    ASSERT_EQ(t.c, 2 * t.a);
+    ASSERT_GE(t.a, last);
+    last = t.a;
+  }
+  writer.join();
+}
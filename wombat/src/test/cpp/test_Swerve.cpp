@@ -154,4 +154,48 @@ using namespace wom;
 
 //     std::this_thread::sleep_for(std::chrono::milliseconds(20));
 //   }
-// }
\ No newline at end of file
+// }
+class FakeVoltageController : public VoltageController {
+ public:
+  void SetVoltage(units::volt_t voltage) override { this->voltage = voltage; }
+  units::volt_t GetVoltage() const override { return voltage; }
+  void SetInverted(bool invert) override { inverted = invert; }
+  bool GetInverted() const override { return inverted; }
+
+  units::volt_t voltage{0};
+  bool inverted = false;
+};
+
+TEST(SwerveModule, IdleStartsFromRest) {
+  FakeVoltageController driveMotor, turnMotor;
+  DigitalEncoder driveEncoder{10, 11, 2048}, turnEncoder{12, 13, 2048};
+  SwerveModuleConfig config{
+    frc::Translation2d{0.5_m, 0.5_m},
+    Gearbox{ &driveMotor, &driveEncoder, DCMotor::Falcon500(1).WithReduction(6.75) },
+    Gearbox{ &turnMotor, &turnEncoder, DCMotor::Falcon500(1).WithReduction(12.8) },
+    0.0445_m
+  };
+  SwerveModule mod{
+    "/test/swerveModule", config,
+    SwerveModule::angle_pid_conf_t{"/test/swerveModule/pid/angle/config"},
+    SwerveModule::velocity_pid_conf_t{"/test/swerveModule/pid/velocity/config"}
+  };
+
+  mod.SetPID(0_deg, 3_mps, 20_ms);
+  mod.SetIdle();
+  mod.OnUpdate(20_ms);
+  EXPECT_EQ(mod.GetSetpoint().speed.value(), 0);
+
+  // Driving again is limited from rest, not from the speed before idling
+  frc::SwerveDriveKinematics<4> kinematics{
+    frc::Translation2d{0.5_m, 0.5_m}, frc::Translation2d{0.5_m, -0.5_m},
+    frc::Translation2d{-0.5_m, 0.5_m}, frc::Translation2d{-0.5_m, -0.5_m}
+  };
+  SwerveSetpointGenerator<4> generator{kinematics, SwerveSetpointConfig{}};
+  frc::SwerveModuleState previous = mod.GetSetpoint();
+  auto states = generator.Generate({previous, previous, previous, previous}, frc::ChassisSpeeds{3_mps, 0_mps, 0_rad_per_s}, 20_ms);
+
+  // 6m/s^2 for 20ms
+  for (auto &state : states)
+    EXPECT_NEAR(state.speed.value(), 0.12, 1e-6);
+}
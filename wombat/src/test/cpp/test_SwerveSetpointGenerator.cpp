@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "drivetrain/SwerveSetpointGenerator.h"
+
+using namespace wom;
+
+class SwerveSetpointGeneratorTest : public ::testing::Test {
+ public:
+  frc::SwerveDriveKinematics<4> kinematics{
+    frc::Translation2d{0.5_m, 0.5_m}, frc::Translation2d{0.5_m, -0.5_m},
+    frc::Translation2d{-0.5_m, 0.5_m}, frc::Translation2d{-0.5_m, -0.5_m}
+  };
+
+  SwerveSetpointGenerator<4> generator{kinematics, SwerveSetpointConfig{}};
+
+  wpi::array<frc::SwerveModuleState, 4> Stopped(units::radian_t angle) {
+    frc::SwerveModuleState state{0_mps, frc::Rotation2d{angle}};
+    return {state, state, state, state};
+  }
+};
+
+TEST_F(SwerveSetpointGeneratorTest, LimitsAcceleration) {
+  auto states = generator.Generate(Stopped(0_deg), frc::ChassisSpeeds{4_mps, 0_mps, 0_rad_per_s}, 20_ms);
+
+  // 6m/s^2 for 20ms
+  for (auto &state : states) {
+    EXPECT_NEAR(state.speed.value(), 0.12, 1e-6);
+    EXPECT_NEAR(state.angle.Degrees().value(), 0, 1e-6);
+  }
+}
+
+TEST_F(SwerveSetpointGeneratorTest, DesaturatesTogether) {
+  auto states = Stopped(0_deg);
+  for (int i = 0; i < 200; i++)
+    states = generator.Generate(states, frc::ChassisSpeeds{4_mps, 0_mps, 4_rad_per_s}, 20_ms);
+
+  units::meters_per_second_t fastest = 0_mps;
+  for (auto &state : states)
+    fastest = units::math::max(fastest, units::math::abs(state.speed));
+  EXPECT_NEAR(fastest.value(), 4.5, 1e-3);
+
+  // Scaling preserves the ratio of rotation to translation
+  auto speeds = kinematics.ToChassisSpeeds(states);
+  EXPECT_NEAR((speeds.omega / speeds.vx).value(), 1.0, 1e-3);
+}
+
+TEST_F(SwerveSetpointGeneratorTest, ReversesRatherThanSteering) {
+  frc::SwerveModuleState forwards{2_mps, frc::Rotation2d{0_deg}};
+  wpi::array<frc::SwerveModuleState, 4> states{forwards, forwards, forwards, forwards};
+
+  // Backwards at the same speed is reachable by driving the wheels in reverse
+  generator.GetConfig().maxAcceleration = 1000_mps_sq;
+  states = generator.Generate(states, frc::ChassisSpeeds{-2_mps, 0_mps, 0_rad_per_s}, 20_ms);
+
+  for (auto &state : states) {
+    EXPECT_NEAR(state.speed.value(), -2, 1e-6);
+    EXPECT_NEAR(state.angle.Degrees().value(), 0, 1e-6);
+  }
+}
+
+TEST_F(SwerveSetpointGeneratorTest, LimitsSteeringRate) {
+  frc::SwerveModuleState forwards{1_mps, frc::Rotation2d{0_deg}};
+  wpi::array<frc::SwerveModuleState, 4> states{forwards, forwards, forwards, forwards};
+
+  generator.GetConfig().maxAcceleration = 1000_mps_sq;
+  states = generator.Generate(states, frc::ChassisSpeeds{0_mps, 1_mps, 0_rad_per_s}, 20_ms);
+
+  // 720deg/s for 20ms
+  for (auto &state : states)
+    EXPECT_LE(std::abs(state.angle.Degrees().value()), 14.4 + 1e-6);
+}